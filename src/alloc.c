@@ -0,0 +1,242 @@
+#define GACHA_ALLOC_IMPLEMENTATION
+#include "alloc.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+// 块头（记录用户请求的字节数，保持 max_align_t 对齐）
+typedef union {
+    size_t size;
+    max_align_t align;
+} AllocHeader;
+
+// 阶段名称
+static const char* phase_names[ALLOC_PHASE_COUNT] = {
+    "其他", "配置加载", "列表加载", "抽卡", "chaos 循环", "字典索引"
+};
+
+// 统计计数（渲染线程也会分配，因此全部使用原子操作）
+static atomic_int current_phase;
+static atomic_llong phase_allocs[ALLOC_PHASE_COUNT];
+static atomic_llong phase_reallocs[ALLOC_PHASE_COUNT];
+static atomic_llong phase_frees[ALLOC_PHASE_COUNT];
+static atomic_llong phase_bytes[ALLOC_PHASE_COUNT];
+static atomic_llong phase_peak[ALLOC_PHASE_COUNT];
+static atomic_llong live_bytes;
+static atomic_llong live_blocks;
+static atomic_llong peak_bytes;
+
+// 提高峰值记录
+static void raise_peak(atomic_llong* peak, long long value) {
+    long long seen = atomic_load_explicit(peak, memory_order_relaxed);
+    while (value > seen &&
+           !atomic_compare_exchange_weak_explicit(peak, &seen, value, memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+}
+
+#ifdef GACHA_TRACK_ALLOC
+// 在用字节数变化后更新全局与当前阶段峰值
+static void note_live(long long delta) {
+    long long live = atomic_fetch_add_explicit(&live_bytes, delta, memory_order_relaxed) + delta;
+    if (delta > 0) {
+        int phase = atomic_load_explicit(&current_phase, memory_order_relaxed);
+        raise_peak(&peak_bytes, live);
+        raise_peak(&phase_peak[phase], live);
+    }
+}
+
+// 记录一次新分配
+static void* track_new(AllocHeader* header, size_t size) {
+    int phase = atomic_load_explicit(&current_phase, memory_order_relaxed);
+
+    header->size = size;
+    atomic_fetch_add_explicit(&phase_allocs[phase], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&phase_bytes[phase], (long long)size, memory_order_relaxed);
+    atomic_fetch_add_explicit(&live_blocks, 1, memory_order_relaxed);
+    note_live((long long)size);
+    return header + 1;
+}
+#endif
+
+// 是否启用统计
+int alloc_tracking_enabled() {
+#ifdef GACHA_TRACK_ALLOC
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+// 切换当前统计阶段
+int alloc_set_phase(int phase) {
+    if (phase < 0 || phase >= ALLOC_PHASE_COUNT) {
+        phase = ALLOC_PHASE_OTHER;
+    }
+
+    int previous = atomic_exchange_explicit(&current_phase, phase, memory_order_relaxed);
+
+    // 阶段峰值从进入时的在用字节数算起
+    raise_peak(&phase_peak[phase], atomic_load_explicit(&live_bytes, memory_order_relaxed));
+    return previous;
+}
+
+// 获取统计
+void alloc_get_stats(AllocPhaseStats* phases, long long* live, long long* blocks,
+                     long long* peak) {
+    if (phases) {
+        for (int i = 0; i < ALLOC_PHASE_COUNT; i++) {
+            phases[i].allocs = atomic_load(&phase_allocs[i]);
+            phases[i].reallocs = atomic_load(&phase_reallocs[i]);
+            phases[i].frees = atomic_load(&phase_frees[i]);
+            phases[i].bytes = atomic_load(&phase_bytes[i]);
+            phases[i].peak_live = atomic_load(&phase_peak[i]);
+        }
+    }
+    if (live) {
+        *live = atomic_load(&live_bytes);
+    }
+    if (blocks) {
+        *blocks = atomic_load(&live_blocks);
+    }
+    if (peak) {
+        *peak = atomic_load(&peak_bytes);
+    }
+}
+
+// 格式化字节数
+static void format_bytes(long long bytes, char* buffer, size_t size) {
+    if (bytes < 1024) {
+        snprintf(buffer, size, "%lld B", bytes);
+    } else if (bytes < 1024LL * 1024) {
+        snprintf(buffer, size, "%.1f KiB", bytes / 1024.0);
+    } else if (bytes < 1024LL * 1024 * 1024) {
+        snprintf(buffer, size, "%.1f MiB", bytes / (1024.0 * 1024.0));
+    } else {
+        snprintf(buffer, size, "%.2f GiB", bytes / (1024.0 * 1024.0 * 1024.0));
+    }
+}
+
+// 输出各阶段统计
+void alloc_report(FILE* fp) {
+    if (!alloc_tracking_enabled()) {
+        fprintf(fp, "未启用内存统计（使用 -DGACHA_TRACK_ALLOC=ON 重新构建）\n");
+        return;
+    }
+
+    AllocPhaseStats phases[ALLOC_PHASE_COUNT];
+    long long live, blocks, peak;
+    char bytes_text[32], peak_text[32];
+
+    alloc_get_stats(phases, &live, &blocks, &peak);
+
+    fprintf(fp, "内存统计：\n");
+    for (int i = 0; i < ALLOC_PHASE_COUNT; i++) {
+        AllocPhaseStats* st = &phases[i];
+        if (st->allocs == 0 && st->reallocs == 0 && st->frees == 0) {
+            continue;
+        }
+        format_bytes(st->bytes, bytes_text, sizeof(bytes_text));
+        format_bytes(st->peak_live, peak_text, sizeof(peak_text));
+        fprintf(fp, "  %s：分配 %lld 次，调整 %lld 次，释放 %lld 次，共 %s，峰值在用 %s\n",
+                phase_names[i], st->allocs, st->reallocs, st->frees, bytes_text, peak_text);
+    }
+
+    format_bytes(peak, peak_text, sizeof(peak_text));
+    format_bytes(live, bytes_text, sizeof(bytes_text));
+    fprintf(fp, "  全程峰值在用 %s，当前在用 %s（%lld 块）\n", peak_text, bytes_text, blocks);
+}
+
+// 带统计的 malloc
+void* alloc_malloc(size_t size) {
+#ifdef GACHA_TRACK_ALLOC
+    if (size > SIZE_MAX - sizeof(AllocHeader)) {
+        return NULL;
+    }
+
+    AllocHeader* header = malloc(sizeof(AllocHeader) + size);
+    if (!header) {
+        return NULL;
+    }
+    return track_new(header, size);
+#else
+    return malloc(size);
+#endif
+}
+
+// 带统计的 calloc
+void* alloc_calloc(size_t count, size_t size) {
+#ifdef GACHA_TRACK_ALLOC
+    if (size != 0 && count > (SIZE_MAX - sizeof(AllocHeader)) / size) {
+        return NULL;
+    }
+
+    AllocHeader* header = calloc(1, sizeof(AllocHeader) + count * size);
+    if (!header) {
+        return NULL;
+    }
+    return track_new(header, count * size);
+#else
+    return calloc(count, size);
+#endif
+}
+
+// 带统计的 realloc
+void* alloc_realloc(void* ptr, size_t size) {
+#ifdef GACHA_TRACK_ALLOC
+    if (!ptr) {
+        return alloc_malloc(size);
+    }
+    if (size > SIZE_MAX - sizeof(AllocHeader)) {
+        return NULL;
+    }
+
+    AllocHeader* header = (AllocHeader*)ptr - 1;
+    size_t old_size = header->size;
+    AllocHeader* resized = realloc(header, sizeof(AllocHeader) + size);
+    if (!resized) {
+        return NULL;
+    }
+
+    int phase = atomic_load_explicit(&current_phase, memory_order_relaxed);
+    resized->size = size;
+    atomic_fetch_add_explicit(&phase_reallocs[phase], 1, memory_order_relaxed);
+    if (size > old_size) {
+        atomic_fetch_add_explicit(&phase_bytes[phase], (long long)(size - old_size),
+                                  memory_order_relaxed);
+    }
+    note_live((long long)size - (long long)old_size);
+    return resized + 1;
+#else
+    return realloc(ptr, size);
+#endif
+}
+
+// 带统计的 strdup
+char* alloc_strdup(const char* str) {
+    size_t length = strlen(str) + 1;
+    char* copy = alloc_malloc(length);
+
+    if (copy) {
+        memcpy(copy, str, length);
+    }
+    return copy;
+}
+
+// 带统计的 free
+void alloc_free(void* ptr) {
+#ifdef GACHA_TRACK_ALLOC
+    if (!ptr) {
+        return;
+    }
+
+    AllocHeader* header = (AllocHeader*)ptr - 1;
+    int phase = atomic_load_explicit(&current_phase, memory_order_relaxed);
+
+    atomic_fetch_add_explicit(&phase_frees[phase], 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&live_blocks, 1, memory_order_relaxed);
+    note_live(-(long long)header->size);
+    free(header);
+#else
+    free(ptr);
+#endif
+}
@@ -0,0 +1,59 @@
+#ifndef GACHA_ALLOC_H
+#define GACHA_ALLOC_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 内存统计阶段
+#define ALLOC_PHASE_OTHER 0        // 启动、估算、历史查询等
+#define ALLOC_PHASE_CONFIG 1       // 加载配置
+#define ALLOC_PHASE_LIST 2         // 加载 gachalist / 字典
+#define ALLOC_PHASE_DRAW 3         // 抽卡
+#define ALLOC_PHASE_CHAOS 4        // chaos 生成循环
+#define ALLOC_PHASE_INDEX 5        // 编译字典匹配器（DFA / Trie 索引构建）
+#define ALLOC_PHASE_COUNT 6
+
+// 单个阶段的统计
+typedef struct {
+    long long allocs;          // 分配次数（malloc / calloc / strdup，realloc 新建也计入）
+    long long reallocs;        // 调整大小次数
+    long long frees;           // 释放次数
+    long long bytes;           // 累计分配字节数（realloc 只计增长部分）
+    long long peak_live;       // 该阶段内的最高在用字节数
+} AllocPhaseStats;
+
+// 核心函数
+
+// 是否以 GACHA_TRACK_ALLOC 构建（未启用时统计函数均为空操作）
+int alloc_tracking_enabled();
+
+// 切换当前统计阶段，返回之前的阶段
+int alloc_set_phase(int phase);
+
+// 获取阶段统计，以及全局在用字节数、在用块数与峰值
+void alloc_get_stats(AllocPhaseStats* phases, long long* live_bytes, long long* live_blocks,
+                     long long* peak_bytes);
+
+// 输出各阶段统计
+void alloc_report(FILE* fp);
+
+// 带统计的分配函数（块前记录大小）
+void* alloc_malloc(size_t size);
+void* alloc_calloc(size_t count, size_t size);
+void* alloc_realloc(void* ptr, size_t size);
+char* alloc_strdup(const char* str);
+void alloc_free(void* ptr);
+
+// 启用统计时，包含本头文件的源文件中的分配调用都经过统计层
+//   （本头文件须在其他头文件之后包含；mmap 映射不计入）
+#if defined(GACHA_TRACK_ALLOC) && !defined(GACHA_ALLOC_IMPLEMENTATION)
+    #define malloc(size) alloc_malloc(size)
+    #define calloc(count, size) alloc_calloc(count, size)
+    #define realloc(ptr, size) alloc_realloc(ptr, size)
+    #define strdup(str) alloc_strdup(str)
+    #define free(ptr) alloc_free(ptr)
+#endif
+
+#endif // GACHA_ALLOC_H
@@ -0,0 +1,178 @@
+#include "alphabet.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+
+// 码点哈希
+static unsigned int code_point_hash(uint32_t code_point) {
+    return (code_point * 2654435761u) ^ (code_point >> 16);
+}
+
+// 解码一个 UTF-8 字符
+int utf8_decode(const char* text, int length, uint32_t* code_point) {
+    if (text == NULL || length <= 0) {
+        return -1;
+    }
+
+    const unsigned char* p = (const unsigned char*)text;
+    uint32_t value;
+    int bytes;
+    uint32_t min;
+
+    if (p[0] < 0x80) {
+        *code_point = p[0];
+        return 1;
+    } else if ((p[0] & 0xE0) == 0xC0) {
+        value = p[0] & 0x1F;
+        bytes = 2;
+        min = 0x80;
+    } else if ((p[0] & 0xF0) == 0xE0) {
+        value = p[0] & 0x0F;
+        bytes = 3;
+        min = 0x800;
+    } else if ((p[0] & 0xF8) == 0xF0) {
+        value = p[0] & 0x07;
+        bytes = 4;
+        min = 0x10000;
+    } else {
+        return -1;
+    }
+
+    if (bytes > length) {
+        return -1;
+    }
+    for (int k = 1; k < bytes; k++) {
+        if ((p[k] & 0xC0) != 0x80) {
+            return -1;
+        }
+        value = (value << 6) | (p[k] & 0x3F);
+    }
+
+    // 拒绝超长编码、代理区与超出 Unicode 范围的码点
+    if (value < min || value > 0x10FFFF || (value >= 0xD800 && value <= 0xDFFF)) {
+        return -1;
+    }
+
+    *code_point = value;
+    return bytes;
+}
+
+// 查找码点的编号
+int alphabet_symbol(const Alphabet* alphabet, uint32_t code_point) {
+    if (alphabet == NULL) {
+        return -1;
+    }
+
+    unsigned int slot = code_point_hash(code_point) & alphabet->table_mask;
+    while (alphabet->table[slot] >= 0) {
+        int symbol = alphabet->table[slot];
+        if (alphabet->code_points[symbol] == code_point) {
+            return symbol;
+        }
+        slot = (slot + 1) & alphabet->table_mask;
+    }
+    return -1;
+}
+
+// 由 UTF-8 字符串创建字母表
+Alphabet* alphabet_create(const char* text) {
+    if (text == NULL) {
+        return NULL;
+    }
+
+    Alphabet* alphabet = (Alphabet*)malloc(sizeof(Alphabet));
+    if (alphabet == NULL) {
+        return NULL;
+    }
+
+    // 哈希表按上限分配，负载因子不超过 1/2
+    unsigned int table_size = ALPHABET_MAX_SIZE * 2;
+    alphabet->size = 0;
+    alphabet->code_points = (uint32_t*)malloc(ALPHABET_MAX_SIZE * sizeof(uint32_t));
+    alphabet->bytes = (char*)calloc(ALPHABET_MAX_SIZE, ALPHABET_MAX_BYTES);
+    alphabet->lengths = (unsigned char*)malloc(ALPHABET_MAX_SIZE);
+    alphabet->table = (int*)malloc(table_size * sizeof(int));
+    alphabet->table_mask = table_size - 1;
+    if (alphabet->code_points == NULL || alphabet->bytes == NULL || alphabet->lengths == NULL ||
+        alphabet->table == NULL) {
+        alphabet_free(alphabet);
+        return NULL;
+    }
+    for (unsigned int i = 0; i < table_size; i++) {
+        alphabet->table[i] = -1;
+    }
+
+    int length = (int)strlen(text);
+    for (int pos = 0; pos < length; ) {
+        uint32_t code_point;
+        int bytes = utf8_decode(text + pos, length - pos, &code_point);
+        if (bytes < 0) {
+            alphabet_free(alphabet);
+            return NULL;
+        }
+
+        // 空白与控制字符不作为字母
+        if (code_point > 0x20 && code_point != 0x7F && code_point != 0x3000 &&
+            alphabet_symbol(alphabet, code_point) < 0) {
+            if (alphabet->size == ALPHABET_MAX_SIZE) {
+                alphabet_free(alphabet);
+                return NULL;
+            }
+
+            int symbol = alphabet->size++;
+            alphabet->code_points[symbol] = code_point;
+            alphabet->lengths[symbol] = (unsigned char)bytes;
+            memcpy(alphabet->bytes + (size_t)symbol * ALPHABET_MAX_BYTES, text + pos, (size_t)bytes);
+
+            unsigned int slot = code_point_hash(code_point) & alphabet->table_mask;
+            while (alphabet->table[slot] >= 0) {
+                slot = (slot + 1) & alphabet->table_mask;
+            }
+            alphabet->table[slot] = symbol;
+        }
+        pos += bytes;
+    }
+
+    if (alphabet->size == 0) {
+        alphabet_free(alphabet);
+        return NULL;
+    }
+    return alphabet;
+}
+
+// 把 UTF-8 文本转换为编号序列
+int alphabet_encode(const Alphabet* alphabet, const char* text, int length, uint16_t* out) {
+    if (alphabet == NULL || text == NULL || out == NULL) {
+        return -1;
+    }
+
+    int count = 0;
+    for (int pos = 0; pos < length; ) {
+        uint32_t code_point;
+        int bytes = utf8_decode(text + pos, length - pos, &code_point);
+        if (bytes < 0) {
+            return -1;
+        }
+        int symbol = alphabet_symbol(alphabet, code_point);
+        if (symbol < 0) {
+            return -1;
+        }
+        out[count++] = (uint16_t)symbol;
+        pos += bytes;
+    }
+    return count;
+}
+
+// 释放字母表
+void alphabet_free(Alphabet* alphabet) {
+    if (alphabet == NULL) {
+        return;
+    }
+
+    free(alphabet->code_points);
+    free(alphabet->bytes);
+    free(alphabet->lengths);
+    free(alphabet->table);
+    free(alphabet);
+}
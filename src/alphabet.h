@@ -0,0 +1,41 @@
+#ifndef GACHA_ALPHABET_H
+#define GACHA_ALPHABET_H
+
+#include <stdint.h>
+
+// 字母表上限（DFA 转移表每个状态一行 × 字母表大小）
+#define ALPHABET_MAX_SIZE 4096
+// 单个字符的 UTF-8 最大字节数
+#define ALPHABET_MAX_BYTES 4
+
+// 自定义字母表（UTF-8 字符按首次出现的顺序编号为 0..size-1）
+//   生成与匹配都只使用编号，只有输出时才用到字符的 UTF-8 编码
+typedef struct {
+    int size;                  // 字符数量
+    uint32_t* code_points;     // 各编号的码点
+    char* bytes;               // 各编号的 UTF-8 编码（每个占 ALPHABET_MAX_BYTES 字节）
+    unsigned char* lengths;    // 各编号的 UTF-8 字节数
+
+    int* table;                // 码点 -> 编号 的哈希表（-1 为空槽）
+    unsigned int table_mask;   // 哈希表大小 - 1
+} Alphabet;
+
+// 核心函数
+
+// 解码一个 UTF-8 字符，返回字节数（无效编码返回 -1）
+int utf8_decode(const char* text, int length, uint32_t* code_point);
+
+// 由 UTF-8 字符串创建字母表（空白忽略，重复字符只保留一次），无效编码或超过上限返回 NULL
+Alphabet* alphabet_create(const char* text);
+
+// 查找码点的编号（不在字母表中返回 -1）
+int alphabet_symbol(const Alphabet* alphabet, uint32_t code_point);
+
+// 把 UTF-8 文本转换为编号序列，返回字符数；含字母表以外的字符或无效编码时返回 -1
+//   out 至少需要 length 个元素
+int alphabet_encode(const Alphabet* alphabet, const char* text, int length, uint16_t* out);
+
+// 释放字母表
+void alphabet_free(Alphabet* alphabet);
+
+#endif // GACHA_ALPHABET_H
@@ -0,0 +1,306 @@
+#include "analyze.h"
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+
+// 集齐期望积分的最少 / 最多二分层数
+#define COLLECTOR_MIN_DEPTH 8
+#define COLLECTOR_MAX_DEPTH 48
+
+// 分位数百分比
+static const double PERCENTILE_LEVELS[ANALYZE_PERCENTILE_COUNT] = {0.5, 0.9, 0.99};
+
+// 分位数 level 对应的百分比
+double analyze_percentile_level(int k) {
+    if (k < 0 || k >= ANALYZE_PERCENTILE_COUNT) {
+        return 0.0;
+    }
+    return PERCENTILE_LEVELS[k];
+}
+
+// 几何分布的分位数
+long long geometric_quantile(double p, double level) {
+    if (p <= 0.0) {
+        return -1;
+    }
+    if (p >= 1.0 || level <= 0.0) {
+        return 1;
+    }
+
+    // P(T <= k) = 1 - (1 - p)^k >= level
+    double k = ceil(log1p(-level) / log1p(-p));
+    if (k < 1.0) {
+        k = 1.0;
+    }
+    // 浮点舍入可能多算一次
+    if (k > 1.0 && -expm1((k - 1.0) * log1p(-p)) >= level) {
+        k -= 1.0;
+    }
+    return k >= (double)LLONG_MAX ? LLONG_MAX : (long long)k;
+}
+
+// 集卡积分参数
+typedef struct {
+    const int* weights;
+    const int* counts;
+    int groups;
+} CollectorSet;
+
+// 被积函数：泊松化后 s 时刻仍有卡未集齐的概率 1 - Π(1 - e^(-w s))^c
+static double collector_missing(const CollectorSet* set, double s) {
+    if (s <= 0.0) {
+        return 1.0;
+    }
+
+    double log_all = 0.0;
+    for (int g = 0; g < set->groups; g++) {
+        log_all += set->counts[g] * log1p(-exp(-set->weights[g] * s));
+    }
+    return -expm1(log_all);
+}
+
+// 自适应 Simpson 积分（被积函数单调递减，先均匀细分到最少层数再按误差二分）
+static double collector_simpson(const CollectorSet* set, double a, double b,
+                                double fa, double fm, double fb, double whole,
+                                double eps, int depth) {
+    double m = (a + b) / 2.0;
+    double lm = (a + m) / 2.0;
+    double rm = (m + b) / 2.0;
+    double flm = collector_missing(set, lm);
+    double frm = collector_missing(set, rm);
+    double left = (m - a) / 6.0 * (fa + 4.0 * flm + fm);
+    double right = (b - m) / 6.0 * (fm + 4.0 * frm + fb);
+    double delta = left + right - whole;
+
+    if (depth >= COLLECTOR_MAX_DEPTH ||
+        (depth >= COLLECTOR_MIN_DEPTH && fabs(delta) <= 15.0 * eps)) {
+        return left + right + delta / 15.0;
+    }
+    return collector_simpson(set, a, m, fa, flm, fm, left, eps / 2.0, depth + 1) +
+           collector_simpson(set, m, b, fm, frm, fb, right, eps / 2.0, depth + 1);
+}
+
+// 集齐期望
+double collector_expectation(const int* weights, const int* counts, int groups, int total) {
+    if (weights == NULL || counts == NULL || groups <= 0 || total <= 0) {
+        return 0.0;
+    }
+
+    // 只有一种概率时为闭式解 H(n) / p
+    if (groups == 1) {
+        double harmonic = 0.0;
+        for (int k = counts[0]; k >= 1; k--) {
+            harmonic += 1.0 / k;
+        }
+        return harmonic * total / weights[0];
+    }
+
+    // 一般情况：E[T] = total · ∫(1 - Π(1 - e^(-w s))^c) ds（泊松化的精确恒等式）
+    //   积分上限取到每组剩余未集齐的概率都低于 e^-40
+    double upper = 0.0;
+    for (int g = 0; g < groups; g++) {
+        double s = (log((double)counts[g]) + 40.0) / weights[g];
+        if (s > upper) {
+            upper = s;
+        }
+    }
+
+    CollectorSet set = {weights, counts, groups};
+    double fa = collector_missing(&set, 0.0);
+    double fm = collector_missing(&set, upper / 2.0);
+    double fb = collector_missing(&set, upper);
+    double whole = upper / 6.0 * (fa + 4.0 * fm + fb);
+    double integral = collector_simpson(&set, 0.0, upper, fa, fm, fb, whole,
+                                        ANALYZE_TOLERANCE * upper, 0);
+    return integral * total;
+}
+
+// 统计一组菜的行数分布（按行数分组，直方图用后清零），返回组数
+static int group_by_rows(const PoolAnalysis* analysis, const GachaList* list, int rank,
+                         int* hist, int* weights, int* counts) {
+    int groups = 0;
+    for (int d = 0; d < analysis->dish_count; d++) {
+        if (rank >= 0 && list->items[analysis->dish_item[d]].rank_index != rank) {
+            continue;
+        }
+        int rows = analysis->dish_rows[d];
+        if (hist[rows]++ == 0) {
+            weights[groups++] = rows;
+        }
+    }
+    for (int g = 0; g < groups; g++) {
+        counts[g] = hist[weights[g]];
+        hist[weights[g]] = 0;
+    }
+    return groups;
+}
+
+// 解析奖池
+PoolAnalysis* analyze_pool(const GachaList* list) {
+    if (list == NULL || list->size <= 0) {
+        return NULL;
+    }
+
+    PoolAnalysis* analysis = (PoolAnalysis*)malloc(sizeof(PoolAnalysis));
+    if (analysis == NULL) {
+        return NULL;
+    }
+    memset(analysis, 0, sizeof(PoolAnalysis));
+    analysis->item_count = list->size;
+
+    // 1. 用 (菜名 id, 等级) 的稠密表合并重复行
+    size_t keys = (size_t)string_pool_size(list->names) * RANK_COUNT;
+    int* dish_of = (int*)malloc((keys > 0 ? keys : 1) * sizeof(int));
+    analysis->dish_item = (int*)malloc((size_t)list->size * sizeof(int));
+    analysis->dish_rows = (int*)malloc((size_t)list->size * sizeof(int));
+    if (dish_of == NULL || analysis->dish_item == NULL || analysis->dish_rows == NULL) {
+        free(dish_of);
+        analyze_free(analysis);
+        return NULL;
+    }
+    for (size_t k = 0; k < keys; k++) {
+        dish_of[k] = -1;
+    }
+
+    for (int i = 0; i < list->size; i++) {
+        const GachaItem* item = &list->items[i];
+        size_t key = (size_t)item->name_id * RANK_COUNT + (size_t)item->rank_index;
+        int dish = dish_of[key];
+        if (dish < 0) {
+            dish = analysis->dish_count++;
+            dish_of[key] = dish;
+            analysis->dish_item[dish] = i;
+            analysis->dish_rows[dish] = 0;
+        }
+        analysis->dish_rows[dish]++;
+        analysis->ranks[item->rank_index].rows++;
+    }
+    free(dish_of);
+
+    // 2. 各等级：概率与首次抽中（几何分布）
+    int max_rows = 0;
+    for (int d = 0; d < analysis->dish_count; d++) {
+        RankAnalysis* rank = &analysis->ranks[list->items[analysis->dish_item[d]].rank_index];
+        int rows = analysis->dish_rows[d];
+        if (rank->dish_count == 0 || rows < rank->min_rows) {
+            rank->min_rows = rows;
+        }
+        if (rows > rank->max_rows) {
+            rank->max_rows = rows;
+        }
+        if (rows > max_rows) {
+            max_rows = rows;
+        }
+        rank->dish_count++;
+    }
+
+    for (int r = 0; r < RANK_COUNT; r++) {
+        RankAnalysis* rank = &analysis->ranks[r];
+        rank->probability = (double)rank->rows / list->size;
+        rank->first_mean = rank->rows > 0 ? 1.0 / rank->probability : 0.0;
+        for (int k = 0; k < ANALYZE_PERCENTILE_COUNT; k++) {
+            rank->first_percentile[k] = rank->rows > 0
+                                            ? geometric_quantile(rank->probability, PERCENTILE_LEVELS[k])
+                                            : -1;
+        }
+    }
+
+    // 3. 集齐期望：按行数分组后求集卡期望（各等级与全部菜）
+    int* hist = (int*)calloc((size_t)max_rows + 1, sizeof(int));
+    int* weights = (int*)malloc((size_t)analysis->dish_count * sizeof(int));
+    int* counts = (int*)malloc((size_t)analysis->dish_count * sizeof(int));
+    if (hist == NULL || weights == NULL || counts == NULL) {
+        free(hist);
+        free(weights);
+        free(counts);
+        analyze_free(analysis);
+        return NULL;
+    }
+
+    for (int r = 0; r < RANK_COUNT; r++) {
+        int groups = group_by_rows(analysis, list, r, hist, weights, counts);
+        analysis->ranks[r].complete_mean = collector_expectation(weights, counts, groups, list->size);
+    }
+    int groups = group_by_rows(analysis, list, -1, hist, weights, counts);
+    analysis->complete_mean = collector_expectation(weights, counts, groups, list->size);
+
+    free(hist);
+    free(weights);
+    free(counts);
+    return analysis;
+}
+
+// 按行数从高到低、序号从小到大排序
+static const int* top_rows = NULL;
+
+static int compare_dish_rows(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    if (top_rows[x] != top_rows[y]) {
+        return top_rows[x] < top_rows[y] ? 1 : -1;
+    }
+    return (x > y) - (x < y);
+}
+
+// 选出单抽概率最高的 top 道菜
+int analyze_top_dishes(const PoolAnalysis* analysis, int top, int* out) {
+    if (analysis == NULL || out == NULL || top <= 0) {
+        return 0;
+    }
+    if (top > analysis->dish_count) {
+        top = analysis->dish_count;
+    }
+
+    // 按行数计数找出第 top 道菜的行数，只对入选的菜排序（不对全部菜排序）
+    int max_rows = 0;
+    for (int d = 0; d < analysis->dish_count; d++) {
+        if (analysis->dish_rows[d] > max_rows) {
+            max_rows = analysis->dish_rows[d];
+        }
+    }
+    int* hist = (int*)calloc((size_t)max_rows + 1, sizeof(int));
+    if (hist == NULL) {
+        return 0;
+    }
+    for (int d = 0; d < analysis->dish_count; d++) {
+        hist[analysis->dish_rows[d]]++;
+    }
+
+    int threshold = max_rows;
+    int above = 0;
+    while (threshold > 0 && above + hist[threshold] < top) {
+        above += hist[threshold];
+        threshold--;
+    }
+    free(hist);
+
+    int n = 0;
+    int ties = top - above;
+    for (int d = 0; d < analysis->dish_count && n < top; d++) {
+        int rows = analysis->dish_rows[d];
+        if (rows > threshold) {
+            out[n++] = d;
+        } else if (rows == threshold && ties > 0) {
+            out[n++] = d;
+            ties--;
+        }
+    }
+
+    top_rows = analysis->dish_rows;
+    qsort(out, (size_t)n, sizeof(int), compare_dish_rows);
+    return n;
+}
+
+// 释放解析结果
+void analyze_free(PoolAnalysis* analysis) {
+    if (analysis == NULL) {
+        return;
+    }
+
+    free(analysis->dish_item);
+    free(analysis->dish_rows);
+    free(analysis);
+}
@@ -0,0 +1,59 @@
+#ifndef GACHA_ANALYZE_H
+#define GACHA_ANALYZE_H
+
+#include "list.h"
+
+// 首次抽中的分位数（50% / 90% / 99%）
+#define ANALYZE_PERCENTILE_COUNT 3
+
+// 默认列出的单抽概率最高的菜数
+#define ANALYZE_TOP_DISHES 10
+
+// 集齐期望的数值积分精度（相对误差）
+#define ANALYZE_TOLERANCE 1e-12
+
+// 单个等级的解析结果
+typedef struct {
+    int rows;                    // 该等级的条目行数
+    int dish_count;              // 不同的菜数（同名同等级的重复行合并）
+    int min_rows;                // 单道菜最少行数
+    int max_rows;                // 单道菜最多行数
+    double probability;          // 单抽抽中该等级的概率
+    double first_mean;           // 首次抽中该等级的期望抽取次数
+    long long first_percentile[ANALYZE_PERCENTILE_COUNT]; // 首次抽中的分位数抽取次数
+    double complete_mean;        // 集齐该等级全部菜的期望抽取次数
+} RankAnalysis;
+
+// 奖池解析结果（每次抽取在全部条目行中等概率选一行）
+typedef struct {
+    int item_count;              // 条目行数
+    int dish_count;              // 不同的菜数
+    RankAnalysis ranks[RANK_COUNT]; // 各等级结果
+    double complete_mean;        // 集齐全部菜的期望抽取次数
+
+    int* dish_item;              // 各菜的代表条目序号（该菜第一次出现的行）
+    int* dish_rows;              // 各菜的行数（单抽概率 = 行数 / 条目行数）
+} PoolAnalysis;
+
+// 核心函数
+
+// 分位数 level 对应的百分比（0.5、0.9、0.99）
+double analyze_percentile_level(int k);
+
+// 几何分布的分位数：单次概率 p 时，首次命中的累计概率达到 level 所需的最少抽取次数
+long long geometric_quantile(double p, double level);
+
+// 集齐期望（不等概率的集卡问题）：
+//   第 g 组有 counts[g] 张卡，每张单抽概率 weights[g] / total，返回集齐全部卡的期望抽取次数
+double collector_expectation(const int* weights, const int* counts, int groups, int total);
+
+// 解析奖池（闭式解与数值积分，不做模拟），失败返回 NULL
+PoolAnalysis* analyze_pool(const GachaList* list);
+
+// 按单抽概率从高到低选出前 top 道菜（概率相同时按首次出现的顺序），返回写入 out 的数量
+int analyze_top_dishes(const PoolAnalysis* analysis, int top, int* out);
+
+// 释放解析结果
+void analyze_free(PoolAnalysis* analysis);
+
+#endif // GACHA_ANALYZE_H
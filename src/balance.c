@@ -0,0 +1,568 @@
+#include "balance.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+    #include <sys/stat.h>
+    #include <windows.h>
+    #define balance_close_fd _close
+#else
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define balance_close_fd close
+#endif
+
+#include "alloc.h"
+
+#define FNV64_OFFSET 14695981039346656037ull
+#define FNV64_PRIME 1099511628211ull
+
+// 等待其他进程写完 id 的最大自旋次数（超过后视为写入中断的槽，跳过）
+#define BALANCE_BUSY_SPINS (1 << 20)
+
+// 获取余额文件路径
+char* get_balance_path() {
+    char* config_path = get_config_path();
+    if (config_path == NULL) {
+        return NULL;
+    }
+
+    char* path = resolve_config_relative_path(config_path, BALANCE_FILE_NAME);
+    free(config_path);
+    return path;
+}
+
+// 检查用户 id 是否有效
+int balance_valid_id(const char* id) {
+    if (id == NULL) {
+        return 0;
+    }
+
+    size_t length = strlen(id);
+    if (length == 0 || length > BALANCE_ID_MAX) {
+        return 0;
+    }
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)id[i];
+        if (c < 0x20 || c == 0x7F) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// 用户 id 的 64 位 FNV-1a 哈希（避开空槽与写入中标记）
+static uint64_t hash_id(const char* id) {
+    uint64_t hash = FNV64_OFFSET;
+    for (const unsigned char* p = (const unsigned char*)id; *p; p++) {
+        hash ^= *p;
+        hash *= FNV64_PRIME;
+    }
+    return hash <= BALANCE_SLOT_BUSY ? hash + 2 : hash;
+}
+
+// 文件锁（共享或独占，阻塞等待）
+static int lock_file(int fd, int exclusive) {
+#ifdef _WIN32
+    OVERLAPPED overlapped;
+    memset(&overlapped, 0, sizeof(overlapped));
+    HANDLE handle = (HANDLE)_get_osfhandle(fd);
+    return LockFileEx(handle, exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, MAXDWORD, MAXDWORD,
+                      &overlapped) ? 0 : -1;
+#else
+    return flock(fd, exclusive ? LOCK_EX : LOCK_SH) == 0 ? 0 : -1;
+#endif
+}
+
+// 释放文件锁
+static void unlock_file(int fd) {
+#ifdef _WIN32
+    OVERLAPPED overlapped;
+    memset(&overlapped, 0, sizeof(overlapped));
+    UnlockFileEx((HANDLE)_get_osfhandle(fd), 0, MAXDWORD, MAXDWORD, &overlapped);
+#else
+    flock(fd, LOCK_UN);
+#endif
+}
+
+// 文件大小
+static long long file_size(int fd) {
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_fstat64(fd, &st) != 0) {
+        return -1;
+    }
+#else
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return -1;
+    }
+#endif
+    return (long long)st.st_size;
+}
+
+// 调整文件大小（新增部分为 0，即空槽）
+static int resize_file(int fd, long long size) {
+#ifdef _WIN32
+    return _chsize_s(fd, size) == 0 ? 0 : -1;
+#else
+    return ftruncate(fd, (off_t)size) == 0 ? 0 : -1;
+#endif
+}
+
+// 以读写方式映射整个文件
+static void* map_file(int fd, size_t size) {
+#ifdef _WIN32
+    HANDLE mapping = CreateFileMappingA((HANDLE)_get_osfhandle(fd), NULL, PAGE_READWRITE, 0, 0, NULL);
+    if (mapping == NULL) {
+        return NULL;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    CloseHandle(mapping);
+    return data;
+#else
+    void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return data == MAP_FAILED ? NULL : data;
+#endif
+}
+
+// 解除映射
+static void unmap_file(void* data, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+// 把映射写回磁盘
+static int sync_file(int fd, void* data, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    return FlushViewOfFile(data, 0) && FlushFileBuffers((HANDLE)_get_osfhandle(fd)) ? 0 : -1;
+#else
+    (void)fd;
+    return msync(data, size, MS_SYNC) == 0 ? 0 : -1;
+#endif
+}
+
+// 打开文件（不存在时创建）
+static int open_file(const char* path) {
+#ifdef _WIN32
+    return _open(path, _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    return open(path, O_RDWR | O_CREAT, 0644);
+#endif
+}
+
+// 写入空表的文件头并扩展到指定容量（调用方持有独占锁或独占文件）
+static int init_file(int fd, uint64_t capacity) {
+    BalanceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BALANCE_MAGIC, 8);
+    header.version = BALANCE_VERSION;
+    header.record_size = (uint32_t)sizeof(BalanceRecord);
+    header.capacity = capacity;
+
+    long long size = (long long)sizeof(BalanceHeader) + (long long)capacity * (long long)sizeof(BalanceRecord);
+    if (resize_file(fd, size) != 0) {
+        return -1;
+    }
+
+    void* data = map_file(fd, sizeof(BalanceHeader));
+    if (data == NULL) {
+        return -1;
+    }
+    memcpy(data, &header, sizeof(header));
+    int result = sync_file(fd, data, sizeof(BalanceHeader));
+    unmap_file(data, sizeof(BalanceHeader));
+    return result;
+}
+
+// 校验文件头与文件大小
+static int check_header(const BalanceHeader* header, long long size) {
+    if (memcmp(header->magic, BALANCE_MAGIC, 8) != 0 || header->version != BALANCE_VERSION ||
+        header->record_size != sizeof(BalanceRecord) || header->capacity == 0 ||
+        (header->capacity & (header->capacity - 1)) != 0) {
+        return -1;
+    }
+    if ((unsigned long long)(size - (long long)sizeof(BalanceHeader)) / sizeof(BalanceRecord) <
+        header->capacity) {
+        return -1;
+    }
+    return 0;
+}
+
+// 路径当前是否指向已打开的文件
+static int path_is_file(const char* path, int fd) {
+#ifdef _WIN32
+    (void)path;
+    (void)fd;
+    return 1;
+#else
+    struct stat by_path;
+    struct stat by_fd;
+    if (stat(path, &by_path) != 0 || fstat(fd, &by_fd) != 0) {
+        return 0;
+    }
+    return by_path.st_dev == by_fd.st_dev && by_path.st_ino == by_fd.st_ino;
+#endif
+}
+
+// 打开并映射文件，持有共享锁；文件已被扩容替换时重新打开
+static int store_attach(BalanceStore* store) {
+    for (;;) {
+        int fd = open_file(store->path);
+        if (fd < 0) {
+            return -1;
+        }
+        if (lock_file(fd, 0) != 0) {
+            balance_close_fd(fd);
+            return -1;
+        }
+
+        long long size = file_size(fd);
+        if (size == 0) {
+            // 新文件：升级为独占锁后再次确认，由一个进程写入文件头
+            unlock_file(fd);
+            if (lock_file(fd, 1) == 0 && file_size(fd) == 0 &&
+                init_file(fd, BALANCE_INITIAL_CAPACITY) != 0) {
+                unlock_file(fd);
+                balance_close_fd(fd);
+                return -1;
+            }
+            unlock_file(fd);
+            balance_close_fd(fd);
+            continue;
+        }
+        if (size < (long long)sizeof(BalanceHeader)) {
+            fprintf(stderr, "错误: %s 不是有效的余额文件\n", store->path);
+            unlock_file(fd);
+            balance_close_fd(fd);
+            return -1;
+        }
+
+        void* data = map_file(fd, (size_t)size);
+        if (data == NULL) {
+            unlock_file(fd);
+            balance_close_fd(fd);
+            return -1;
+        }
+
+        BalanceHeader* header = (BalanceHeader*)data;
+        if (check_header(header, size) != 0) {
+            fprintf(stderr, "错误: %s 不是有效的余额文件\n", store->path);
+            unmap_file(data, (size_t)size);
+            unlock_file(fd);
+            balance_close_fd(fd);
+            return -1;
+        }
+
+        // 扩容的进程在替换文件前标记旧文件，拿到共享锁时已替换完成
+        //   路径仍指向本文件说明扩容在替换前中断，清除标记继续使用
+        if (atomic_load(&header->retired) && !path_is_file(store->path, fd)) {
+            unmap_file(data, (size_t)size);
+            unlock_file(fd);
+            balance_close_fd(fd);
+            continue;
+        }
+
+        if (atomic_load(&header->retired)) {
+            atomic_store(&header->retired, 0);
+        }
+        store->fd = fd;
+        store->map_size = (size_t)size;
+        store->header = header;
+        store->records = (BalanceRecord*)(header + 1);
+        return 0;
+    }
+}
+
+// 解除映射并释放锁
+static void store_detach(BalanceStore* store) {
+    if (store->header != NULL) {
+        unmap_file(store->header, store->map_size);
+        store->header = NULL;
+        store->records = NULL;
+    }
+    if (store->fd >= 0) {
+        unlock_file(store->fd);
+        balance_close_fd(store->fd);
+        store->fd = -1;
+    }
+}
+
+// 开始一次查询或更新：取得共享锁，文件已被扩容替换时重新打开（返回 0 时持有共享锁）
+static int store_enter(BalanceStore* store) {
+    if (store->header == NULL) {
+        return store_attach(store);
+    }
+    if (lock_file(store->fd, 0) != 0) {
+        return -1;
+    }
+    if (!atomic_load(&store->header->retired)) {
+        return 0;
+    }
+
+    // 上次操作之后其他进程扩容了文件（或扩容中断），重新打开
+    store_detach(store);
+    return store_attach(store);
+}
+
+// 结束一次查询或更新：释放共享锁，映射保留到下次操作
+static void store_leave(BalanceStore* store) {
+    if (store->fd >= 0) {
+        unlock_file(store->fd);
+    }
+}
+
+// 打开余额文件
+BalanceStore* balance_open(const char* path) {
+    if (path == NULL) {
+        return NULL;
+    }
+
+    BalanceStore* store = (BalanceStore*)malloc(sizeof(BalanceStore));
+    if (store == NULL) {
+        return NULL;
+    }
+
+    store->path = strdup(path);
+    store->fd = -1;
+    store->map_size = 0;
+    store->header = NULL;
+    store->records = NULL;
+    if (store->path == NULL || store_attach(store) != 0) {
+        free(store->path);
+        free(store);
+        return NULL;
+    }
+
+    // 打开期间不持有锁，等待用户确认时不会挡住其他进程扩容
+    store_leave(store);
+    return store;
+}
+
+// 关闭余额文件
+void balance_close(BalanceStore* store) {
+    if (store == NULL) {
+        return;
+    }
+
+    store_detach(store);
+    free(store->path);
+    free(store);
+}
+
+// 等待正在写入的槽完成，返回槽的哈希值
+static uint64_t wait_slot(BalanceRecord* record) {
+    uint64_t hash = atomic_load_explicit(&record->hash, memory_order_acquire);
+    for (int spin = 0; hash == BALANCE_SLOT_BUSY && spin < BALANCE_BUSY_SPINS; spin++) {
+        hash = atomic_load_explicit(&record->hash, memory_order_acquire);
+    }
+    return hash;
+}
+
+// 查找用户记录；create 时在探测到的第一个空槽插入，表满返回 NULL
+static BalanceRecord* find_record(BalanceStore* store, const char* id, int create) {
+    uint64_t hash = hash_id(id);
+    uint64_t mask = store->header->capacity - 1;
+
+    for (uint64_t probe = 0; probe <= mask; probe++) {
+        BalanceRecord* record = &store->records[(hash + probe) & mask];
+        uint64_t slot = wait_slot(record);
+
+        if (slot == BALANCE_SLOT_EMPTY) {
+            if (!create) {
+                return NULL;
+            }
+
+            // 抢占空槽，写入 id 后发布哈希值；抢占失败说明其他进程同时插入，重新检查此槽
+            uint64_t expected = BALANCE_SLOT_EMPTY;
+            if (atomic_compare_exchange_strong(&record->hash, &expected, BALANCE_SLOT_BUSY)) {
+                memset(record->id, 0, sizeof(record->id));
+                memcpy(record->id, id, strlen(id));
+                atomic_store(&record->balance, 0);
+                atomic_store_explicit(&record->hash, hash, memory_order_release);
+                atomic_fetch_add(&store->header->count, 1);
+                return record;
+            }
+            slot = wait_slot(record);
+        }
+
+        if (slot == hash && strcmp(record->id, id) == 0) {
+            return record;
+        }
+    }
+
+    return NULL;
+}
+
+// 容量翻倍：独占锁下把所有记录重新散列到新文件，标记旧文件后原子替换
+static int store_grow(BalanceStore* store) {
+    // 先放下共享锁再等独占锁（两个进程同时扩容也不会互相等待）
+    unlock_file(store->fd);
+    if (lock_file(store->fd, 1) != 0) {
+        return -1;
+    }
+
+    BalanceHeader* header = store->header;
+    uint64_t capacity = header->capacity;
+    if (atomic_load(&header->retired) || atomic_load(&header->count) + 1 <= capacity / 4 * 3) {
+        // 其他进程已经扩容
+        store_detach(store);
+        return store_attach(store);
+    }
+
+    size_t tmp_length = strlen(store->path) + 5;
+    char* tmp_path = (char*)malloc(tmp_length);
+    if (tmp_path == NULL) {
+        return -1;
+    }
+    snprintf(tmp_path, tmp_length, "%s.tmp", store->path);
+
+    BalanceStore grown;
+    grown.path = tmp_path;
+    grown.fd = open_file(tmp_path);
+    int result = -1;
+    if (grown.fd >= 0 && resize_file(grown.fd, 0) == 0 && init_file(grown.fd, capacity * 2) == 0) {
+        grown.map_size = sizeof(BalanceHeader) + (size_t)(capacity * 2) * sizeof(BalanceRecord);
+        grown.header = (BalanceHeader*)map_file(grown.fd, grown.map_size);
+        if (grown.header != NULL) {
+            grown.records = (BalanceRecord*)(grown.header + 1);
+            result = 0;
+            for (uint64_t i = 0; i < capacity && result == 0; i++) {
+                // 写入中断的槽没有有效 id，不再保留
+                BalanceRecord* old = &store->records[i];
+                if (atomic_load(&old->hash) <= BALANCE_SLOT_BUSY) {
+                    continue;
+                }
+                BalanceRecord* record = find_record(&grown, old->id, 1);
+                if (record == NULL) {
+                    result = -1;
+                } else {
+                    atomic_store(&record->balance, atomic_load(&old->balance));
+                }
+            }
+            if (result == 0) {
+                result = sync_file(grown.fd, grown.header, grown.map_size);
+            }
+            unmap_file(grown.header, grown.map_size);
+        }
+    }
+    if (grown.fd >= 0) {
+        balance_close_fd(grown.fd);
+    }
+
+    if (result == 0) {
+#ifdef _WIN32
+        // Windows 下其他进程打开着的文件无法被替换，替换成功即说明没有其他持有者
+        store_detach(store);
+        result = MoveFileExA(tmp_path, store->path, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+        atomic_store(&header->retired, 1);
+        sync_file(store->fd, store->header, sizeof(BalanceHeader));
+        result = rename(tmp_path, store->path) == 0 ? 0 : -1;
+        if (result != 0) {
+            atomic_store(&header->retired, 0);
+        }
+#endif
+    }
+    if (result != 0) {
+        remove(tmp_path);
+    }
+    free(tmp_path);
+
+    // 重新打开（替换成功时得到新文件）
+    store_detach(store);
+    if (store_attach(store) != 0) {
+        return -1;
+    }
+    return result;
+}
+
+// 查找用户记录，插入前按需扩容
+static BalanceRecord* find_or_create(BalanceStore* store, const char* id) {
+    BalanceRecord* record = find_record(store, id, 0);
+    if (record != NULL) {
+        return record;
+    }
+
+    uint64_t capacity = store->header->capacity;
+    if (atomic_load(&store->header->count) + 1 > capacity / 4 * 3 && store_grow(store) != 0) {
+        return NULL;
+    }
+    return find_record(store, id, 1);
+}
+
+// 查询余额
+long long balance_get(BalanceStore* store, const char* id) {
+    if (store == NULL || !balance_valid_id(id) || store_enter(store) != 0) {
+        return 0;
+    }
+
+    BalanceRecord* record = find_record(store, id, 0);
+    long long balance = record != NULL ? atomic_load(&record->balance) : 0;
+    store_leave(store);
+    return balance;
+}
+
+// 增加余额
+long long balance_credit(BalanceStore* store, const char* id, long long amount) {
+    if (store == NULL || !balance_valid_id(id) || amount < 0 || store_enter(store) != 0) {
+        return -1;
+    }
+
+    BalanceRecord* record = find_or_create(store, id);
+    long long balance = -1;
+    if (record != NULL) {
+        balance = atomic_fetch_add(&record->balance, amount) + amount;
+    }
+    store_leave(store);
+    return balance;
+}
+
+// 原子扣除至多 amount
+long long balance_take(BalanceStore* store, const char* id, long long amount, long long* remaining) {
+    if (remaining != NULL) {
+        *remaining = 0;
+    }
+    if (store == NULL || !balance_valid_id(id) || amount <= 0 || store_enter(store) != 0) {
+        return 0;
+    }
+
+    BalanceRecord* record = find_record(store, id, 0);
+    if (record == NULL) {
+        store_leave(store);
+        return 0;
+    }
+
+    long long current = atomic_load(&record->balance);
+    long long take;
+    do {
+        take = current < amount ? current : amount;
+        if (take <= 0) {
+            break;
+        }
+    } while (!atomic_compare_exchange_weak(&record->balance, &current, current - take));
+    store_leave(store);
+
+    if (take <= 0) {
+        if (remaining != NULL) {
+            *remaining = current;
+        }
+        return 0;
+    }
+    if (remaining != NULL) {
+        *remaining = current - take;
+    }
+    return take;
+}
@@ -0,0 +1,76 @@
+#ifndef GACHA_BALANCE_H
+#define GACHA_BALANCE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// 多用户余额文件（与 gacha.conf 同目录）
+#define BALANCE_FILE_NAME "balances.db"
+
+// 文件头魔数与版本
+#define BALANCE_MAGIC "GACHABAL"
+#define BALANCE_VERSION 1
+
+// 用户 id 最大字节数（不含结尾 0）
+#define BALANCE_ID_MAX 47
+
+// 新建文件的槽数；已用槽数超过 3/4 时容量翻倍
+#define BALANCE_INITIAL_CAPACITY (1 << 12)
+
+// 槽的哈希值：0 表示空槽，1 表示正在写入 id
+#define BALANCE_SLOT_EMPTY 0
+#define BALANCE_SLOT_BUSY 1
+
+// 文件头（64 字节，直接映射到文件）
+typedef struct {
+    char magic[8];             // BALANCE_MAGIC
+    uint32_t version;          // BALANCE_VERSION
+    uint32_t record_size;      // sizeof(BalanceRecord)
+    uint64_t capacity;         // 槽数（2 的幂）
+    atomic_ullong count;       // 已用槽数
+    atomic_uint retired;       // 已被扩容后的新文件替换（持有者须重新打开）
+    uint8_t reserved[28];      // 保留（填 0）
+} BalanceHeader;
+
+// 用户记录（64 字节，开放寻址线性探测）
+//   余额以原子操作增减，多个进程可同时更新不同或相同用户
+typedef struct {
+    atomic_ullong hash;        // 用户 id 的 64 位哈希（见 BALANCE_SLOT_*）
+    atomic_llong balance;      // 余额（历史总匹配次数）
+    char id[BALANCE_ID_MAX + 1]; // 用户 id（0 结尾）
+} BalanceRecord;
+
+// 打开的余额文件
+typedef struct {
+    char* path;                // 文件路径
+    int fd;                    // 文件描述符（每次查询或更新期间持有共享锁，扩容时升级为独占锁）
+    size_t map_size;           // 映射长度
+    BalanceHeader* header;     // 映射的文件头
+    BalanceRecord* records;    // 映射的记录数组
+} BalanceStore;
+
+// 核心函数
+
+// 获取余额文件路径
+char* get_balance_path();
+
+// 检查用户 id 是否有效（1 到 BALANCE_ID_MAX 字节，不含控制字符）
+int balance_valid_id(const char* id);
+
+// 打开余额文件（不存在时创建），失败返回 NULL
+BalanceStore* balance_open(const char* path);
+
+// 关闭余额文件
+void balance_close(BalanceStore* store);
+
+// 查询余额（用户不存在时为 0）
+long long balance_get(BalanceStore* store, const char* id);
+
+// 增加余额（用户不存在时创建），返回增加后的余额，失败返回 -1
+long long balance_credit(BalanceStore* store, const char* id, long long amount);
+
+// 原子扣除至多 amount（余额不足时扣除全部余额），返回实际扣除数，remaining 返回扣除后的余额
+long long balance_take(BalanceStore* store, const char* id, long long amount, long long* remaining);
+
+#endif // GACHA_BALANCE_H
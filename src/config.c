@@ -16,6 +16,11 @@
     #define mkdir_(_path) mkdir(_path, 0755)
 #endif
 
+#include "alloc.h"
+
+// 保存时每行写出的字母表字节数上限（小于解析时的行缓冲区）
+#define ALPHABET_LINE_BYTES 240
+
 // 解析行类型
 typedef enum {
     LINE_TYPE_COMMENT,      // # 注释
@@ -30,7 +35,8 @@ typedef enum {
     SECTION_NONE,
     SECTION_LETTERS_PER_SECOND,
     SECTION_DICTIONARY,
-    SECTION_HISTORY_STATS
+    SECTION_HISTORY_STATS,
+    SECTION_MATCHER
 } SectionType;
 
 // 展开用户目录（处理 ~）
@@ -205,6 +211,64 @@ static char* extract_list_item_content(const char* line) {
     return strdup(line);
 }
 
+// 检查列表项的键是否为 key（精确匹配 "- 键：" 前缀，值中含有同样文字的单词不算）
+static int list_item_has_key(const char* line, const char* key) {
+    if (line == NULL || line[0] != '-') {
+        return 0;
+    }
+
+    // 跳过 '-' 与空格
+    line++;
+    while (*line == ' ' || *line == '\t') {
+        line++;
+    }
+
+    size_t key_length = strlen(key);
+    if (strncmp(line, key, key_length) != 0) {
+        return 0;
+    }
+    return strncmp(line + key_length, "：", strlen("：")) == 0;
+}
+
+// 追加字母表内容（多行字母表依次拼接）
+static void append_alphabet(GachaConfig* config, const char* content) {
+    size_t old_len = config->alphabet != NULL ? strlen(config->alphabet) : 0;
+    size_t add_len = strlen(content);
+    if (add_len == 0) {
+        return;
+    }
+
+    char* alphabet = (char*)realloc(config->alphabet, old_len + add_len + 1);
+    if (alphabet == NULL) {
+        return;
+    }
+    memcpy(alphabet + old_len, content, add_len + 1);
+    config->alphabet = alphabet;
+}
+
+// 写出字母表（按 UTF-8 字符边界分成多行，避免超过解析时的行缓冲区）
+static void write_alphabet(FILE* fp, const char* alphabet) {
+    const char* p = alphabet;
+    size_t left = strlen(alphabet);
+
+    while (left > 0) {
+        size_t chunk = left;
+        if (chunk > ALPHABET_LINE_BYTES) {
+            chunk = ALPHABET_LINE_BYTES;
+            // 后退到字符首字节
+            while (chunk > 0 && ((unsigned char)p[chunk] & 0xC0) == 0x80) {
+                chunk--;
+            }
+            if (chunk == 0) {
+                chunk = ALPHABET_LINE_BYTES;
+            }
+        }
+        fprintf(fp, "- 字母表：%.*s\n", (int)chunk, p);
+        p += chunk;
+        left -= chunk;
+    }
+}
+
 // 解析配置文件
 GachaConfig* parse_config(const char* path) {
     if (path == NULL) {
@@ -227,6 +291,10 @@ GachaConfig* parse_config(const char* path) {
     config->dictionary = NULL;
     config->dictionary_size = 0;
     config->history_total_count = DEFAULT_HISTORY_TOTAL_COUNT;
+    config->dictionary_file = NULL;
+    config->dictionary_ignore_case = 0;
+    config->matcher_buffer_size = DEFAULT_MATCHER_BUFFER_SIZE;
+    config->alphabet = NULL;
 
     // 预分配字典数组
     int dict_capacity = 10;
@@ -254,6 +322,8 @@ GachaConfig* parse_config(const char* path) {
                     current_section = SECTION_DICTIONARY;
                 } else if (strstr(line, "历史统计")) {
                     current_section = SECTION_HISTORY_STATS;
+                } else if (strstr(line, "匹配缓冲区")) {
+                    current_section = SECTION_MATCHER;
                 } else {
                     current_section = SECTION_NONE;
                 }
@@ -267,13 +337,35 @@ GachaConfig* parse_config(const char* path) {
 
                 switch (current_section) {
                     case SECTION_LETTERS_PER_SECOND:
+                        // 自定义字母表（- 字母表：字符…，可分多行书写）
+                        if (list_item_has_key(line, "字母表")) {
+                            append_alphabet(config, content);
+                            break;
+                        }
+
                         config->letters_per_second = atoi(content);
-                        if (config->letters_per_second < 1 || config->letters_per_second > 60) {
+                        if (config->letters_per_second < 1 || config->letters_per_second > MAX_LETTERS_PER_SECOND) {
                             config->letters_per_second = DEFAULT_LETTERS_PER_SECOND;
                         }
                         break;
 
                     case SECTION_DICTIONARY:
+                        // 外部字典文件（- 字典文件：路径）
+                        if (list_item_has_key(line, "字典文件")) {
+                            free(config->dictionary_file);
+                            config->dictionary_file = content;
+                            content = NULL; // 已转移所有权
+                            break;
+                        }
+
+                        // 忽略大小写（- 忽略大小写：是）
+                        if (list_item_has_key(line, "忽略大小写")) {
+                            config->dictionary_ignore_case = strcmp(content, "是") == 0 ||
+                                                             strcmp(content, "true") == 0 ||
+                                                             strcmp(content, "1") == 0;
+                            break;
+                        }
+
                         // 扩展字典数组
                         if (config->dictionary_size >= dict_capacity) {
                             dict_capacity *= 2;
@@ -296,6 +388,14 @@ GachaConfig* parse_config(const char* path) {
                         }
                         break;
 
+                    case SECTION_MATCHER:
+                        config->matcher_buffer_size = atoi(content);
+                        if (config->matcher_buffer_size < 0 ||
+                            config->matcher_buffer_size > MAX_MATCHER_BUFFER_SIZE) {
+                            config->matcher_buffer_size = DEFAULT_MATCHER_BUFFER_SIZE;
+                        }
+                        break;
+
                     default:
                         break;
                 }
@@ -324,6 +424,10 @@ GachaConfig* get_default_config() {
 
     config->letters_per_second = DEFAULT_LETTERS_PER_SECOND;
     config->history_total_count = DEFAULT_HISTORY_TOTAL_COUNT;
+    config->dictionary_file = NULL;
+    config->dictionary_ignore_case = 0;
+    config->matcher_buffer_size = DEFAULT_MATCHER_BUFFER_SIZE;
+    config->alphabet = NULL;
 
     // 创建默认字典
     config->dictionary_size = DEFAULT_DICTIONARY_SIZE;
@@ -354,8 +458,17 @@ int save_config(const char* path, GachaConfig* config) {
     fprintf(fp, "\n");
     fprintf(fp, "## 字母生成速度\n");
     fprintf(fp, "- 每秒生成字母数：%d\n", config->letters_per_second);
+    if (config->alphabet != NULL) {
+        write_alphabet(fp, config->alphabet);
+    }
     fprintf(fp, "\n");
     fprintf(fp, "## 字典列表\n");
+    if (config->dictionary_file != NULL) {
+        fprintf(fp, "- 字典文件：%s\n", config->dictionary_file);
+    }
+    if (config->dictionary_ignore_case) {
+        fprintf(fp, "- 忽略大小写：是\n");
+    }
     for (int i = 0; i < config->dictionary_size; i++) {
         fprintf(fp, "- %s\n", config->dictionary[i]);
     }
@@ -363,6 +476,13 @@ int save_config(const char* path, GachaConfig* config) {
     fprintf(fp, "## 历史统计\n");
     fprintf(fp, "- 历史总匹配次数：%d\n", config->history_total_count);
 
+    // 仅在用户指定时写回匹配缓冲区设置
+    if (config->matcher_buffer_size > 0) {
+        fprintf(fp, "\n");
+        fprintf(fp, "## 匹配缓冲区\n");
+        fprintf(fp, "- 缓冲区大小：%d\n", config->matcher_buffer_size);
+    }
+
     fclose(fp);
     return 0;
 }
@@ -382,5 +502,59 @@ void free_config(GachaConfig* config) {
         free(config->dictionary);
     }
 
+    if (config->dictionary_file != NULL) {
+        free(config->dictionary_file);
+    }
+
+    free(config->alphabet);
     free(config);
 }
+
+// 解析相对于配置文件目录的路径
+char* resolve_config_relative_path(const char* config_path, const char* path) {
+    if (path == NULL) {
+        return NULL;
+    }
+
+    // ~ 开头展开为用户目录
+    if (path[0] == '~') {
+        return expand_home(path);
+    }
+
+    // 绝对路径直接复制
+#ifdef _WIN32
+    if (path[0] == '\\' || path[0] == '/' || (path[0] != '\0' && path[1] == ':')) {
+        return strdup(path);
+    }
+#else
+    if (path[0] == '/') {
+        return strdup(path);
+    }
+#endif
+
+    if (config_path == NULL) {
+        return strdup(path);
+    }
+
+    // 相对路径：拼接到配置文件所在目录
+    const char* slash = strrchr(config_path, '/');
+#ifdef _WIN32
+    const char* backslash = strrchr(config_path, '\\');
+    if (backslash != NULL && (slash == NULL || backslash > slash)) {
+        slash = backslash;
+    }
+#endif
+    if (slash == NULL) {
+        return strdup(path);
+    }
+
+    size_t dir_len = (size_t)(slash - config_path) + 1;
+    char* resolved = malloc(dir_len + strlen(path) + 1);
+    if (resolved == NULL) {
+        return NULL;
+    }
+    memcpy(resolved, config_path, dir_len);
+    strcpy(resolved + dir_len, path);
+
+    return resolved;
+}
@@ -11,12 +11,19 @@ typedef struct {
     char** dictionary;          // 字典单词数组
     int dictionary_size;        // 字典单词数量
     int history_total_count;    // 历史总匹配次数
+    char* dictionary_file;      // 外部字典文件路径（可选，每行一个单词）
+    int dictionary_ignore_case; // 字典模式是否忽略大小写
+    int matcher_buffer_size;    // 匹配缓冲区大小（0 表示自动）
+    char* alphabet;             // 自定义字母表（UTF-8，NULL 表示 a-z A-Z）
 } GachaConfig;
 
 // 默认配置宏
 #define DEFAULT_LETTERS_PER_SECOND 2
+#define MAX_LETTERS_PER_SECOND 1000000
 #define DEFAULT_DICTIONARY_SIZE 2
 #define DEFAULT_HISTORY_TOTAL_COUNT 0
+#define DEFAULT_MATCHER_BUFFER_SIZE 0
+#define MAX_MATCHER_BUFFER_SIZE (1 << 20)
 
 // 核心函数
 
@@ -41,4 +48,7 @@ int save_config(const char* path, GachaConfig* config);
 // 释放配置内存
 void free_config(GachaConfig* config);
 
+// 解析相对于配置文件目录的路径（支持 ~ 和绝对路径）
+char* resolve_config_relative_path(const char* config_path, const char* path);
+
 #endif // GACHA_CONFIG_H
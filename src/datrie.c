@@ -0,0 +1,731 @@
+#include "datrie.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <process.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "alloc.h"
+
+// 空闲槽作为首个子节点位置失败这么多次后移出链表（仍可放置非首个子节点），避免反复扫描难以利用的空洞
+#define DATRIE_MAX_TRIES 16
+
+// 构建器：空闲槽按位置顺序串成双向链表，查找 base 时只访问空闲槽；
+//   链表借用空闲单元的字段（base 为下一个、fail 为上一个空闲槽，word 为查找失败次数，check 保持 0）
+typedef struct {
+    int32_t* base;             // 子节点偏移
+    int32_t* fail;             // 失败链接
+    int32_t* word;             // 输出单词序号（没有输出时为 -1）
+    uint8_t* check;            // 到达此状态的编码（0 表示空闲）
+    unsigned char* base_used;  // 各 base 是否已被内部状态使用（位图）
+    int free_head;             // 第一个空闲槽（-1 表示没有）
+    int free_tail;             // 最后一个空闲槽
+    size_t capacity;           // 已分配单元数
+    int max_base;              // 已用的最大 base
+} Builder;
+
+// 数据区布局：base、fail、输出位图、单词序号、check 依次存放
+typedef struct {
+    size_t fail;               // fail 的偏移（base 在开头）
+    size_t terminals;          // 输出位图的偏移
+    size_t words;              // 单词序号的偏移
+    size_t check;              // check 的偏移
+    size_t size;               // 总字节数
+} BodyLayout;
+
+static BodyLayout body_layout(size_t unit_count, size_t terminal_count) {
+    BodyLayout layout;
+    layout.fail = unit_count * sizeof(int32_t);
+    layout.terminals = layout.fail + unit_count * sizeof(int32_t);
+    layout.words = layout.terminals + (unit_count + 31) / 32 * sizeof(DatrieTerminals);
+    layout.check = layout.words + terminal_count * sizeof(int32_t);
+    layout.size = layout.check + unit_count * sizeof(uint8_t);
+    return layout;
+}
+
+// 数据区字节数
+size_t datrie_body_size(size_t unit_count, size_t terminal_count) {
+    return body_layout(unit_count, terminal_count).size;
+}
+
+// 按 unit_count 与 terminal_count 设置各数组在数据区中的位置
+static void attach_body(Datrie* trie, const void* body) {
+    BodyLayout layout = body_layout((size_t)trie->unit_count, (size_t)trie->terminal_count);
+    const char* p = (const char*)body;
+    trie->base = (const int32_t*)p;
+    trie->fail = (const int32_t*)(p + layout.fail);
+    trie->terminals = (const DatrieTerminals*)(p + layout.terminals);
+    trie->words = (const int32_t*)(p + layout.words);
+    trie->check = (const uint8_t*)(p + layout.check);
+}
+
+// 字典内容指纹
+uint64_t datrie_fingerprint(const DictWord* words, int count, int max_length) {
+    int32_t params[2] = { count, max_length };
+    uint64_t hash = dictionary_hash(DICTIONARY_HASH_SEED, params, sizeof(params));
+    for (int i = 0; words != NULL && i < count; i++) {
+        int32_t length = words[i].length;
+        hash = dictionary_hash(hash, &length, sizeof(length));
+        hash = dictionary_hash(hash, words[i].text, (size_t)words[i].length);
+    }
+    return hash != 0 ? hash : 1;
+}
+
+// 按字节序排序单词（前缀在前，相同单词序号小者在前）
+static const DictWord* sort_words = NULL;
+
+static int compare_words(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    const DictWord* wx = &sort_words[x];
+    const DictWord* wy = &sort_words[y];
+    int length = wx->length < wy->length ? wx->length : wy->length;
+    int cmp = memcmp(wx->text, wy->text, (size_t)length);
+    if (cmp != 0) {
+        return cmp;
+    }
+    if (wx->length != wy->length) {
+        return wx->length - wy->length;
+    }
+    return x - y;
+}
+
+// 确保单元数组至少有 need 个单元（按 1/8 增长，新单元为空闲，接到空闲链表末尾）
+//   初始容量已按状态数预留，之后只差放置产生的空洞，小步增长避免末尾留下大量未用单元
+static int reserve_units(Builder* b, size_t need) {
+    if (need <= b->capacity) {
+        return 0;
+    }
+    if (need > (size_t)INT_MAX) {
+        return -1;
+    }
+
+    size_t capacity = b->capacity + b->capacity / 8;
+    if (capacity < need) {
+        capacity = need;
+    }
+    if (capacity > (size_t)INT_MAX) {
+        capacity = (size_t)INT_MAX;
+    }
+
+    int32_t* base = (int32_t*)realloc(b->base, capacity * sizeof(int32_t));
+    if (base != NULL) {
+        b->base = base;
+    }
+    int32_t* fail = (int32_t*)realloc(b->fail, capacity * sizeof(int32_t));
+    if (fail != NULL) {
+        b->fail = fail;
+    }
+    int32_t* word = (int32_t*)realloc(b->word, capacity * sizeof(int32_t));
+    if (word != NULL) {
+        b->word = word;
+    }
+    uint8_t* check = (uint8_t*)realloc(b->check, capacity);
+    if (check != NULL) {
+        b->check = check;
+    }
+    size_t old_bytes = (b->capacity + 7) / 8;
+    size_t bytes = (capacity + 7) / 8;
+    unsigned char* base_used = (unsigned char*)realloc(b->base_used, bytes);
+    if (base_used != NULL) {
+        b->base_used = base_used;
+    }
+    if (base == NULL || fail == NULL || word == NULL || check == NULL || base_used == NULL) {
+        return -1;
+    }
+    memset(base_used + old_bytes, 0, bytes - old_bytes);
+
+    // 槽 0 为根；槽 1 ~ 255 保持空闲，叶子（base 为 0）的任何转移都落在这里而失败
+    for (size_t i = b->capacity; i < capacity; i++) {
+        base[i] = -1;
+        fail[i] = -1;
+        word[i] = 0;
+        check[i] = 0;
+        if (i < DATRIE_CODES) {
+            continue;
+        }
+        fail[i] = b->free_tail;
+        if (b->free_tail >= 0) {
+            base[b->free_tail] = (int)i;
+        } else {
+            b->free_head = (int)i;
+        }
+        b->free_tail = (int)i;
+    }
+    b->capacity = capacity;
+    return 0;
+}
+
+// 释放构建器的数组
+static void builder_free(Builder* b) {
+    free(b->base);
+    free(b->fail);
+    free(b->word);
+    free(b->check);
+    free(b->base_used);
+}
+
+// 把槽移出空闲链表
+static void unlink_unit(Builder* b, int t) {
+    int next = b->base[t];
+    int prev = b->fail[t];
+    if (prev >= 0) {
+        b->base[prev] = next;
+    } else {
+        b->free_head = next;
+    }
+    if (next >= 0) {
+        b->fail[next] = prev;
+    } else {
+        b->free_tail = prev;
+    }
+    b->base[t] = -1;
+    b->fail[t] = -1;
+}
+
+// 占用空闲槽
+static void take_unit(Builder* b, int t, int code) {
+    if (b->word[t] <= DATRIE_MAX_TRIES) {
+        unlink_unit(b, t);
+    }
+    b->base[t] = 0;
+    b->fail[t] = 0;
+    b->word[t] = -1;
+    b->check[t] = (uint8_t)code;
+}
+
+// 为一组子节点编码找到未用过的 base（所有 base + code 均空闲），失败返回 -1
+static int find_base(Builder* b, const int* codes, int count) {
+    int slot = b->free_head;
+    for (;;) {
+        // 空闲槽用完时扩容（新槽接到链表末尾）
+        if (slot < 0) {
+            int tail = b->free_tail;
+            if (reserve_units(b, b->capacity + 1) != 0) {
+                return -1;
+            }
+            slot = tail >= 0 ? b->base[tail] : b->free_head;
+            continue;
+        }
+
+        // 首个子节点之外的位置都在 slot 之后（不小于 DATRIE_CODES），编码为 0 即空闲
+        int base = slot - codes[0];
+        if (base >= 1 && !(b->base_used[base >> 3] & (1u << (base & 7)))) {
+            if (reserve_units(b, (size_t)base + DATRIE_CODES) != 0) {
+                return -1;
+            }
+            int fits = 1;
+            for (int k = 1; k < count && fits; k++) {
+                fits = b->check[base + codes[k]] == 0;
+            }
+            if (fits) {
+                return base;
+            }
+        }
+
+        int next = b->base[slot];
+        b->word[slot]++;
+        if (b->word[slot] > DATRIE_MAX_TRIES) {
+            unlink_unit(b, slot);
+        }
+        slot = next;
+    }
+}
+
+// 状态 s 经编码 code 的转移（构建时已放置的状态），不存在返回 -1
+static int child_of(const Builder* b, int s, int code) {
+    int t = b->base[s] + code;
+    return b->base[s] > 0 && (int)b->check[t] == code ? t : -1;
+}
+
+// 构建 Trie
+Datrie* datrie_build(const DictWord* words, int count, int max_length) {
+    if (words == NULL || count <= 0) {
+        return NULL;
+    }
+
+    Datrie* trie = (Datrie*)malloc(sizeof(Datrie));
+    int* sorted = (int*)malloc((size_t)count * sizeof(int));
+    if (trie == NULL || sorted == NULL) {
+        free(trie);
+        free(sorted);
+        return NULL;
+    }
+
+    // 1. 收集长度合适的单词并排序去重，为出现的字节编码
+    int n = 0;
+    unsigned char present[DATRIE_CODES] = {0};
+    for (int i = 0; i < count; i++) {
+        if (words[i].length > 0 && words[i].length <= max_length) {
+            sorted[n++] = i;
+            for (int k = 0; k < words[i].length; k++) {
+                present[(unsigned char)words[i].text[k]] = 1;
+            }
+        }
+    }
+    int code_count = 0;
+    for (int c = 0; c < DATRIE_CODES; c++) {
+        trie->codes[c] = 0;
+        if (present[c]) {
+            // 256 种字节都出现时（单词含换行）无法编码
+            if (code_count == DATRIE_CODES - 1) {
+                free(trie);
+                free(sorted);
+                return NULL;
+            }
+            trie->codes[c] = (uint8_t)++code_count;
+        }
+    }
+
+    sort_words = words;
+    qsort(sorted, (size_t)n, sizeof(int), compare_words);
+    sort_words = NULL;
+
+    // 去重，同时记录与前一个单词的公共前缀长度；状态数 = 根 + 各单词不与前一个单词共享的字节数
+    int* lcp = (int*)malloc((size_t)(n > 0 ? n : 1) * sizeof(int));
+    if (lcp == NULL) {
+        free(trie);
+        free(sorted);
+        return NULL;
+    }
+    int unique = 0;
+    size_t state_count = 1;
+    for (int i = 0; i < n; i++) {
+        const DictWord* w = &words[sorted[i]];
+        int common = 0;
+        if (unique > 0) {
+            const DictWord* prev = &words[sorted[unique - 1]];
+            int limit = prev->length < w->length ? prev->length : w->length;
+            while (common < limit && prev->text[common] == w->text[common]) {
+                common++;
+            }
+            if (common == prev->length && common == w->length) {
+                continue;
+            }
+        }
+        lcp[unique] = common;
+        sorted[unique++] = sorted[i];
+        state_count += (size_t)(w->length - common);
+    }
+
+    // 2. 按层放置状态（广度优先），放置子节点时计算失败链接：失败链上的状态都更浅，它们的子节点已经放置。
+    //    sorted 只保留长度不小于当前深度的单词，深度为 depth 的第 k 个状态对应其中
+    //    第 k 段公共前缀不短于 depth 的单词；每层只需当前层与下一层的状态编号，不需要队列
+    Builder b = { NULL, NULL, NULL, NULL, NULL, -1, -1, 0, 0 };
+    int width = unique > 0 ? unique : 1;
+    int* level = (int*)malloc((size_t)width * sizeof(int));
+    int* next_level = (int*)malloc((size_t)width * sizeof(int));
+    if (level == NULL || next_level == NULL ||
+        reserve_units(&b, state_count + state_count / 8 + 2 * DATRIE_CODES) != 0) {
+        free(level);
+        free(next_level);
+        free(lcp);
+        free(sorted);
+        builder_free(&b);
+        free(trie);
+        return NULL;
+    }
+    b.base[0] = 0;
+    b.fail[0] = 0;
+    b.word[0] = -1;
+    b.check[0] = 0;
+    level[0] = 0;
+    int level_size = unique > 0 ? 1 : 0;
+    int active = unique;
+
+    int codes[DATRIE_CODES];
+    int starts[DATRIE_CODES + 1];
+    int failed = 0;
+    for (int depth = 0; level_size > 0 && !failed; depth++) {
+        int next_size = 0;
+        int hi = 0;
+        for (int node = 0; node < level_size && !failed; node++) {
+            int state = level[node];
+            int lo = hi;
+            hi = lo + 1;
+            while (hi < active && lcp[hi] >= depth) {
+                hi++;
+            }
+
+            // 恰好在此结束的单词已记入状态，其余按下一个字节分组
+            int first = lo;
+            if (first < hi && words[sorted[first]].length == depth) {
+                first++;
+            }
+            int child_count = 0;
+            for (int i = first; i < hi; i++) {
+                int code = trie->codes[(unsigned char)words[sorted[i]].text[depth]];
+                if (child_count == 0 || codes[child_count - 1] != code) {
+                    codes[child_count] = code;
+                    starts[child_count] = i;
+                    child_count++;
+                }
+            }
+            starts[child_count] = hi;
+            if (child_count == 0) {
+                continue;
+            }
+
+            int base = find_base(&b, codes, child_count);
+            if (base < 0) {
+                failed = 1;
+                break;
+            }
+            if (base > b.max_base) {
+                b.max_base = base;
+            }
+            b.base_used[base >> 3] |= (unsigned char)(1u << (base & 7));
+            b.base[state] = base;
+            for (int k = 0; k < child_count; k++) {
+                take_unit(&b, base + codes[k], codes[k]);
+            }
+
+            for (int k = 0; k < child_count; k++) {
+                int t = base + codes[k];
+
+                // 失败链接：沿父状态的失败链找第一个有同一转移的状态
+                int fail = 0;
+                if (state != 0) {
+                    int f = b.fail[state];
+                    for (;;) {
+                        int next = child_of(&b, f, codes[k]);
+                        if (next >= 0) {
+                            fail = next;
+                            break;
+                        }
+                        if (f == 0) {
+                            break;
+                        }
+                        f = b.fail[f];
+                    }
+                }
+                b.fail[t] = fail;
+
+                // 输出：自身单词与失败状态输出中字典序号较小者
+                int word = words[sorted[starts[k]]].length == depth + 1 ? sorted[starts[k]] : -1;
+                int inherited = b.word[fail];
+                if (word < 0 || (inherited >= 0 && inherited < word)) {
+                    word = inherited;
+                }
+                b.word[t] = word;
+
+                next_level[next_size++] = t;
+            }
+        }
+
+        // 去掉在此深度结束的单词；被去掉单词两侧的公共前缀取较小者
+        int kept = 0;
+        int carry = INT_MAX;
+        for (int i = 0; i < active; i++) {
+            int common = lcp[i] < carry ? lcp[i] : carry;
+            if (words[sorted[i]].length == depth) {
+                carry = common;
+                continue;
+            }
+            sorted[kept] = sorted[i];
+            lcp[kept] = common;
+            kept++;
+            carry = INT_MAX;
+        }
+        active = kept;
+
+        int* swap = level;
+        level = next_level;
+        next_level = swap;
+        level_size = next_size;
+    }
+    free(level);
+    free(next_level);
+    free(lcp);
+    free(sorted);
+    free(b.base_used);
+    b.base_used = NULL;
+
+    if (failed) {
+        builder_free(&b);
+        free(trie);
+        return NULL;
+    }
+
+    // 3. 截掉末尾未用的单元（保留 max_base + DATRIE_CODES，转移无需越界检查），清除空闲单元中的链表
+    size_t used = (size_t)b.max_base + DATRIE_CODES;
+    size_t terminal_count = 0;
+    for (size_t i = 1; i < used; i++) {
+        if (b.check[i] == 0) {
+            b.base[i] = 0;
+            b.fail[i] = 0;
+            b.word[i] = -1;
+        }
+        terminal_count += b.word[i] >= 0;
+    }
+
+    // 4. 合并为数据区：数据区以 base 开头，就地扩展 base 后依次复制其余数组并释放，
+    //    峰值不含两份完整的单元；有输出的状态记入位图，单词序号按状态顺序紧凑存放
+    BodyLayout layout = body_layout(used, terminal_count);
+    char* body = (char*)realloc(b.base, layout.size);
+    if (body == NULL) {
+        builder_free(&b);
+        free(trie);
+        return NULL;
+    }
+    b.base = NULL;
+    memcpy(body + layout.fail, b.fail, used * sizeof(int32_t));
+    free(b.fail);
+    b.fail = NULL;
+    memcpy(body + layout.check, b.check, used);
+    free(b.check);
+    b.check = NULL;
+
+    DatrieTerminals* terminals = (DatrieTerminals*)(body + layout.terminals);
+    int32_t* outputs = (int32_t*)(body + layout.words);
+    uint32_t rank = 0;
+    for (size_t group = 0; group < (used + 31) / 32; group++) {
+        terminals[group].bits = 0;
+        terminals[group].rank = rank;
+        for (size_t i = group * 32; i < used && i < group * 32 + 32; i++) {
+            if (b.word[i] >= 0) {
+                terminals[group].bits |= 1u << (i & 31);
+                outputs[rank++] = b.word[i];
+            }
+        }
+    }
+    free(b.word);
+
+    trie->owned = body;
+    trie->unit_count = (int)used;
+    trie->terminal_count = (int)terminal_count;
+    trie->word_count = unique;
+    trie->mapped = NULL;
+    trie->mapped_size = 0;
+    attach_body(trie, body);
+    return trie;
+}
+
+// 检查文件头（size 为整个文件长度）
+static int header_valid(const DatrieHeader* header, size_t size, uint64_t fingerprint, uint64_t source) {
+    return memcmp(header->magic, DATRIE_MAGIC, 8) == 0 &&
+           header->version == DATRIE_VERSION &&
+           ((fingerprint != 0 && header->fingerprint == fingerprint) ||
+            (source != 0 && header->source == source)) &&
+           header->unit_count >= DATRIE_CODES && header->unit_count <= (uint32_t)INT_MAX &&
+           header->terminal_count <= header->unit_count &&
+           size == sizeof(DatrieHeader) + datrie_body_size(header->unit_count, header->terminal_count);
+}
+
+// 映射索引文件
+Datrie* datrie_open(const char* path, uint64_t fingerprint, uint64_t source) {
+    if (path == NULL) {
+        return NULL;
+    }
+
+    Datrie* trie = (Datrie*)malloc(sizeof(Datrie));
+    if (trie == NULL) {
+        return NULL;
+    }
+    trie->owned = NULL;
+    trie->mapped = NULL;
+    trie->mapped_size = 0;
+
+#ifdef _WIN32
+    // Windows 下直接读入内存
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) {
+        free(trie);
+        return NULL;
+    }
+
+    DatrieHeader header;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size < (long)sizeof(DatrieHeader) || fread(&header, sizeof(header), 1, fp) != 1 ||
+        !header_valid(&header, (size_t)size, fingerprint, source)) {
+        fclose(fp);
+        free(trie);
+        return NULL;
+    }
+
+    size_t body_size = (size_t)size - sizeof(DatrieHeader);
+    trie->owned = malloc(body_size);
+    if (trie->owned == NULL || fread(trie->owned, 1, body_size, fp) != body_size) {
+        fclose(fp);
+        free(trie->owned);
+        free(trie);
+        return NULL;
+    }
+    fclose(fp);
+    const void* body = trie->owned;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        free(trie);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(DatrieHeader)) {
+        close(fd);
+        free(trie);
+        return NULL;
+    }
+
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        free(trie);
+        return NULL;
+    }
+
+    const DatrieHeader* mapped_header = (const DatrieHeader*)data;
+    if (!header_valid(mapped_header, (size_t)st.st_size, fingerprint, source)) {
+        munmap(data, (size_t)st.st_size);
+        free(trie);
+        return NULL;
+    }
+
+#ifdef MADV_WILLNEED
+    // 匹配时随机访问，提前异步读入
+    madvise(data, (size_t)st.st_size, MADV_WILLNEED);
+#endif
+
+    DatrieHeader header = *mapped_header;
+    trie->mapped = data;
+    trie->mapped_size = (size_t)st.st_size;
+    const void* body = (const char*)data + sizeof(DatrieHeader);
+#endif
+
+    trie->unit_count = (int)header.unit_count;
+    trie->terminal_count = (int)header.terminal_count;
+    trie->word_count = (int)header.word_count;
+    memcpy(trie->codes, header.codes, sizeof(trie->codes));
+    attach_body(trie, body);
+    return trie;
+}
+
+// 保存索引文件
+int datrie_save(const Datrie* trie, const char* path, uint64_t fingerprint, uint64_t source) {
+    if (trie == NULL || path == NULL) {
+        return -1;
+    }
+
+    // 临时文件名带进程号，多个进程同时重建时互不覆盖
+    size_t tmp_length = strlen(path) + 32;
+    char* tmp_path = (char*)malloc(tmp_length);
+    if (tmp_path == NULL) {
+        return -1;
+    }
+#ifdef _WIN32
+    snprintf(tmp_path, tmp_length, "%s.%d.tmp", path, _getpid());
+#else
+    snprintf(tmp_path, tmp_length, "%s.%d.tmp", path, (int)getpid());
+#endif
+
+    DatrieHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DATRIE_MAGIC, 8);
+    header.version = DATRIE_VERSION;
+    header.terminal_count = (uint32_t)trie->terminal_count;
+    header.fingerprint = fingerprint;
+    header.source = source;
+    header.unit_count = (uint32_t)trie->unit_count;
+    header.word_count = (uint32_t)trie->word_count;
+    memcpy(header.codes, trie->codes, sizeof(header.codes));
+
+    FILE* fp = fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        free(tmp_path);
+        return -1;
+    }
+    // 数据区以 base 开头（构建、读入与映射时都是同一块连续内存）
+    size_t body_size = datrie_body_size((size_t)trie->unit_count, (size_t)trie->terminal_count);
+    int result = 0;
+    if (fwrite(&header, sizeof(header), 1, fp) != 1 ||
+        fwrite(trie->base, 1, body_size, fp) != body_size) {
+        result = -1;
+    }
+    if (fclose(fp) != 0) {
+        result = -1;
+    }
+
+    if (result == 0) {
+#ifdef _WIN32
+        result = MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+        result = rename(tmp_path, path) == 0 ? 0 : -1;
+#endif
+    }
+    if (result != 0) {
+        remove(tmp_path);
+    }
+    free(tmp_path);
+    return result;
+}
+
+// 更新索引文件头中的来源标识（失败不影响使用，下次启动重新比较内容指纹）
+static void update_source(const char* path, uint64_t source) {
+    FILE* fp = fopen(path, "r+b");
+    if (fp == NULL) {
+        return;
+    }
+    if (fseek(fp, (long)offsetof(DatrieHeader, source), SEEK_SET) == 0) {
+        fwrite(&source, sizeof(source), 1, fp);
+    }
+    fclose(fp);
+}
+
+// 加载字典索引
+Datrie* datrie_load(const DictWord* words, int count, int max_length, const char* path,
+                    uint64_t source_id) {
+    // 1. 来源未变：直接映射，启动时不遍历单词内容
+    uint64_t source = 0;
+    if (source_id != 0) {
+        int32_t params[2] = { count, max_length };
+        source = dictionary_hash(source_id, params, sizeof(params));
+        source = source != 0 ? source : 1;
+        Datrie* trie = datrie_open(path, 0, source);
+        if (trie != NULL) {
+            return trie;
+        }
+    }
+
+    // 2. 来源变化（如文件被 touch 或复制）：内容未变时沿用索引，只更新来源标识
+    uint64_t fingerprint = datrie_fingerprint(words, count, max_length);
+    Datrie* trie = datrie_open(path, fingerprint, 0);
+    if (trie != NULL) {
+        if (source != 0) {
+            update_source(path, source);
+        }
+        return trie;
+    }
+
+    // 3. 内容变化：重建并保存
+    trie = datrie_build(words, count, max_length);
+    if (trie != NULL && path != NULL) {
+        datrie_save(trie, path, fingerprint, source);
+    }
+    return trie;
+}
+
+// 释放 Trie
+void datrie_free(Datrie* trie) {
+    if (trie == NULL) {
+        return;
+    }
+
+#ifndef _WIN32
+    if (trie->mapped != NULL) {
+        munmap(trie->mapped, trie->mapped_size);
+    }
+#endif
+    free(trie->owned);
+    free(trie);
+}
@@ -0,0 +1,124 @@
+#ifndef GACHA_DATRIE_H
+#define GACHA_DATRIE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dictionary.h"
+
+// 字典索引文件（与 gacha.conf 同目录，字典变化后自动重建）
+#define DATRIE_FILE_NAME "dictionary.dat"
+
+// 文件头魔数与版本
+#define DATRIE_MAGIC "GACHADAT"
+#define DATRIE_VERSION 4
+
+// 转移编码：字典中出现的字节按字节序编为 1 ~ 255（单词不含换行，最多 255 种），0 表示不出现
+#define DATRIE_CODES 256
+
+// 输出位图的一组（32 个状态）
+typedef struct {
+    uint32_t bits;             // 第 i 位：状态 32k + i 是否有输出
+    uint32_t rank;             // 之前各组中有输出的状态数（即本组第一个输出在 words 中的位置）
+} DatrieTerminals;
+
+// 文件头（304 字节），其后依次为 base、fail、输出位图、单词序号与 check 数组（均 4 字节对齐）
+typedef struct {
+    char magic[8];             // DATRIE_MAGIC
+    uint32_t version;          // DATRIE_VERSION
+    uint32_t terminal_count;   // 有输出的状态数
+    uint64_t fingerprint;      // 字典内容指纹（见 datrie_fingerprint）
+    uint64_t source;           // 字典来源标识（见 datrie_load，0 表示未知）
+    uint32_t unit_count;       // 单元数
+    uint32_t word_count;       // 建入的单词数（去重后）
+    uint8_t codes[DATRIE_CODES]; // 字节到编码的映射
+    uint32_t reserved[2];      // 保留（补齐）
+} DatrieHeader;
+
+// 双数组 Trie（Aho-Corasick 自动机），状态 0 为根
+//   转移只读 base 与 check：状态 s 经编码 c 到达 t = base[s] + c 当且仅当 check[t] == c
+//   （各内部状态的 base 互不相同，因此编码即可确定父状态）；fail 为失败链接，只在没有转移时读取。
+//   状态的输出为该状态（含失败链上各后缀）结尾的字典序号最小的单词，只有输出的状态在位图中置位，
+//   单词序号按状态顺序存放在 words 中（位图的组内排名即下标）
+typedef struct {
+    const int32_t* base;       // 子节点偏移（叶子为 0）
+    const int32_t* fail;       // 失败链接
+    const DatrieTerminals* terminals; // 输出位图（每 32 个状态一组）
+    const int32_t* words;      // 有输出的状态的单词序号
+    const uint8_t* check;      // 到达各状态的编码（0 表示空闲）
+    int unit_count;            // 单元数（不小于最大 base + DATRIE_CODES，转移无需越界检查）
+    int terminal_count;        // 有输出的状态数
+    int word_count;            // 建入的单词数
+    uint8_t codes[DATRIE_CODES]; // 字节到编码的映射
+    void* owned;               // 内存中构建或读入的数据区（映射时为 NULL）
+    void* mapped;              // 映射的文件（含文件头）
+    size_t mapped_size;        // 映射长度
+} Datrie;
+
+// 32 位整数中置位的个数
+static inline int datrie_popcount(uint32_t value) {
+#if defined(__GNUC__)
+    return __builtin_popcount(value);
+#else
+    value = value - ((value >> 1) & 0x55555555u);
+    value = (value & 0x33333333u) + ((value >> 2) & 0x33333333u);
+    return (int)((((value + (value >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+#endif
+}
+
+// 状态 state 读入字节 letter 后的状态：没有该编码的子节点时沿失败链回退，字典中没有的字节直接回到根
+static inline int datrie_next(const Datrie* trie, int state, unsigned char letter) {
+    unsigned int code = trie->codes[letter];
+    if (code == 0) {
+        return 0;
+    }
+
+    for (;;) {
+        int next = trie->base[state] + (int)code;
+        if (trie->check[next] == code) {
+            return next;
+        }
+        if (state == 0) {
+            return 0;
+        }
+        state = trie->fail[state];
+    }
+}
+
+// 状态的输出单词序号（没有输出时返回 -1）
+static inline int datrie_word(const Datrie* trie, int state) {
+    const DatrieTerminals* group = &trie->terminals[state >> 5];
+    uint32_t bit = 1u << (state & 31);
+    if ((group->bits & bit) == 0) {
+        return -1;
+    }
+    return trie->words[group->rank + (uint32_t)datrie_popcount(group->bits & (bit - 1))];
+}
+
+// 核心函数
+
+// 字典内容指纹（单词内容、顺序与长度上限的 64 位哈希，不为 0）
+uint64_t datrie_fingerprint(const DictWord* words, int count, int max_length);
+
+// 数据区字节数（文件头之后的全部数组）
+size_t datrie_body_size(size_t unit_count, size_t terminal_count);
+
+// 构建 Trie：长度 1 ~ max_length 的单词，重复单词只保留序号最小者
+//   单词含换行（256 种字节都出现）或内存不足时返回 NULL
+Datrie* datrie_build(const DictWord* words, int count, int max_length);
+
+// 映射索引文件：文件头中的来源标识或内容指纹与参数相同（参数为 0 时不比较该项）才返回 Trie，否则返回 NULL
+Datrie* datrie_open(const char* path, uint64_t fingerprint, uint64_t source);
+
+// 保存索引文件（先写临时文件再替换），失败返回 -1
+int datrie_save(const Datrie* trie, const char* path, uint64_t fingerprint, uint64_t source);
+
+// 加载字典索引：path 非 NULL 时优先映射索引文件，不存在或过期时构建并保存（保存失败不影响使用）
+//   source_id 为字典来源标识（见 Dictionary），与索引文件记录的相同时直接映射，不读单词内容；
+//   不同或为 0 时比较内容指纹，内容未变则只更新文件头中的来源标识
+Datrie* datrie_load(const DictWord* words, int count, int max_length, const char* path,
+                    uint64_t source_id);
+
+// 释放 Trie
+void datrie_free(Datrie* trie);
+
+#endif // GACHA_DATRIE_H
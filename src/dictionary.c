@@ -0,0 +1,271 @@
+#include "dictionary.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <sys/types.h>
+    #include <sys/stat.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "alloc.h"
+
+#define FNV64_PRIME 1099511628211ull
+
+// 64 位 FNV-1a
+uint64_t dictionary_hash(uint64_t hash, const void* data, size_t length) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= p[i];
+        hash *= FNV64_PRIME;
+    }
+    return hash;
+}
+
+// 把外部字典文件的路径与元数据计入来源标识（内容改写后大小、修改时间或 inode 至少一项会变化）
+static void hash_file_identity(Dictionary* dict, const char* path, long long size,
+                               long long mtime_ns, long long ctime_ns, unsigned long long inode) {
+    long long identity[4] = { size, mtime_ns, ctime_ns, (long long)inode };
+    dict->source_id = dictionary_hash(dict->source_id, path, strlen(path) + 1);
+    dict->source_id = dictionary_hash(dict->source_id, identity, sizeof(identity));
+}
+
+// 映射外部字典文件（只读）
+static int map_word_file(Dictionary* dict, const char* path) {
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(path, &st) == 0) {
+        hash_file_identity(dict, path, (long long)st.st_size, (long long)st.st_mtime * 1000000000LL,
+                           (long long)st.st_ctime * 1000000000LL, 0);
+    }
+
+    // Windows 下直接读入内存
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return -1;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size <= 0) {
+        fclose(fp);
+        return size == 0 ? 0 : -1;
+    }
+
+    dict->mapped = (char*)malloc((size_t)size);
+    if (dict->mapped == NULL) {
+        fclose(fp);
+        return -1;
+    }
+    dict->mapped_size = fread(dict->mapped, 1, (size_t)size, fp);
+    dict->is_mmapped = 0;
+    fclose(fp);
+    return 0;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+#ifdef __APPLE__
+    hash_file_identity(dict, path, (long long)st.st_size,
+                       (long long)st.st_mtimespec.tv_sec * 1000000000LL + st.st_mtimespec.tv_nsec,
+                       (long long)st.st_ctimespec.tv_sec * 1000000000LL + st.st_ctimespec.tv_nsec,
+                       (unsigned long long)st.st_ino);
+#else
+    hash_file_identity(dict, path, (long long)st.st_size,
+                       (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec,
+                       (long long)st.st_ctim.tv_sec * 1000000000LL + st.st_ctim.tv_nsec,
+                       (unsigned long long)st.st_ino);
+#endif
+
+    // 空文件没有可映射的内容
+    if (st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+
+#ifdef MADV_SEQUENTIAL
+    // 加载时顺序扫描一遍
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+
+    dict->mapped = (char*)data;
+    dict->mapped_size = (size_t)st.st_size;
+    dict->is_mmapped = 1;
+    return 0;
+#endif
+}
+
+// 统计映射区中的行数（上限）
+static size_t count_lines(const char* data, size_t size) {
+    size_t count = 0;
+    const char* p = data;
+    const char* end = data + size;
+
+    while (p < end) {
+        const char* nl = (const char*)memchr(p, '\n', (size_t)(end - p));
+        count++;
+        if (nl == NULL) {
+            break;
+        }
+        p = nl + 1;
+    }
+
+    return count;
+}
+
+// 从映射区切分单词（每行一个，不复制）
+static int slice_words(Dictionary* dict) {
+    const char* p = dict->mapped;
+    const char* end = dict->mapped + dict->mapped_size;
+
+    // 跳过 UTF-8 BOM
+    if (end - p >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0) {
+        p += 3;
+    }
+
+    while (p < end) {
+        const char* nl = (const char*)memchr(p, '\n', (size_t)(end - p));
+        const char* line_end = nl != NULL ? nl : end;
+
+        // 去除首尾空白
+        const char* start = p;
+        while (start < line_end && (*start == ' ' || *start == '\t')) {
+            start++;
+        }
+        const char* stop = line_end;
+        while (stop > start && (stop[-1] == '\r' || stop[-1] == ' ' || stop[-1] == '\t')) {
+            stop--;
+        }
+
+        if (stop > start) {
+            if ((size_t)(stop - start) > 0x7fffffff) {
+                return -1;
+            }
+            dict->words[dict->size].text = start;
+            dict->words[dict->size].length = (int)(stop - start);
+            dict->size++;
+        }
+
+        p = line_end + 1;
+    }
+
+    return 0;
+}
+
+// 加载字典
+Dictionary* dictionary_load(const GachaConfig* config, const char* config_path) {
+    if (config == NULL) {
+        return NULL;
+    }
+
+    Dictionary* dict = (Dictionary*)malloc(sizeof(Dictionary));
+    if (dict == NULL) {
+        return NULL;
+    }
+
+    dict->words = NULL;
+    dict->size = 0;
+    dict->inline_size = 0;
+    dict->mapped = NULL;
+    dict->mapped_size = 0;
+    dict->is_mmapped = 0;
+    dict->source_id = DICTIONARY_HASH_SEED;
+
+    // 映射外部字典文件
+    if (config->dictionary_file != NULL) {
+        char* path = resolve_config_relative_path(config_path, config->dictionary_file);
+        if (path == NULL || map_word_file(dict, path) != 0) {
+            fprintf(stderr, "警告: 无法读取字典文件 %s\n",
+                    path != NULL ? path : config->dictionary_file);
+        }
+        free(path);
+    }
+
+    // 单词数组容量：内联单词 + 文件行数
+    size_t capacity = (size_t)config->dictionary_size;
+    if (dict->mapped != NULL) {
+        capacity += count_lines(dict->mapped, dict->mapped_size);
+    }
+    if (capacity > 0x7fffffff) {
+        fprintf(stderr, "错误: 字典单词数量过多\n");
+        dictionary_free(dict);
+        return NULL;
+    }
+
+    dict->words = (DictWord*)malloc((capacity > 0 ? capacity : 1) * sizeof(DictWord));
+    if (dict->words == NULL) {
+        dictionary_free(dict);
+        return NULL;
+    }
+
+    // 内联单词优先（匹配冲突时字典序号小者优先）
+    for (int i = 0; i < config->dictionary_size; i++) {
+        const char* word = config->dictionary[i];
+        if (word == NULL || word[0] == '\0') {
+            continue;
+        }
+        dict->words[dict->size].text = word;
+        dict->words[dict->size].length = (int)strlen(word);
+        dict->size++;
+
+        // 内联单词来自 gacha.conf，数量少，直接计入内容
+        int32_t length = dict->words[dict->size - 1].length;
+        dict->source_id = dictionary_hash(dict->source_id, &length, sizeof(length));
+        dict->source_id = dictionary_hash(dict->source_id, word, (size_t)length);
+    }
+    dict->inline_size = dict->size;
+    if (dict->source_id == 0) {
+        dict->source_id = 1;
+    }
+
+    // 外部字典文件单词
+    if (dict->mapped != NULL && slice_words(dict) != 0) {
+        fprintf(stderr, "错误: 字典文件中存在过长的行\n");
+        dictionary_free(dict);
+        return NULL;
+    }
+
+    return dict;
+}
+
+// 释放字典
+void dictionary_free(Dictionary* dict) {
+    if (dict == NULL) {
+        return;
+    }
+
+    if (dict->mapped != NULL) {
+#ifdef _WIN32
+        free(dict->mapped);
+#else
+        if (dict->is_mmapped) {
+            munmap(dict->mapped, dict->mapped_size);
+        } else {
+            free(dict->mapped);
+        }
+#endif
+    }
+
+    free(dict->words);
+    free(dict);
+}
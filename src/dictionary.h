@@ -0,0 +1,42 @@
+#ifndef GACHA_DICTIONARY_H
+#define GACHA_DICTIONARY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+// 64 位 FNV-1a 初始值（dictionary_hash 的起点）
+#define DICTIONARY_HASH_SEED 14695981039346656037ull
+
+// 字典单词（零拷贝切片，不以 NUL 结尾）
+typedef struct {
+    const char* text;          // 单词起始位置（指向配置或映射区）
+    int length;                // 单词字节长度
+} DictWord;
+
+// chaos 模式字典（gacha.conf 内联单词 + 外部字典文件）
+typedef struct {
+    DictWord* words;           // 单词切片数组（内联单词在前）
+    int size;                  // 单词数量
+    int inline_size;           // 来自 gacha.conf 的单词数量
+
+    char* mapped;              // 外部字典文件内容
+    size_t mapped_size;        // 外部字典文件大小
+    int is_mmapped;            // 是否通过 mmap 映射（否则为 malloc 读入）
+
+    uint64_t source_id;        // 来源标识：内联单词与外部字典文件路径、大小、修改时间、inode 的哈希
+                               //   （不读文件内容；字典索引据此判断是否需要比较内容指纹）
+} Dictionary;
+
+// 核心函数
+
+// 64 位 FNV-1a，从 hash 继续累加 data
+uint64_t dictionary_hash(uint64_t hash, const void* data, size_t length);
+
+// 加载字典（外部字典文件路径相对于配置文件目录）
+Dictionary* dictionary_load(const GachaConfig* config, const char* config_path);
+
+// 释放字典
+void dictionary_free(Dictionary* dict);
+
+#endif // GACHA_DICTIONARY_H
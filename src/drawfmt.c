@@ -0,0 +1,259 @@
+#include "drawfmt.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+
+// 写出缓冲区内容
+static void writer_flush(DrawWriter* writer) {
+    if (writer->length > 0 && !writer->error) {
+        if (fwrite(writer->buffer, 1, writer->length, writer->fp) != writer->length) {
+            writer->error = 1;
+        }
+    }
+    writer->length = 0;
+}
+
+// 保证缓冲区还有 need 字节可用
+static void writer_reserve(DrawWriter* writer, size_t need) {
+    if (writer->length + need > DRAW_WRITER_BUFFER_SIZE) {
+        writer_flush(writer);
+    }
+}
+
+// 追加字节（超过缓冲区大小的内容直接写出）
+static void writer_append(DrawWriter* writer, const char* data, size_t length) {
+    if (length > DRAW_WRITER_BUFFER_SIZE) {
+        writer_flush(writer);
+        if (!writer->error && fwrite(data, 1, length, writer->fp) != length) {
+            writer->error = 1;
+        }
+        return;
+    }
+
+    writer_reserve(writer, length);
+    memcpy(writer->buffer + writer->length, data, length);
+    writer->length += length;
+}
+
+// 追加非负整数的十进制表示
+static void writer_append_uint(DrawWriter* writer, uint32_t value) {
+    char digits[10];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    writer_reserve(writer, (size_t)n);
+    while (n > 0) {
+        writer->buffer[writer->length++] = digits[--n];
+    }
+}
+
+// 追加整数（余额可能为负数时也能输出）
+static void writer_append_int(DrawWriter* writer, int value) {
+    if (value < 0) {
+        writer_append(writer, "-", 1);
+        writer_append_uint(writer, 0u - (uint32_t)value);
+    } else {
+        writer_append_uint(writer, (uint32_t)value);
+    }
+}
+
+// 追加 32 位小端整数
+static void writer_append_u32le(DrawWriter* writer, uint32_t value) {
+    char bytes[4];
+    bytes[0] = (char)(value & 0xFF);
+    bytes[1] = (char)((value >> 8) & 0xFF);
+    bytes[2] = (char)((value >> 16) & 0xFF);
+    bytes[3] = (char)((value >> 24) & 0xFF);
+    writer_append(writer, bytes, 4);
+}
+
+// 追加 JSON 字符串内容（转义引号、反斜杠与控制字符，UTF-8 原样输出）
+static void writer_append_json_string(DrawWriter* writer, const char* text) {
+    static const char hex[] = "0123456789abcdef";
+    writer_append(writer, "\"", 1);
+    for (const unsigned char* p = (const unsigned char*)text; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') {
+            char escaped[2] = { '\\', (char)*p };
+            writer_append(writer, escaped, 2);
+        } else if (*p < 0x20) {
+            char escaped[6] = { '\\', 'u', '0', '0', hex[*p >> 4], hex[*p & 0xF] };
+            writer_append(writer, escaped, 6);
+        } else {
+            writer_append(writer, (const char*)p, 1);
+        }
+    }
+    writer_append(writer, "\"", 1);
+}
+
+// 追加 TSV 字段（制表符、换行与反斜杠转义为 \t、\n、\\）
+static void writer_append_tsv_field(DrawWriter* writer, const char* text) {
+    for (const char* p = text; *p != '\0'; p++) {
+        if (*p == '\t') {
+            writer_append(writer, "\\t", 2);
+        } else if (*p == '\n') {
+            writer_append(writer, "\\n", 2);
+        } else if (*p == '\r') {
+            writer_append(writer, "\\r", 2);
+        } else if (*p == '\\') {
+            writer_append(writer, "\\\\", 2);
+        } else {
+            writer_append(writer, p, 1);
+        }
+    }
+}
+
+// 写出二进制文件头与条目表
+static void write_bin_header(DrawWriter* writer, int record_count) {
+    writer_append(writer, DRAW_BIN_MAGIC, strlen(DRAW_BIN_MAGIC));
+    writer_append_u32le(writer, DRAW_BIN_VERSION);
+    writer_append_u32le(writer, DRAW_BIN_RECORD_SIZE);
+    writer_append_u32le(writer, (uint32_t)writer->list->size);
+    writer_append_u32le(writer, (uint32_t)record_count);
+
+    for (int i = 0; i < writer->list->size; i++) {
+        const char* name = gachalist_item_name(writer->list, i);
+        char rank = (char)writer->list->items[i].rank_index;
+        size_t length = name != NULL ? strlen(name) : 0;
+        writer_append(writer, &rank, 1);
+        writer_append_u32le(writer, (uint32_t)length);
+        writer_append(writer, name != NULL ? name : "", length);
+    }
+}
+
+// 解析格式名称
+int draw_format_parse(const char* name) {
+    if (name == NULL) {
+        return -1;
+    }
+
+    if (strcmp(name, "text") == 0) {
+        return DRAW_FORMAT_TEXT;
+    } else if (strcmp(name, "json") == 0) {
+        return DRAW_FORMAT_JSON;
+    } else if (strcmp(name, "tsv") == 0) {
+        return DRAW_FORMAT_TSV;
+    } else if (strcmp(name, "bin") == 0) {
+        return DRAW_FORMAT_BIN;
+    }
+
+    return -1;
+}
+
+// 创建写入器并写出格式头
+DrawWriter* draw_writer_init(FILE* fp, int format, const GachaList* list, int record_count) {
+    if (fp == NULL || list == NULL || format < DRAW_FORMAT_TEXT || format > DRAW_FORMAT_BIN) {
+        return NULL;
+    }
+
+    DrawWriter* writer = (DrawWriter*)malloc(sizeof(DrawWriter));
+    if (writer == NULL) {
+        return NULL;
+    }
+
+    writer->buffer = (char*)malloc(DRAW_WRITER_BUFFER_SIZE);
+    if (writer->buffer == NULL) {
+        free(writer);
+        return NULL;
+    }
+
+    writer->fp = fp;
+    writer->format = format;
+    writer->list = list;
+    writer->length = 0;
+    writer->error = 0;
+
+    // 格式头
+    if (format == DRAW_FORMAT_TSV) {
+        const char* header = "seq\tindex\trank\trank_name\tname\tbalance\n";
+        writer_append(writer, header, strlen(header));
+    } else if (format == DRAW_FORMAT_BIN) {
+        write_bin_header(writer, record_count);
+    }
+
+    return writer;
+}
+
+// 写入一条抽取记录
+void draw_writer_write(DrawWriter* writer, int seq, uint32_t item_index, int balance) {
+    if (writer == NULL || item_index >= (uint32_t)writer->list->size) {
+        return;
+    }
+
+    int rank_index = writer->list->items[item_index].rank_index;
+    const char* rank = rank_name(rank_index);
+    const char* name = gachalist_item_name(writer->list, (int)item_index);
+
+    switch (writer->format) {
+    case DRAW_FORMAT_TEXT:
+        writer_append(writer, "【", strlen("【"));
+        writer_append(writer, rank, strlen(rank));
+        writer_append(writer, "】", strlen("】"));
+        writer_append(writer, name, strlen(name));
+        writer_append(writer, "\n", 1);
+        break;
+
+    case DRAW_FORMAT_JSON:
+        writer_append(writer, "{\"seq\":", 7);
+        writer_append_int(writer, seq);
+        writer_append(writer, ",\"index\":", 9);
+        writer_append_uint(writer, item_index);
+        writer_append(writer, ",\"rank\":", 8);
+        writer_append_int(writer, rank_index);
+        writer_append(writer, ",\"rank_name\":", 13);
+        writer_append_json_string(writer, rank);
+        writer_append(writer, ",\"name\":", 8);
+        writer_append_json_string(writer, name);
+        writer_append(writer, ",\"balance\":", 11);
+        writer_append_int(writer, balance);
+        writer_append(writer, "}\n", 2);
+        break;
+
+    case DRAW_FORMAT_TSV:
+        writer_append_int(writer, seq);
+        writer_append(writer, "\t", 1);
+        writer_append_uint(writer, item_index);
+        writer_append(writer, "\t", 1);
+        writer_append_int(writer, rank_index);
+        writer_append(writer, "\t", 1);
+        writer_append(writer, rank, strlen(rank));
+        writer_append(writer, "\t", 1);
+        writer_append_tsv_field(writer, name);
+        writer_append(writer, "\t", 1);
+        writer_append_int(writer, balance);
+        writer_append(writer, "\n", 1);
+        break;
+
+    case DRAW_FORMAT_BIN: {
+        char reserved[4] = { (char)rank_index, 0, 0, 0 };
+        writer_append_u32le(writer, (uint32_t)seq);
+        writer_append_u32le(writer, item_index);
+        writer_append_u32le(writer, (uint32_t)balance);
+        writer_append(writer, reserved, 4);
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+// 写出剩余内容并释放写入器
+int draw_writer_finish(DrawWriter* writer) {
+    if (writer == NULL) {
+        return -1;
+    }
+
+    writer_flush(writer);
+    if (fflush(writer->fp) != 0) {
+        writer->error = 1;
+    }
+
+    int result = writer->error ? -1 : 0;
+    free(writer->buffer);
+    free(writer);
+    return result;
+}
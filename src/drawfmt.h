@@ -0,0 +1,50 @@
+#ifndef GACHA_DRAWFMT_H
+#define GACHA_DRAWFMT_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "list.h"
+
+// 抽取结果输出格式
+#define DRAW_FORMAT_TEXT 0       // 【等级】菜名（默认）
+#define DRAW_FORMAT_JSON 1       // 每行一个 JSON 对象（NDJSON）
+#define DRAW_FORMAT_TSV 2        // 制表符分隔，首行为表头
+#define DRAW_FORMAT_BIN 3        // 定长二进制记录
+
+// 二进制格式
+//   文件头：魔数 "GACHADRW"、版本、记录长度、条目数、记录数（均为 32 位小端）
+//   条目表：每个条目 1 字节等级 + 32 位小端菜名长度 + 菜名 UTF-8 字节
+//   记录：32 位小端序号、条目序号、抽取后余额，1 字节等级，3 字节保留（填 0）
+#define DRAW_BIN_MAGIC "GACHADRW"
+#define DRAW_BIN_VERSION 1
+#define DRAW_BIN_RECORD_SIZE 16
+
+// 输出缓冲区大小
+#define DRAW_WRITER_BUFFER_SIZE (1 << 20)
+
+// 抽取结果写入器（自行缓冲，整块写出）
+typedef struct {
+    FILE* fp;                  // 输出文件（不持有）
+    int format;                // 输出格式
+    const GachaList* list;     // gachalist（不持有）
+    char* buffer;              // 输出缓冲区
+    size_t length;             // 缓冲区已用长度
+    int error;                 // 是否发生写入错误
+} DrawWriter;
+
+// 核心函数
+
+// 解析格式名称（text/json/tsv/bin），未知格式返回 -1
+int draw_format_parse(const char* name);
+
+// 创建写入器并写出格式头（表头或二进制文件头）
+//   record_count 为随后写入的记录数（二进制文件头需要）
+DrawWriter* draw_writer_init(FILE* fp, int format, const GachaList* list, int record_count);
+
+// 写入一条抽取记录（seq 从 1 开始，balance 为抽取后的余额）
+void draw_writer_write(DrawWriter* writer, int seq, uint32_t item_index, int balance);
+
+// 写出剩余内容并释放写入器，发生写入错误时返回 -1
+int draw_writer_finish(DrawWriter* writer);
+
+#endif // GACHA_DRAWFMT_H
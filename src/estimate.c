@@ -0,0 +1,617 @@
+#include "estimate.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+
+// 匹配自动机（Aho-Corasick，匹配后回到根节点）
+//   状态转移矩阵 P 的每一行与其失败节点所在行只在子节点处不同，
+//   因此一次 πP 只需 O(状态数 + 边数)，不必展开 |字母表| 路转移
+typedef struct {
+    int node_count;            // 节点数量
+    int* fail;                 // 失败链接
+    int* first_child;          // 第一个子节点
+    int* next_sibling;         // 下一个兄弟节点
+    int* symbol;               // 入边符号
+    int* terminal;             // 以该节点结尾的最小字典序号（-1 表示无）
+    int* winner;               // 到达该节点时胜出的字典序号（-1 表示不匹配）
+    int* order;                // 可停留状态的 BFS 顺序（根节点在前）
+    int live_count;            // 可停留状态数量
+    int* matches;              // 匹配节点
+    int match_count;           // 匹配节点数量
+    unsigned char* kind;       // 节点类型（见 NODE_*）
+
+    unsigned long long* edge_keys; // 转移哈希表键（node * 256 + 符号 + 1，0 为空）
+    int* edge_values;          // 转移哈希表值（子节点）
+    size_t edge_mask;          // 转移哈希表大小 - 1
+} Automaton;
+
+// 节点类型
+#define NODE_UNREACHABLE 0     // 不可达（前缀中已包含匹配）
+#define NODE_LIVE 1            // 可停留的状态
+#define NODE_MATCH 2           // 到达即匹配并回到根节点
+
+// 转移哈希
+static size_t edge_slot(const Automaton* ac, unsigned long long key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (size_t)key & ac->edge_mask;
+}
+
+// 查找子节点（不存在返回 -1）
+static int automaton_goto(const Automaton* ac, int node, int sym) {
+    unsigned long long key = (unsigned long long)node * 256 + (unsigned long long)sym + 1;
+    size_t slot = edge_slot(ac, key);
+    while (ac->edge_keys[slot] != 0) {
+        if (ac->edge_keys[slot] == key) {
+            return ac->edge_values[slot];
+        }
+        slot = (slot + 1) & ac->edge_mask;
+    }
+    return -1;
+}
+
+// 添加子节点
+static int automaton_add_child(Automaton* ac, int node, int sym) {
+    int child = ac->node_count++;
+    ac->fail[child] = 0;
+    ac->first_child[child] = -1;
+    ac->next_sibling[child] = ac->first_child[node];
+    ac->symbol[child] = sym;
+    ac->first_child[node] = child;
+    ac->terminal[child] = -1;
+    ac->winner[child] = -1;
+    ac->kind[child] = NODE_UNREACHABLE;
+
+    unsigned long long key = (unsigned long long)node * 256 + (unsigned long long)sym + 1;
+    size_t slot = edge_slot(ac, key);
+    while (ac->edge_keys[slot] != 0) {
+        slot = (slot + 1) & ac->edge_mask;
+    }
+    ac->edge_keys[slot] = key;
+    ac->edge_values[slot] = child;
+
+    return child;
+}
+
+// 释放自动机
+static void automaton_free(Automaton* ac) {
+    free(ac->fail);
+    free(ac->first_child);
+    free(ac->next_sibling);
+    free(ac->symbol);
+    free(ac->terminal);
+    free(ac->winner);
+    free(ac->order);
+    free(ac->matches);
+    free(ac->kind);
+    free(ac->edge_keys);
+    free(ac->edge_values);
+}
+
+// 构建自动机
+static int automaton_build(Automaton* ac, const DictWord* words, int word_count,
+                           const short* sym_map, int max_length) {
+    memset(ac, 0, sizeof(Automaton));
+
+    // 节点数上限：根节点 + 所有可匹配单词的字符数
+    size_t max_nodes = 1;
+    for (int i = 0; i < word_count; i++) {
+        if (words[i].length > 0 && words[i].length <= max_length) {
+            max_nodes += (size_t)words[i].length;
+        }
+    }
+
+    size_t edge_size = 16;
+    while (edge_size < max_nodes * 2) {
+        edge_size *= 2;
+    }
+
+    ac->fail = (int*)malloc(max_nodes * sizeof(int));
+    ac->first_child = (int*)malloc(max_nodes * sizeof(int));
+    ac->next_sibling = (int*)malloc(max_nodes * sizeof(int));
+    ac->symbol = (int*)malloc(max_nodes * sizeof(int));
+    ac->terminal = (int*)malloc(max_nodes * sizeof(int));
+    ac->winner = (int*)malloc(max_nodes * sizeof(int));
+    ac->order = (int*)malloc(max_nodes * sizeof(int));
+    ac->matches = (int*)malloc(max_nodes * sizeof(int));
+    ac->kind = (unsigned char*)malloc(max_nodes);
+    ac->edge_keys = (unsigned long long*)calloc(edge_size, sizeof(unsigned long long));
+    ac->edge_values = (int*)malloc(edge_size * sizeof(int));
+    ac->edge_mask = edge_size - 1;
+
+    if (ac->fail == NULL || ac->first_child == NULL || ac->next_sibling == NULL ||
+        ac->symbol == NULL || ac->terminal == NULL || ac->winner == NULL ||
+        ac->order == NULL || ac->matches == NULL || ac->kind == NULL ||
+        ac->edge_keys == NULL || ac->edge_values == NULL) {
+        automaton_free(ac);
+        return -1;
+    }
+
+    // 根节点
+    ac->node_count = 1;
+    ac->fail[0] = 0;
+    ac->first_child[0] = -1;
+    ac->next_sibling[0] = -1;
+    ac->symbol[0] = -1;
+    ac->terminal[0] = -1;
+    ac->winner[0] = -1;
+    ac->kind[0] = NODE_LIVE;
+
+    // 1. 插入单词（包含字母表以外字符的单词永远不会匹配，跳过）
+    for (int i = 0; i < word_count; i++) {
+        const DictWord* word = &words[i];
+        if (word->length <= 0 || word->length > max_length) {
+            continue;
+        }
+
+        int valid = 1;
+        for (int k = 0; k < word->length; k++) {
+            if (sym_map[(unsigned char)word->text[k]] < 0) {
+                valid = 0;
+                break;
+            }
+        }
+        if (!valid) {
+            continue;
+        }
+
+        int node = 0;
+        for (int k = 0; k < word->length; k++) {
+            int sym = sym_map[(unsigned char)word->text[k]];
+            int child = automaton_goto(ac, node, sym);
+            if (child < 0) {
+                child = automaton_add_child(ac, node, sym);
+            }
+            node = child;
+        }
+
+        // 重复单词只保留字典序号最小者
+        if (ac->terminal[node] < 0) {
+            ac->terminal[node] = i;
+        }
+    }
+
+    // 2. BFS 计算失败链接、胜出单词与节点类型
+    //    只展开可停留的节点：匹配节点之后的子树永远不会到达
+    int head = 0;
+    int tail = 0;
+    ac->order[tail++] = 0;
+
+    while (head < tail) {
+        int node = ac->order[head++];
+
+        for (int child = ac->first_child[node]; child >= 0; child = ac->next_sibling[child]) {
+            int fail = 0;
+            if (node != 0) {
+                int sym = ac->symbol[child];
+                int f = ac->fail[node];
+                while (1) {
+                    int next = automaton_goto(ac, f, sym);
+                    if (next >= 0) {
+                        fail = next;
+                        break;
+                    }
+                    if (f == 0) {
+                        break;
+                    }
+                    f = ac->fail[f];
+                }
+            }
+            ac->fail[child] = fail;
+
+            // 胜出单词：自身与后缀单词中字典序号最小者
+            int winner = ac->terminal[child];
+            int suffix_winner = ac->winner[fail];
+            if (suffix_winner >= 0 && (winner < 0 || suffix_winner < winner)) {
+                winner = suffix_winner;
+            }
+            ac->winner[child] = winner;
+
+            if (winner >= 0) {
+                ac->kind[child] = NODE_MATCH;
+                ac->matches[ac->match_count++] = child;
+            } else {
+                ac->kind[child] = NODE_LIVE;
+                ac->order[tail++] = child;
+            }
+        }
+    }
+    ac->live_count = tail;
+
+    return 0;
+}
+
+// 计算一步转移 arrive = πP（匹配节点上的到达量即匹配流量）
+static void automaton_step(const Automaton* ac, int alphabet_size,
+                           const double* pi, double* carry, double* arrive) {
+    double inv = 1.0 / alphabet_size;
+
+    for (int k = 0; k < ac->live_count; k++) {
+        int node = ac->order[k];
+        carry[node] = pi[node];
+        arrive[node] = 0.0;
+    }
+    for (int k = 0; k < ac->match_count; k++) {
+        arrive[ac->matches[k]] = 0.0;
+    }
+
+    // 按深度从深到浅处理：子节点直接到达，其余字母的转移交给失败节点，
+    // 再抵消失败节点在这些字母上的转移
+    for (int k = ac->live_count - 1; k > 0; k--) {
+        int node = ac->order[k];
+        double mass = carry[node] * inv;
+        for (int child = ac->first_child[node]; child >= 0; child = ac->next_sibling[child]) {
+            arrive[child] += mass;
+            arrive[ac->fail[child]] -= mass;
+        }
+        carry[ac->fail[node]] += carry[node];
+    }
+
+    // 根节点：没有子节点的字母回到根节点
+    int root_children = 0;
+    double root_mass = carry[0] * inv;
+    for (int child = ac->first_child[0]; child >= 0; child = ac->next_sibling[child]) {
+        arrive[child] += root_mass;
+        root_children++;
+    }
+    arrive[0] += root_mass * (alphabet_size - root_children);
+}
+
+// 分配估算结果
+static ChaosEstimate* estimate_create(int word_count) {
+    ChaosEstimate* est = (ChaosEstimate*)malloc(sizeof(ChaosEstimate));
+    if (est == NULL) {
+        return NULL;
+    }
+    memset(est, 0, sizeof(ChaosEstimate));
+    est->word_count = word_count;
+    est->match_probability = (double*)calloc((size_t)word_count, sizeof(double));
+    est->match_rate = (double*)calloc((size_t)word_count, sizeof(double));
+    if (est->match_probability == NULL || est->match_rate == NULL) {
+        estimate_free(est);
+        return NULL;
+    }
+    return est;
+}
+
+// 由各单词的平稳匹配率计算匹配间隔与单次运行的期望指标
+static ChaosEstimate* estimate_finish(ChaosEstimate* est, double total_rate,
+                                      int letters_per_second, int max_match_count) {
+    int word_count = est->word_count;
+
+    if (total_rate <= 0.0) {
+        // 没有可匹配的单词
+        est->letters_per_match = INFINITY;
+        est->matches_per_run = INFINITY;
+        est->letters_per_run = INFINITY;
+        est->seconds_per_run = INFINITY;
+        est->balance_per_hour = 0.0;
+        return est;
+    }
+
+    for (int i = 0; i < word_count; i++) {
+        est->match_probability[i] = est->match_rate[i] / total_rate;
+        if (est->match_rate[i] > 0.0) {
+            est->matchable_count++;
+        }
+    }
+
+    // 匹配是更新过程（每次匹配后回到根节点），期望间隔为平稳匹配率的倒数
+    est->letters_per_match = 1.0 / total_rate;
+    est->balance_per_hour = total_rate * letters_per_second * 3600.0;
+
+    // 4. 单次运行的期望匹配次数：任一单词匹配 max_match_count 次时结束
+    //    每次匹配的胜出单词独立同分布，P(N > n) = n! [x^n] Π_i Σ_{j<m} (p_i x)^j / j!
+    //    以 a_n = P(n 次匹配全部落在已处理单词中且各自少于 m 次) 逐个单词递推
+    int m = max_match_count;
+    long long n_limit = (long long)est->matchable_count * (m - 1) + 1;
+
+    // 可匹配单词的概率（预先计算对数，供截断上界使用）
+    int k_count = est->matchable_count;
+    double* probs = (double*)malloc((size_t)k_count * 3 * sizeof(double));
+    if (probs == NULL) {
+        estimate_free(est);
+        return NULL;
+    }
+    double* log_p = probs + k_count;
+    double* log_q = probs + 2 * k_count;
+    for (int i = 0, k = 0; i < word_count; i++) {
+        if (est->match_probability[i] > 0.0) {
+            probs[k] = est->match_probability[i];
+            log_p[k] = log(probs[k]);
+            log_q[k] = log1p(-probs[k]);
+            k++;
+        }
+    }
+
+    // 截断上界：多项分布负相关，P(N > n) <= Π_i P(Bin(n, p_i) < m)
+    long long lo = 0;
+    long long hi = n_limit;
+    while (lo < hi) {
+        long long mid = (lo + hi) / 2;
+        double log_bound = 0.0;
+        for (int k = 0; k < k_count && log_bound > -50.0; k++) {
+            if (probs[k] >= 1.0) {
+                log_bound += mid < m ? 0.0 : -INFINITY;
+                continue;
+            }
+            double tail = 0.0;
+            double log_coef = 0.0;
+            for (int j = 0; j < m && j <= mid; j++) {
+                if (j > 0) {
+                    log_coef += log((double)(mid - j + 1) / j);
+                }
+                tail += exp(log_coef + j * log_p[k] + (mid - j) * log_q[k]);
+            }
+            log_bound += log(tail < 1.0 ? tail : 1.0);
+        }
+        if (log_bound < -50.0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    int n_max = (int)(lo < n_limit ? lo : n_limit);
+
+    double* a = (double*)calloc((size_t)n_max + 1, sizeof(double));
+    double* coef = (double*)malloc((size_t)m * sizeof(double));
+    if (a == NULL || coef == NULL) {
+        free(a);
+        free(coef);
+        free(probs);
+        estimate_free(est);
+        return NULL;
+    }
+    a[0] = 1.0;
+    int degree = 0;
+
+    for (int k = 0; k < k_count; k++) {
+        degree += m - 1;
+        if (degree > n_max) {
+            degree = n_max;
+        }
+        for (int j = 1; j < m; j++) {
+            coef[j] = probs[k] / j;
+        }
+
+        // a_n <- Σ_{j<m} C(n, j) p^j a_{n-j}，从高到低原地更新（Horner 形式）
+        for (int n = degree; n >= m - 1 && n >= 1; n--) {
+            double nd = (double)n;
+            double acc = a[n - m + 1];
+            for (int j = m - 1; j >= 1; j--) {
+                acc = a[n - j + 1] + acc * (nd - j + 1) * coef[j];
+            }
+            // 可忽略的尾部置零，避免次正规数拖慢运算
+            a[n] = acc > 1e-200 ? acc : 0.0;
+        }
+        for (int n = (degree < m - 2 ? degree : m - 2); n >= 1; n--) {
+            double nd = (double)n;
+            double acc = a[0];
+            for (int j = n; j >= 1; j--) {
+                acc = a[n - j + 1] + acc * (nd - j + 1) * coef[j];
+            }
+            a[n] = acc;
+        }
+    }
+
+    double expected_matches = 0.0;
+    for (int n = 0; n <= degree; n++) {
+        expected_matches += a[n];
+    }
+    free(a);
+    free(coef);
+    free(probs);
+
+    // Wald 等式：期望字母数 = 期望匹配次数 × 每次匹配的期望字母数
+    est->matches_per_run = expected_matches;
+    est->letters_per_run = expected_matches * est->letters_per_match;
+    est->seconds_per_run = est->letters_per_run / letters_per_second;
+
+    return est;
+}
+
+// 解析计算 chaos 模式期望指标
+ChaosEstimate* estimate_chaos(const DictWord* words, int word_count,
+                              const char* charset, int charset_size, int max_length,
+                              int letters_per_second, int max_match_count) {
+    if (words == NULL || word_count <= 0 || charset == NULL || charset_size <= 0 ||
+        letters_per_second <= 0 || max_match_count <= 0) {
+        return NULL;
+    }
+
+    // 字符到符号的映射
+    short sym_map[256];
+    for (int c = 0; c < 256; c++) {
+        sym_map[c] = -1;
+    }
+    int alphabet_size = 0;
+    for (int i = 0; i < charset_size; i++) {
+        unsigned char c = (unsigned char)charset[i];
+        if (sym_map[c] < 0) {
+            sym_map[c] = (short)alphabet_size++;
+        }
+    }
+
+    ChaosEstimate* est = estimate_create(word_count);
+    if (est == NULL) {
+        return NULL;
+    }
+
+    // 1. 构建匹配自动机
+    Automaton ac;
+    if (automaton_build(&ac, words, word_count, sym_map, max_length) != 0) {
+        estimate_free(est);
+        return NULL;
+    }
+
+    est->state_count = ac.live_count;
+
+    double* pi = (double*)calloc((size_t)ac.node_count, sizeof(double));
+    double* carry = (double*)malloc((size_t)ac.node_count * sizeof(double));
+    double* arrive = (double*)malloc((size_t)ac.node_count * sizeof(double));
+    if (pi == NULL || carry == NULL || arrive == NULL) {
+        free(pi);
+        free(carry);
+        free(arrive);
+        automaton_free(&ac);
+        estimate_free(est);
+        return NULL;
+    }
+
+    // 2. 求平稳分布 π = πP（匹配节点的到达量立即转回根节点）
+    //    使用 π' = π/8 + 7πP/8 的惰性迭代以避免周期链振荡，平稳分布不变
+    pi[0] = 1.0;
+    for (est->iterations = 1; est->iterations <= ESTIMATE_MAX_ITERATIONS; est->iterations++) {
+        automaton_step(&ac, alphabet_size, pi, carry, arrive);
+
+        for (int k = 0; k < ac.match_count; k++) {
+            arrive[0] += arrive[ac.matches[k]];
+        }
+
+        double max_change = 0.0;
+        for (int k = 0; k < ac.live_count; k++) {
+            int i = ac.order[k];
+            double next = 0.125 * pi[i] + 0.875 * arrive[i];
+            double change = fabs(next - pi[i]);
+            if (next > 0.0) {
+                change /= next;
+            }
+            if (change > max_change) {
+                max_change = change;
+            }
+            pi[i] = next;
+        }
+
+        if (max_change < ESTIMATE_TOLERANCE) {
+            break;
+        }
+    }
+
+    // 3. 各单词的平稳匹配率
+    automaton_step(&ac, alphabet_size, pi, carry, arrive);
+    double total_rate = 0.0;
+    for (int k = 0; k < ac.match_count; k++) {
+        int i = ac.matches[k];
+        if (arrive[i] > 0.0) {
+            est->match_rate[ac.winner[i]] += arrive[i];
+            total_rate += arrive[i];
+        }
+    }
+
+    free(pi);
+    free(carry);
+    free(arrive);
+    automaton_free(&ac);
+
+    return estimate_finish(est, total_rate, letters_per_second, max_match_count);
+}
+
+// 计算一步 DFA 转移 arrive = πP（接受状态上的到达量即匹配流量）
+static void dfa_step(const PatternDfa* dfa, const double* pi, double* arrive) {
+    int alphabet = dfa->alphabet_size;
+    double inv = 1.0 / alphabet;
+
+    for (int s = 0; s < dfa->state_count; s++) {
+        arrive[s] = 0.0;
+    }
+    for (int s = 0; s < dfa->state_count; s++) {
+        if (pi[s] == 0.0) {
+            continue;
+        }
+        double mass = pi[s] * inv;
+        const int* row = dfa->next + (size_t)s * alphabet;
+        for (int c = 0; c < alphabet; c++) {
+            arrive[row[c]] += mass;
+        }
+    }
+}
+
+// 按模式 DFA 解析计算 chaos 模式期望指标（字母表为 DFA 的全部符号，等概率）
+ChaosEstimate* estimate_chaos_dfa(const PatternDfa* dfa, int letters_per_second,
+                                  int max_match_count) {
+    if (dfa == NULL || letters_per_second <= 0 || max_match_count <= 0) {
+        return NULL;
+    }
+
+    ChaosEstimate* est = estimate_create(dfa->pattern_count);
+    if (est == NULL) {
+        return NULL;
+    }
+
+    int n = dfa->state_count;
+    double* pi = (double*)calloc((size_t)n, sizeof(double));
+    double* arrive = (double*)malloc((size_t)n * sizeof(double));
+    if (pi == NULL || arrive == NULL) {
+        free(pi);
+        free(arrive);
+        estimate_free(est);
+        return NULL;
+    }
+
+    // 接受状态只是匹配的瞬间，不计入可停留状态
+    for (int s = 0; s < n; s++) {
+        if (dfa->accept[s] < 0) {
+            est->state_count++;
+        }
+    }
+
+    // 1. 求平稳分布（接受状态的到达量立即转回初始状态，惰性迭代同 estimate_chaos）
+    pi[0] = 1.0;
+    for (est->iterations = 1; est->iterations <= ESTIMATE_MAX_ITERATIONS; est->iterations++) {
+        dfa_step(dfa, pi, arrive);
+
+        for (int s = 0; s < n; s++) {
+            if (dfa->accept[s] >= 0) {
+                arrive[0] += arrive[s];
+                arrive[s] = 0.0;
+            }
+        }
+
+        double max_change = 0.0;
+        for (int s = 0; s < n; s++) {
+            double next = 0.125 * pi[s] + 0.875 * arrive[s];
+            double change = fabs(next - pi[s]);
+            if (next > 0.0) {
+                change /= next;
+            }
+            if (change > max_change) {
+                max_change = change;
+            }
+            pi[s] = next;
+        }
+
+        if (max_change < ESTIMATE_TOLERANCE) {
+            break;
+        }
+    }
+
+    // 2. 各模式的平稳匹配率
+    dfa_step(dfa, pi, arrive);
+    double total_rate = 0.0;
+    for (int s = 0; s < n; s++) {
+        if (dfa->accept[s] >= 0 && arrive[s] > 0.0) {
+            est->match_rate[dfa->accept[s]] += arrive[s];
+            total_rate += arrive[s];
+        }
+    }
+
+    free(pi);
+    free(arrive);
+
+    return estimate_finish(est, total_rate, letters_per_second, max_match_count);
+}
+
+// 释放估算结果
+void estimate_free(ChaosEstimate* est) {
+    if (est == NULL) {
+        return;
+    }
+
+    free(est->match_probability);
+    free(est->match_rate);
+    free(est);
+}
@@ -0,0 +1,44 @@
+#ifndef GACHA_ESTIMATE_H
+#define GACHA_ESTIMATE_H
+
+#include "dictionary.h"
+#include "pattern.h"
+
+// chaos 模式解析估算结果
+typedef struct {
+    int word_count;              // 字典单词数量
+    int matchable_count;         // 可能匹配的单词数量（匹配概率 > 0）
+    int state_count;             // 匹配自动机的有效状态数
+    int iterations;              // 平稳分布求解迭代次数
+
+    double* match_probability;   // 各单词在一次匹配中胜出的概率
+    double* match_rate;          // 各单词每个字母的匹配率
+
+    double letters_per_match;    // 每次匹配的期望字母数
+    double matches_per_run;      // 单次运行的期望匹配次数
+    double letters_per_run;      // 单次运行的期望字母数
+    double seconds_per_run;      // 单次运行的期望时长（秒）
+    double balance_per_hour;     // 每小时期望获得的抽卡余额
+} ChaosEstimate;
+
+// 收敛判定：各状态概率的最大相对变化
+#define ESTIMATE_TOLERANCE 1e-13
+#define ESTIMATE_MAX_ITERATIONS 1000000
+
+// 核心函数
+
+// 解析计算 chaos 模式期望指标（不做模拟）
+//   charset 为随机字母表（等概率），max_length 为匹配缓冲区长度（更长的单词不会匹配）
+ChaosEstimate* estimate_chaos(const DictWord* words, int word_count,
+                              const char* charset, int charset_size, int max_length,
+                              int letters_per_second, int max_match_count);
+
+// 按模式 DFA 解析计算 chaos 模式期望指标（通配符 / 忽略大小写 / 自定义字母表字典，
+//   字母表为 DFA 的全部符号，等概率）
+ChaosEstimate* estimate_chaos_dfa(const PatternDfa* dfa, int letters_per_second,
+                                  int max_match_count);
+
+// 释放估算结果
+void estimate_free(ChaosEstimate* est);
+
+#endif // GACHA_ESTIMATE_H
@@ -1,18 +1,21 @@
 #include "gacha.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
-// 等级到索引的映射
-static int rank_to_index(const char* rank) {
-    if (strcmp(rank, "N") == 0) return 0;
-    if (strcmp(rank, "R") == 0) return 1;
-    if (strcmp(rank, "SR") == 0) return 2;
-    if (strcmp(rank, "SSR") == 0) return 3;
-    if (strcmp(rank, "UR") == 0) return 4;
-    return -1;
-}
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+
+#include "alloc.h"
 
 // 初始化 gacha 模块
 GachaState* gacha_init(const char* gachalist_path, int balance) {
@@ -44,15 +47,149 @@ GachaState* gacha_init(const char* gachalist_path, int balance) {
         return NULL;
     }
 
+    // 等级字节表（批量抽取时收集等级用）与各条目计数
+    state->rank_table = (unsigned char*)malloc((size_t)state->list->size);
+    state->item_counts = (uint32_t*)calloc((size_t)state->list->size * GACHA_COUNT_LANES,
+                                           sizeof(uint32_t));
+    if (state->rank_table == NULL || state->item_counts == NULL) {
+        free(state->rank_table);
+        free(state->item_counts);
+        free_gachalist(state->list);
+        random_generator_free(state->rng);
+        free(state);
+        return NULL;
+    }
+    for (int i = 0; i < state->list->size; i++) {
+        int rank_index = state->list->items[i].rank_index;
+        state->rank_table[i] = (unsigned char)(rank_index >= 0 && rank_index < RANK_COUNT ? rank_index : RANK_COUNT);
+    }
+
     // 初始化状态
     state->total_draws = 0;
     memset(state->rank_counts, 0, sizeof(state->rank_counts));
     state->balance = balance;
     state->initialized = 1;
+    state->threads = 1;
+    state->block_latency = NULL;
 
     return state;
 }
 
+// 记录一块抽取的耗时（启用耗时统计时）
+//   块内单次抽取只有几纳秒，低于时钟分辨率，不单独计时
+static void record_latency(GachaState* state, long long start) {
+    histogram_record(state->block_latency, trace_now() - start);
+}
+
+// 启用抽取耗时统计
+int gacha_enable_latency(GachaState* state) {
+    if (state == NULL) {
+        return -1;
+    }
+    if (state->block_latency != NULL) {
+        return 0;
+    }
+
+    state->block_latency = histogram_create();
+    return state->block_latency != NULL ? 0 : -1;
+}
+
+// 设置批量抽取的线程数
+void gacha_set_threads(GachaState* state, int threads) {
+    if (state == NULL) {
+        return;
+    }
+    state->threads = threads < 1 ? 1 : (threads > GACHA_MAX_THREADS ? GACHA_MAX_THREADS : threads);
+}
+
+// 并行生成的一段序号
+typedef struct {
+    const RandomGenerator* rng;
+    uint64_t first;              // 第一个序号
+    uint32_t bound;              // 上界（条目数）
+    uint32_t* out;               // 输出位置
+    size_t count;                // 数量
+
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+    int started;                 // 是否已启动线程
+} DrawSegment;
+
+// 生成一段序号（计数模式下只取决于序号，与哪个线程生成无关）
+static void fill_segment(DrawSegment* segment) {
+    random_fill_bounded_at(segment->rng, segment->first, segment->bound, segment->out, segment->count);
+}
+
+// 生成线程不分配事件环（每批都会新建线程，会占满跟踪的线程槽），整段由调用线程的 draw_fill 事件记录
+#ifdef _WIN32
+static DWORD WINAPI draw_thread_main(LPVOID arg) {
+    fill_segment((DrawSegment*)arg);
+    return 0;
+}
+#else
+static void* draw_thread_main(void* arg) {
+    fill_segment((DrawSegment*)arg);
+    return NULL;
+}
+#endif
+
+// 计数模式：预留 count 个序号并分段并行生成，失败返回 -1（调用方改为逐块生成）
+static int fill_parallel(GachaState* state, uint32_t bound, uint32_t* out, int count) {
+    int threads = state->threads;
+    DrawSegment* segments = (DrawSegment*)malloc(sizeof(DrawSegment) * (size_t)threads);
+    if (segments == NULL) {
+        return -1;
+    }
+
+    // 分段长度取 4 的倍数（每个 Philox 块给出 4 个序号）
+    uint64_t first = random_reserve(state->rng, (uint64_t)count);
+    size_t step = ((size_t)count / (size_t)threads + 3) & ~(size_t)3;
+    size_t start = 0;
+    for (int k = 0; k < threads; k++) {
+        size_t n = start < (size_t)count ? (size_t)count - start : 0;
+        if (n > step && k + 1 < threads) {
+            n = step;
+        }
+        segments[k].rng = state->rng;
+        segments[k].first = first + start;
+        segments[k].bound = bound;
+        segments[k].out = out + start;
+        segments[k].count = n;
+        start += n;
+    }
+
+    // 最后一段由当前线程生成，线程启动失败时就地生成
+    for (int k = 0; k + 1 < threads; k++) {
+#ifdef _WIN32
+        segments[k].thread = CreateThread(NULL, 0, draw_thread_main, &segments[k], 0, NULL);
+        segments[k].started = segments[k].thread != NULL;
+#else
+        segments[k].started = pthread_create(&segments[k].thread, NULL, draw_thread_main, &segments[k]) == 0;
+#endif
+        if (!segments[k].started) {
+            fill_segment(&segments[k]);
+        }
+    }
+    fill_segment(&segments[threads - 1]);
+    for (int k = 0; k + 1 < threads; k++) {
+        if (!segments[k].started) {
+            continue;
+        }
+#ifdef _WIN32
+        WaitForSingleObject(segments[k].thread, INFINITE);
+        CloseHandle(segments[k].thread);
+#else
+        pthread_join(segments[k].thread, NULL);
+#endif
+    }
+
+    free(segments);
+    return 0;
+}
+
 // 从 gachalist 中随机抽取一个
 GachaResult gacha_draw(GachaState* state) {
     GachaResult result = { NULL, NULL };
@@ -67,56 +204,274 @@ GachaResult gacha_draw(GachaState* state) {
     }
 
     // 生成随机索引
-    int index = rand() % state->list->size;
+    long long start = state->block_latency != NULL ? trace_now() : 0;
+    int index = (int)random_bounded(state->rng, (uint32_t)state->list->size);
 
     // 创建抽取结果
-    result.name = strdup(state->list->items[index].name);
-    result.rank = strdup(state->list->items[index].rank);
+    result.name = gachalist_item_name(state->list, index);
+    result.rank = gachalist_item_rank(state->list, index);
 
     // 更新统计
     state->total_draws++;
     state->balance--;
 
-    // 更新等级计数
-    int rank_index = rank_to_index(result.rank);
-    if (rank_index >= 0 && rank_index < 5) {
+    // 更新条目与等级计数
+    state->item_counts[(size_t)index * GACHA_COUNT_LANES]++;
+    int rank_index = state->list->items[index].rank_index;
+    if (rank_index >= 0 && rank_index < RANK_COUNT) {
         state->rank_counts[rank_index]++;
     }
 
+    if (state->block_latency != NULL) {
+        record_latency(state, start);
+    }
+
     return result;
 }
 
-// 批量抽取
-GachaResult* gacha_draw_multiple(GachaState* state, int count, int* actual_count) {
-    if (state == NULL || !state->initialized || actual_count == NULL) {
-        return NULL;
+// 统计等级字节直方图（值为 RANK_COUNT 的无效等级不计入）
+static void rank_histogram(const unsigned char* ranks, int count, int* counts) {
+    int i = 0;
+
+#ifdef __SSE2__
+    // 每次比较 16 个字节：相等的字节为 0xFF，相减即为 +1；
+    // 字节计数最多累加 255 轮，之后用 SAD 横向求和并清零
+    const __m128i zero = _mm_setzero_si128();
+    __m128i keys[RANK_COUNT];
+    for (int k = 0; k < RANK_COUNT; k++) {
+        keys[k] = _mm_set1_epi8((char)k);
     }
 
-    // 验证参数
-    if (count < 1) count = 1;
-    if (count > 1000) count = 1000;
+    while (i + 16 <= count) {
+        __m128i acc[RANK_COUNT];
+        for (int k = 0; k < RANK_COUNT; k++) {
+            acc[k] = zero;
+        }
 
-    // 分配结果数组
-    GachaResult* results = (GachaResult*)malloc(sizeof(GachaResult) * count);
-    if (results == NULL) {
-        return NULL;
+        int rounds = 0;
+        for (; rounds < 255 && i + 16 <= count; rounds++, i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(ranks + i));
+            for (int k = 0; k < RANK_COUNT; k++) {
+                acc[k] = _mm_sub_epi8(acc[k], _mm_cmpeq_epi8(v, keys[k]));
+            }
+        }
+
+        for (int k = 0; k < RANK_COUNT; k++) {
+            __m128i sum = _mm_sad_epu8(acc[k], zero);
+            counts[k] += _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+        }
+    }
+#endif
+
+    // 尾部（或不支持 SSE2 时的全部数据）
+    for (; i < count; i++) {
+        if (ranks[i] < RANK_COUNT) {
+            counts[ranks[i]]++;
+        }
+    }
+}
+
+// 收集一块抽取结果的等级字节并累加各条目计数（第 i 次抽取写第 i % 路数 路）
+static void gather_block(GachaState* state, const uint32_t* indices, int count,
+                         unsigned char* ranks) {
+    const unsigned char* rank_table = state->rank_table;
+    uint32_t* counts = state->item_counts;
+
+    int i = 0;
+    for (; i + GACHA_COUNT_LANES <= count; i += GACHA_COUNT_LANES) {
+        for (int lane = 0; lane < GACHA_COUNT_LANES; lane++) {
+            uint32_t index = indices[i + lane];
+            ranks[i + lane] = rank_table[index];
+            counts[(size_t)index * GACHA_COUNT_LANES + lane]++;
+        }
+    }
+    for (; i < count; i++) {
+        ranks[i] = rank_table[indices[i]];
+        counts[(size_t)indices[i] * GACHA_COUNT_LANES]++;
+    }
+}
+
+// 只累加一块抽取结果的各条目计数
+static void count_block(GachaState* state, const uint32_t* indices, int count) {
+    uint32_t* counts = state->item_counts;
+
+    int i = 0;
+    for (; i + GACHA_COUNT_LANES <= count; i += GACHA_COUNT_LANES) {
+        for (int lane = 0; lane < GACHA_COUNT_LANES; lane++) {
+            counts[(size_t)indices[i + lane] * GACHA_COUNT_LANES + lane]++;
+        }
+    }
+    for (; i < count; i++) {
+        counts[(size_t)indices[i] * GACHA_COUNT_LANES]++;
     }
+}
+
+// 按等级汇总各条目计数（totals 为 RANK_COUNT + 1 项，最后一项为无效等级）
+static void item_rank_totals(const GachaState* state, long long* totals) {
+    for (int r = 0; r <= RANK_COUNT; r++) {
+        totals[r] = 0;
+    }
+    for (int i = 0; i < state->list->size; i++) {
+        totals[state->rank_table[i]] += gacha_item_count(state, i);
+    }
+}
 
-    // 执行抽取
-    int drawn = 0;
-    for (int i = 0; i < count; i++) {
-        GachaResult result = gacha_draw(state);
-        if (result.name != NULL) {
-            results[i] = result;
-            drawn++;
+// 批量抽取内核
+int gacha_draw_batch(GachaState* state, int count, uint32_t* indices) {
+    if (state == NULL || !state->initialized || state->list == NULL ||
+        state->list->size == 0 || indices == NULL || count <= 0) {
+        return 0;
+    }
+
+    // 一次扣除余额
+    int drawn = count < state->balance ? count : state->balance;
+    if (drawn <= 0) {
+        return 0;
+    }
+    state->balance -= drawn;
+    state->total_draws += drawn;
+
+    // 分块生成序号并计数（块内数据留在缓存中）
+    //   抽取次数不少于条目数时只累加条目计数，由本次前后的条目计数差折算等级，
+    //   省去每次抽取的等级字节写入；否则收集等级字节并用 SSE2 统计直方图
+    int recount = drawn >= state->list->size;
+    long long before[RANK_COUNT + 1];
+    if (recount) {
+        item_rank_totals(state, before);
+    }
+
+    unsigned char ranks[GACHA_BATCH_BLOCK];
+    uint32_t bound = (uint32_t)state->list->size;
+
+    // 计数模式：先多线程生成全部序号（每块的耗时统计此时只含计数）
+    int filled = 0;
+    if (state->threads > 1 && state->rng->mode == RANDOM_MODE_COUNTER && drawn >= GACHA_PARALLEL_MIN) {
+        long long fill_start = trace_begin();
+        filled = fill_parallel(state, bound, indices, drawn) == 0;
+        trace_complete("draw_fill", fill_start, drawn);
+    }
+
+    for (int start = 0; start < drawn; start += GACHA_BATCH_BLOCK) {
+        int block = drawn - start < GACHA_BATCH_BLOCK ? drawn - start : GACHA_BATCH_BLOCK;
+        uint32_t* out = indices + start;
+        long long block_start = trace_begin();
+        long long latency_start = state->block_latency != NULL ? trace_now() : 0;
+
+        if (!filled) {
+            random_fill_bounded(state->rng, bound, out, (size_t)block);
+        }
+        if (recount) {
+            count_block(state, out, block);
         } else {
-            // 余额不足，停止抽取
-            break;
+            gather_block(state, out, block, ranks);
+            rank_histogram(ranks, block, state->rank_counts);
+        }
+        if (state->block_latency != NULL) {
+            record_latency(state, latency_start);
+        }
+        trace_complete("draw_block", block_start, block);
+    }
+
+    if (recount) {
+        long long after[RANK_COUNT + 1];
+        item_rank_totals(state, after);
+        for (int r = 0; r < RANK_COUNT; r++) {
+            state->rank_counts[r] += (int)(after[r] - before[r]);
+        }
+    }
+
+    return drawn;
+}
+
+// 稀疏 Fisher-Yates 中被交换过的位置（开放寻址，key 为 UINT32_MAX 表示空槽）
+typedef struct {
+    uint32_t key;              // 虚拟数组下标
+    uint32_t value;            // 该位置当前的条目序号
+} SwapEntry;
+
+// 查找虚拟数组下标所在的槽位（不存在时返回空槽）
+static SwapEntry* swap_find(SwapEntry* table, uint32_t mask, uint32_t key) {
+    uint32_t slot = (key * 2654435761u) & mask;
+    while (table[slot].key != UINT32_MAX && table[slot].key != key) {
+        slot = (slot + 1) & mask;
+    }
+    return &table[slot];
+}
+
+// 不重复抽取内核
+int gacha_draw_unique(GachaState* state, int count, uint32_t* indices) {
+    if (state == NULL || !state->initialized || state->list == NULL ||
+        state->list->size == 0 || indices == NULL || count <= 0) {
+        return 0;
+    }
+
+    // 不超过余额与条目数
+    uint32_t n = (uint32_t)state->list->size;
+    int drawn = count < state->balance ? count : state->balance;
+    if ((uint32_t)drawn > n) {
+        drawn = (int)n;
+    }
+    if (drawn <= 0) {
+        return 0;
+    }
+
+    // 只记录被交换过的位置，每步最多新增一项，负载因子不超过 1/2
+    //   表大小按 size_t 计算，超过槽位上限（或字节数溢出）时不抽取
+    size_t size = 16;
+    while (size < (size_t)drawn * 2) {
+        if (size >= GACHA_UNIQUE_MAX_SLOTS) {
+            return 0;
         }
+        size *= 2;
+    }
+    if (size > SIZE_MAX / sizeof(SwapEntry)) {
+        return 0;
     }
+    SwapEntry* table = (SwapEntry*)malloc(size * sizeof(SwapEntry));
+    if (table == NULL) {
+        return 0;
+    }
+    uint32_t mask = (uint32_t)(size - 1);
+    for (size_t i = 0; i < size; i++) {
+        table[i].key = UINT32_MAX;
+    }
+
+    state->balance -= drawn;
+    state->total_draws += drawn;
+
+    // 部分 Fisher-Yates：第 i 步从虚拟数组 [i, n) 中随机取一个位置与 i 交换，
+    //   未记录的位置 j 上的条目就是 j；位置 i 之后不再访问，只需写回位置 j（按块计时）
+    for (int start = 0; start < drawn; start += GACHA_BATCH_BLOCK) {
+        int block = drawn - start < GACHA_BATCH_BLOCK ? drawn - start : GACHA_BATCH_BLOCK;
+        long long latency_start = state->block_latency != NULL ? trace_now() : 0;
 
-    *actual_count = drawn;
-    return results;
+        for (uint32_t i = (uint32_t)start; i < (uint32_t)(start + block); i++) {
+            uint32_t j = i + random_bounded(state->rng, n - i);
+
+            SwapEntry* at_i = swap_find(table, mask, i);
+            uint32_t value_i = at_i->key == i ? at_i->value : i;
+
+            SwapEntry* at_j = swap_find(table, mask, j);
+            indices[i] = at_j->key == j ? at_j->value : j;
+            at_j->key = j;
+            at_j->value = value_i;
+        }
+
+        if (state->block_latency != NULL) {
+            record_latency(state, latency_start);
+        }
+    }
+    free(table);
+
+    // 按块收集等级字节并统计直方图
+    unsigned char ranks[GACHA_BATCH_BLOCK];
+    for (int start = 0; start < drawn; start += GACHA_BATCH_BLOCK) {
+        int block = drawn - start < GACHA_BATCH_BLOCK ? drawn - start : GACHA_BATCH_BLOCK;
+        gather_block(state, indices + start, block, ranks);
+        rank_histogram(ranks, block, state->rank_counts);
+    }
+
+    return drawn;
 }
 
 // 检查余额是否足够
@@ -129,7 +484,9 @@ int gacha_check_balance(GachaState* state, int requested_count) {
 
 // 确认是否继续抽卡（余额不足时）
 int gacha_confirm_continue(int balance) {
-    printf("当前余额仅能进行 【%d】 次抽卡，是否继续？（y/n）", balance);
+    // 提示写到 stderr，stdout 重定向或输出机器可读格式时仍能看到
+    fprintf(stderr, "当前余额仅能进行 【%d】 次抽卡，是否继续？（y/n）", balance);
+    fflush(stderr);
 
     char input[10];
     if (fgets(input, sizeof(input), stdin) == NULL) {
@@ -151,39 +508,88 @@ void gacha_get_stats(const GachaState* state, int* rank_counts) {
     memcpy(rank_counts, state->rank_counts, sizeof(state->rank_counts));
 }
 
-// 释放 gacha 状态
-void gacha_free(GachaState* state) {
-    if (state == NULL) {
-        return;
+// 获取条目抽中次数
+long long gacha_item_count(const GachaState* state, int index) {
+    if (state == NULL || state->list == NULL || index < 0 || index >= state->list->size) {
+        return 0;
+    }
+    long long total = 0;
+    for (int lane = 0; lane < GACHA_COUNT_LANES; lane++) {
+        total += state->item_counts[(size_t)index * GACHA_COUNT_LANES + lane];
     }
+    return total;
+}
 
-    if (state->rng != NULL) {
-        random_generator_free(state->rng);
+// 按次数从高到低排序（次数相同时条目序号小者在前）
+static int compare_item_count(const void* a, const void* b) {
+    const GachaItemCount* x = (const GachaItemCount*)a;
+    const GachaItemCount* y = (const GachaItemCount*)b;
+    if (x->count != y->count) {
+        return x->count < y->count ? 1 : -1;
     }
+    return x->item - y->item;
+}
 
-    if (state->list != NULL) {
-        free_gachalist(state->list);
+// 按菜名汇总抽中次数
+int gacha_item_totals(const GachaState* state, GachaItemCount** entries) {
+    if (state == NULL || state->list == NULL || entries == NULL) {
+        return -1;
     }
 
-    free(state);
+    // 抽取循环只按条目序号计数，汇总时再用 (菜名 id, 等级) 的稠密表合并重复行
+    const GachaList* list = state->list;
+    size_t groups = (size_t)string_pool_size(list->names) * (RANK_COUNT + 1);
+    int* group_entry = (int*)malloc((groups > 0 ? groups : 1) * sizeof(int));
+    GachaItemCount* result = (GachaItemCount*)malloc((size_t)list->size * sizeof(GachaItemCount));
+    if (group_entry == NULL || result == NULL) {
+        free(group_entry);
+        free(result);
+        return -1;
+    }
+    for (size_t g = 0; g < groups; g++) {
+        group_entry[g] = -1;
+    }
+
+    int count = 0;
+    for (int i = 0; i < list->size; i++) {
+        long long drawn = gacha_item_count(state, i);
+        if (drawn == 0) {
+            continue;
+        }
+        size_t g = (size_t)list->items[i].name_id * (RANK_COUNT + 1) + state->rank_table[i];
+        if (group_entry[g] < 0) {
+            group_entry[g] = count;
+            result[count].item = i;
+            result[count].count = 0;
+            count++;
+        }
+        result[group_entry[g]].count += drawn;
+    }
+    free(group_entry);
+
+    qsort(result, (size_t)count, sizeof(GachaItemCount), compare_item_count);
+    *entries = result;
+    return count;
 }
 
-// 释放抽取结果
-void gacha_result_free(GachaResult* result) {
-    if (result == NULL) {
+// 释放 gacha 状态
+void gacha_free(GachaState* state) {
+    if (state == NULL) {
         return;
     }
 
-    if (result->name != NULL) {
-        free(result->name);
+    if (state->rng != NULL) {
+        random_generator_free(state->rng);
     }
 
-    if (result->rank != NULL) {
-        free(result->rank);
+    if (state->list != NULL) {
+        free_gachalist(state->list);
     }
 
-    result->name = NULL;
-    result->rank = NULL;
+    free(state->rank_table);
+    free(state->item_counts);
+    histogram_free(state->block_latency);
+    free(state);
 }
 
 // 输出余额信息
@@ -210,7 +616,7 @@ void gacha_output_result(const GachaResult* result) {
 }
 
 // 输出统计信息
-void gacha_output_stats(const GachaState* state) {
+void gacha_output_stats(const GachaState* state, int top) {
     if (state == NULL) {
         return;
     }
@@ -221,4 +627,27 @@ void gacha_output_stats(const GachaState* state) {
     for (int i = 0; i < 5; i++) {
         printf("【%s】%d 次\n", rank_names[i], state->rank_counts[i]);
     }
+
+    if (top <= 0 || state->total_draws <= 0) {
+        return;
+    }
+
+    GachaItemCount* entries = NULL;
+    int count = gacha_item_totals(state, &entries);
+    if (count < 0) {
+        return;
+    }
+    if (top > count) {
+        top = count;
+    }
+
+    printf("\n抽中次数最多的 %d 道菜：\n", top);
+    for (int k = 0; k < top; k++) {
+        int item = entries[k].item;
+        const char* rank = gachalist_item_rank(state->list, item);
+        printf("%3d. 【%s】%s  %lld 次（%.2f%%）\n", k + 1, rank != NULL ? rank : "?",
+               gachalist_item_name(state->list, item), entries[k].count,
+               (double)entries[k].count * 100.0 / state->total_draws);
+    }
+    free(entries);
 }
@@ -1,23 +1,48 @@
 #ifndef GACHA_GACHA_H
 #define GACHA_GACHA_H
 
+#include "histogram.h"
 #include "list.h"
 #include "random.h"
 
-// 抽取结果
+// 批量抽取时每块处理的数量
+#define GACHA_BATCH_BLOCK 4096
+
+// 条目计数路数：相邻的抽取写不同的计数器，同一条目连续抽中时
+//   后一次读取不必等待前一次写入（避免存储转发与内存序冲突拖慢抽取循环）
+#define GACHA_COUNT_LANES 4
+
+// 计数模式下并行生成批量抽取序号
+#define GACHA_MAX_THREADS 64          // 线程数上限
+#define GACHA_PARALLEL_MIN 65536      // 少于此数的批量抽取不开线程
+
+// 不重复抽取的交换表槽位上限（槽位下标与掩码为 32 位，UINT32_MAX 保留为空槽标记）
+#define GACHA_UNIQUE_MAX_SLOTS ((size_t)1 << 31)
+
+// 抽取结果（指向 gachalist 与等级名称，不持有，gacha 状态释放前有效）
 typedef struct {
-    char* name;                // 菜名
-    char* rank;                // 等级
+    const char* name;          // 菜名
+    const char* rank;          // 等级
 } GachaResult;
 
+// 按菜名汇总的抽中次数
+typedef struct {
+    int item;                 // 代表条目序号
+    long long count;          // 抽中次数
+} GachaItemCount;
+
 // gacha 模块状态
 typedef struct {
     GachaList* list;          // gachalist 数据
     RandomGenerator* rng;     // 随机数生成器
     int total_draws;          // 总抽取次数
     int rank_counts[5];       // 各等级抽取次数 [N,R,SR,SSR,UR]
+    unsigned char* rank_table; // 各条目等级索引（批量抽取时按字节收集）
+    uint32_t* item_counts;    // 各条目抽中次数（每个条目 GACHA_COUNT_LANES 路，[条目 * 路数 + 路]）
     int balance;              // 抽卡余额（历史总匹配次数）
     int initialized;          // 是否已初始化
+    int threads;              // 批量抽取的线程数（仅计数模式下并行，结果与单线程逐个抽取相同）
+    Histogram* block_latency; // 每次调用或每块的耗时分布（纳秒，NULL 表示未启用）
 } GachaState;
 
 // 核心函数
@@ -28,8 +53,19 @@ GachaState* gacha_init(const char* gachalist_path, int balance);
 // 从 gachalist 中随机抽取一个
 GachaResult gacha_draw(GachaState* state);
 
-// 批量抽取
-GachaResult* gacha_draw_multiple(GachaState* state, int count, int* actual_count);
+// 批量抽取内核：一次扣除余额，把抽中的条目序号写入 indices，返回实际抽取次数
+//   随机数生成器为计数模式且 threads > 1 时按序号分段并行生成，结果与单线程相同
+int gacha_draw_batch(GachaState* state, int count, uint32_t* indices);
+
+// 不重复抽取内核：抽取 count 个互不相同的条目（稀疏部分 Fisher-Yates，O(count) 时间与内存），
+//   一次扣除余额，返回实际抽取次数（不超过余额与条目数）；交换表超过槽位上限或内存不足时返回 0
+int gacha_draw_unique(GachaState* state, int count, uint32_t* indices);
+
+// 启用抽取耗时统计，失败返回 -1
+int gacha_enable_latency(GachaState* state);
+
+// 设置批量抽取的线程数（1 ~ GACHA_MAX_THREADS，只在计数模式下生效）
+void gacha_set_threads(GachaState* state, int threads);
 
 // 检查余额是否足够
 int gacha_check_balance(GachaState* state, int requested_count);
@@ -40,12 +76,16 @@ int gacha_confirm_continue(int balance);
 // 获取抽取统计
 void gacha_get_stats(const GachaState* state, int* rank_counts);
 
+// 获取条目抽中次数
+long long gacha_item_count(const GachaState* state, int index);
+
+// 按菜名汇总抽中次数（同名同等级的重复行合并），返回汇总条数，失败返回 -1
+//   entries 由调用方释放，每项为代表条目序号（该组中第一个被抽中的行）与次数，按次数从高到低排列
+int gacha_item_totals(const GachaState* state, GachaItemCount** entries);
+
 // 释放 gacha 状态
 void gacha_free(GachaState* state);
 
-// 释放抽取结果
-void gacha_result_free(GachaResult* result);
-
 // 输出余额信息
 void gacha_output_balance(int balance);
 
@@ -55,7 +95,7 @@ void gacha_output_remaining_balance(int balance);
 // 输出抽取结果
 void gacha_output_result(const GachaResult* result);
 
-// 输出统计信息
-void gacha_output_stats(const GachaState* state);
+// 输出统计信息（top > 0 时另外列出抽中次数最多的 top 道菜）
+void gacha_output_stats(const GachaState* state, int top);
 
 #endif // GACHA_GACHA_H
@@ -0,0 +1,174 @@
+#include "histogram.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+
+// 每个 2 的幂区间的桶数
+#define HALF_COUNT (HISTOGRAM_SUB_COUNT / 2)
+
+// 输出分位数
+static const double PERCENTILE_LEVELS[HISTOGRAM_PERCENTILE_COUNT] = {0.5, 0.9, 0.99, 0.999};
+static const char* PERCENTILE_NAMES[HISTOGRAM_PERCENTILE_COUNT] = {"p50", "p90", "p99", "p99.9"};
+
+// 最高有效位的位置（value > 0）
+static inline int highest_bit(uint64_t value) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+// 样本所在的桶：小于 HISTOGRAM_SUB_COUNT 的值各占一个桶，
+//   更大的值右移到 [HALF_COUNT, HISTOGRAM_SUB_COUNT) 后按移位数分段
+static inline int bucket_of(long long value) {
+    if (value < HISTOGRAM_SUB_COUNT) {
+        return value < 0 ? 0 : (int)value;
+    }
+
+    uint64_t v = (uint64_t)value;
+    if (v >> HISTOGRAM_MAX_BITS) {
+        v = ((uint64_t)1 << HISTOGRAM_MAX_BITS) - 1;
+    }
+    int shift = highest_bit(v) - (HISTOGRAM_SUB_BITS - 1);
+    return shift * HALF_COUNT + (int)(v >> shift);
+}
+
+// 桶内的最大值
+static long long bucket_upper(int bucket) {
+    if (bucket < HISTOGRAM_SUB_COUNT) {
+        return bucket;
+    }
+    int shift = bucket / HALF_COUNT - 1;
+    long long sub = bucket - shift * HALF_COUNT;
+    return ((sub + 1) << shift) - 1;
+}
+
+// 创建空直方图
+Histogram* histogram_create() {
+    Histogram* h = (Histogram*)malloc(sizeof(Histogram));
+    if (h == NULL) {
+        return NULL;
+    }
+    histogram_reset(h);
+    return h;
+}
+
+// 清空直方图
+void histogram_reset(Histogram* h) {
+    if (h == NULL) {
+        return;
+    }
+    memset(h, 0, sizeof(Histogram));
+}
+
+// 记录 count 个相同的样本
+void histogram_record_n(Histogram* h, long long value, long long count) {
+    if (h == NULL || count <= 0) {
+        return;
+    }
+    if (value < 0) {
+        value = 0;
+    }
+
+    h->counts[bucket_of(value)] += count;
+    if (h->total == 0 || value < h->min) {
+        h->min = value;
+    }
+    if (value > h->max) {
+        h->max = value;
+    }
+    h->total += count;
+    h->sum += (double)value * (double)count;
+}
+
+// 记录一个样本
+void histogram_record(Histogram* h, long long value) {
+    histogram_record_n(h, value, 1);
+}
+
+// 合并直方图
+void histogram_merge(Histogram* dst, const Histogram* src) {
+    if (dst == NULL || src == NULL || src->total == 0) {
+        return;
+    }
+
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    if (dst->total == 0 || src->min < dst->min) {
+        dst->min = src->min;
+    }
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+    dst->total += src->total;
+    dst->sum += src->sum;
+}
+
+// 分位数
+long long histogram_percentile(const Histogram* h, double q) {
+    if (h == NULL || h->total == 0) {
+        return 0;
+    }
+
+    // 第 ceil(q * total) 个样本（至少第 1 个）
+    long long rank = (long long)(q * (double)h->total);
+    if ((double)rank < q * (double)h->total) {
+        rank++;
+    }
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    long long seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            long long upper = bucket_upper(i);
+            if (upper > h->max) {
+                upper = h->max;
+            }
+            return upper < h->min ? h->min : upper;
+        }
+    }
+    return h->max;
+}
+
+// 第 k 个输出分位数
+double histogram_percentile_level(int k) {
+    if (k < 0 || k >= HISTOGRAM_PERCENTILE_COUNT) {
+        return 0.0;
+    }
+    return PERCENTILE_LEVELS[k];
+}
+
+// 输出一行统计
+void histogram_print(FILE* fp, const Histogram* h, const char* unit) {
+    if (fp == NULL || h == NULL) {
+        return;
+    }
+    if (h->total == 0) {
+        fprintf(fp, "无样本\n");
+        return;
+    }
+
+    fprintf(fp, "%lld 个样本，平均 %.6g%s", h->total, h->sum / (double)h->total, unit);
+    for (int k = 0; k < HISTOGRAM_PERCENTILE_COUNT; k++) {
+        fprintf(fp, "，%s %lld%s", PERCENTILE_NAMES[k], histogram_percentile(h, PERCENTILE_LEVELS[k]), unit);
+    }
+    fprintf(fp, "，最大 %lld%s\n", h->max, unit);
+}
+
+// 释放直方图
+void histogram_free(Histogram* h) {
+    if (h != NULL) {
+        free(h);
+    }
+}
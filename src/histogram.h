@@ -0,0 +1,57 @@
+#ifndef GACHA_HISTOGRAM_H
+#define GACHA_HISTOGRAM_H
+
+#include <stdio.h>
+
+// 对数分桶参数：每个 2 的幂区间再均分为 HISTOGRAM_SUB_COUNT / 2 个桶，
+//   相对误差不超过 1 / (HISTOGRAM_SUB_COUNT / 2)（约 1.6%）
+#define HISTOGRAM_SUB_BITS 7
+#define HISTOGRAM_SUB_COUNT (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_MAX_BITS 40        // 可区分的最大值 2^40 - 1（更大的值计入最后一个桶）
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 2) * (HISTOGRAM_SUB_COUNT / 2))
+
+// 输出的分位数个数（p50 / p90 / p99 / p99.9）
+#define HISTOGRAM_PERCENTILE_COUNT 4
+
+// chaos 模式 --histogram 单独列出分布的单词数（按匹配次数从高到低）
+#define HISTOGRAM_TOP_WORDS 10
+
+// HDR 直方图（固定内存，记录 O(1)，同参数的直方图可直接合并）
+typedef struct {
+    long long counts[HISTOGRAM_BUCKETS]; // 各桶样本数
+    long long total;                 // 样本数
+    long long min;                   // 最小值
+    long long max;                   // 最大值
+    double sum;                      // 样本和（求平均）
+} Histogram;
+
+// 核心函数
+
+// 创建空直方图
+Histogram* histogram_create();
+
+// 清空直方图
+void histogram_reset(Histogram* h);
+
+// 记录一个非负样本（负值按 0 计）
+void histogram_record(Histogram* h, long long value);
+
+// 记录 count 个相同的样本
+void histogram_record_n(Histogram* h, long long value, long long count);
+
+// 把 src 的样本合并到 dst（用于汇总各线程或各单词的直方图）
+void histogram_merge(Histogram* dst, const Histogram* src);
+
+// 分位数 q（0 ~ 1）：至少 q 比例的样本不超过返回值（按所在桶的上界，不超过最大值），没有样本时返回 0
+long long histogram_percentile(const Histogram* h, double q);
+
+// 第 k 个输出分位数（0.5、0.9、0.99、0.999）
+double histogram_percentile_level(int k);
+
+// 输出一行统计：样本数、平均、p50 / p90 / p99 / p99.9 与最大值（unit 为数值后的单位）
+void histogram_print(FILE* fp, const Histogram* h, const char* unit);
+
+// 释放直方图
+void histogram_free(Histogram* h);
+
+#endif // GACHA_HISTOGRAM_H
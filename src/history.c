@@ -0,0 +1,543 @@
+#include "history.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+    #include <sys/stat.h>
+    #include <windows.h>
+    #define history_read _read
+    #define history_write _write
+    #define history_close_fd _close
+#else
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define history_read read
+    #define history_write write
+    #define history_close_fd close
+#endif
+
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+
+#include "alloc.h"
+
+// 每次扫描调用处理的最大记录数（32 位向量计数器不会溢出）
+#define HISTORY_SCAN_CHUNK (1 << 24)
+
+// 32 位小端与本机字节序互转（小端主机上即原值）
+static inline uint32_t le32(uint32_t value) {
+    const unsigned char* b = (const unsigned char*)&value;
+    return (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+}
+
+// 获取历史文件路径
+char* get_history_path() {
+    char* config_path = get_config_path();
+    if (config_path == NULL) {
+        return NULL;
+    }
+
+    char* path = resolve_config_relative_path(config_path, HISTORY_FILE_NAME);
+    free(config_path);
+    return path;
+}
+
+// 写入完整缓冲区
+static int write_all(int fd, const void* data, size_t length) {
+    const char* p = (const char*)data;
+    while (length > 0) {
+        int chunk = length > (1u << 30) ? (1 << 30) : (int)length;
+        int written = (int)history_write(fd, p, chunk);
+        if (written <= 0) {
+            return -1;
+        }
+        p += written;
+        length -= (size_t)written;
+    }
+    return 0;
+}
+
+// 读取完整缓冲区
+static int read_all(int fd, void* data, size_t length) {
+    char* p = (char*)data;
+    while (length > 0) {
+        int chunk = length > (1u << 30) ? (1 << 30) : (int)length;
+        int got = (int)history_read(fd, p, chunk);
+        if (got <= 0) {
+            return -1;
+        }
+        p += got;
+        length -= (size_t)got;
+    }
+    return 0;
+}
+
+// 定位到文件中的绝对位置
+static int seek_to(int fd, long long offset) {
+#ifdef _WIN32
+    return _lseeki64(fd, offset, SEEK_SET) < 0 ? -1 : 0;
+#else
+    return lseek(fd, (off_t)offset, SEEK_SET) < 0 ? -1 : 0;
+#endif
+}
+
+// 文件大小
+static long long file_size(int fd) {
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_fstat64(fd, &st) != 0) {
+        return -1;
+    }
+#else
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return -1;
+    }
+#endif
+    return (long long)st.st_size;
+}
+
+// 独占文件锁（阻塞等待）：多个进程同时抽卡时，文件头检查、截断、会话分配与每次组提交互斥
+static int lock_file(int fd) {
+#ifdef _WIN32
+    OVERLAPPED overlapped;
+    memset(&overlapped, 0, sizeof(overlapped));
+    HANDLE handle = (HANDLE)_get_osfhandle(fd);
+    return LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped) ? 0 : -1;
+#else
+    return flock(fd, LOCK_EX) == 0 ? 0 : -1;
+#endif
+}
+
+// 释放文件锁
+static void unlock_file(int fd) {
+#ifdef _WIN32
+    OVERLAPPED overlapped;
+    memset(&overlapped, 0, sizeof(overlapped));
+    UnlockFileEx((HANDLE)_get_osfhandle(fd), 0, MAXDWORD, MAXDWORD, &overlapped);
+#else
+    flock(fd, LOCK_UN);
+#endif
+}
+
+// 截掉写入中断留下的不完整记录（持有文件锁时调用），返回截断后的文件大小，失败返回 -1
+//   其他进程只在持锁时写入，因此不完整的尾部只可能来自崩溃的写入者
+static long long repair_tail(int fd) {
+    long long size = file_size(fd);
+    if (size < HISTORY_HEADER_SIZE) {
+        return -1;
+    }
+
+    long long tail = (size - HISTORY_HEADER_SIZE) % HISTORY_RECORD_SIZE;
+    if (tail != 0) {
+        size -= tail;
+#ifdef _WIN32
+        if (_chsize_s(fd, size) != 0) {
+            return -1;
+        }
+#else
+        if (ftruncate(fd, (off_t)size) != 0) {
+            return -1;
+        }
+#endif
+    }
+    return size;
+}
+
+// 构造文件头
+static void make_header(char* header) {
+    memset(header, 0, HISTORY_HEADER_SIZE);
+    memcpy(header, HISTORY_MAGIC, 8);
+    header[8] = (char)HISTORY_VERSION;
+    header[12] = (char)HISTORY_RECORD_SIZE;
+}
+
+// 校验文件头
+static int check_header(const char* header) {
+    char expected[HISTORY_HEADER_SIZE];
+    make_header(expected);
+    return memcmp(header, expected, HISTORY_HEADER_SIZE) == 0 ? 0 : -1;
+}
+
+// 打开历史文件准备追加
+HistoryWriter* history_open(const char* path) {
+    if (path == NULL) {
+        return NULL;
+    }
+
+    // 追加模式：每次写入都落在当时的文件末尾，不会覆盖其他进程的记录
+#ifdef _WIN32
+    int fd = _open(path, _O_RDWR | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+#endif
+    if (fd < 0) {
+        return NULL;
+    }
+    if (lock_file(fd) != 0) {
+        history_close_fd(fd);
+        return NULL;
+    }
+
+    char header[HISTORY_HEADER_SIZE];
+    long long size = file_size(fd);
+    int valid = 0;
+    if (size == 0) {
+        // 新文件：写入文件头
+        make_header(header);
+        valid = write_all(fd, header, HISTORY_HEADER_SIZE) == 0;
+    } else if (size >= HISTORY_HEADER_SIZE && seek_to(fd, 0) == 0 &&
+               read_all(fd, header, HISTORY_HEADER_SIZE) == 0 && check_header(header) == 0) {
+        valid = repair_tail(fd) >= 0;
+    } else {
+        fprintf(stderr, "错误: %s 不是有效的抽卡历史文件\n", path);
+    }
+    unlock_file(fd);
+
+    if (!valid) {
+        history_close_fd(fd);
+        return NULL;
+    }
+
+    HistoryWriter* writer = (HistoryWriter*)malloc(sizeof(HistoryWriter));
+    if (writer == NULL) {
+        history_close_fd(fd);
+        return NULL;
+    }
+
+    writer->batch = (HistoryRecord*)malloc(HISTORY_BATCH_RECORDS * sizeof(HistoryRecord));
+    if (writer->batch == NULL) {
+        free(writer);
+        history_close_fd(fd);
+        return NULL;
+    }
+
+    writer->fd = fd;
+    writer->session = 0;
+    writer->batch_len = 0;
+    writer->error = 0;
+
+    return writer;
+}
+
+// 分配会话 id（持有文件锁时调用）：最后一条记录的会话 + 1
+//   首次提交时才分配，同时运行的进程先提交者先得，之后提交的进程看到的最后一条记录已是前者的会话
+static int allocate_session(HistoryWriter* writer, long long size) {
+    uint32_t last_session = 0;
+    if (size >= HISTORY_HEADER_SIZE + HISTORY_RECORD_SIZE) {
+        HistoryRecord last;
+        if (seek_to(writer->fd, size - HISTORY_RECORD_SIZE) != 0 ||
+            read_all(writer->fd, &last, HISTORY_RECORD_SIZE) != 0) {
+            return -1;
+        }
+        last_session = le32(last.session);
+    }
+    writer->session = last_session + 1;
+    return 0;
+}
+
+// 提交缓冲的记录（持锁写入，同一批记录在文件中连续）
+static void history_commit(HistoryWriter* writer) {
+    if (writer->batch_len > 0 && !writer->error) {
+        if (lock_file(writer->fd) != 0) {
+            writer->error = 1;
+        } else {
+            long long size = repair_tail(writer->fd);
+            if (size < 0 || (writer->session == 0 && allocate_session(writer, size) != 0)) {
+                writer->error = 1;
+            } else {
+                uint32_t session = le32(writer->session);
+                for (int i = 0; i < writer->batch_len; i++) {
+                    writer->batch[i].session = session;
+                }
+                if (write_all(writer->fd, writer->batch, (size_t)writer->batch_len * HISTORY_RECORD_SIZE) != 0) {
+                    writer->error = 1;
+                }
+            }
+            unlock_file(writer->fd);
+        }
+    }
+    writer->batch_len = 0;
+}
+
+// 追加一条记录
+void history_append(HistoryWriter* writer, uint32_t timestamp, uint32_t item, int rank) {
+    if (writer == NULL) {
+        return;
+    }
+
+    HistoryRecord* record = &writer->batch[writer->batch_len++];
+    record->timestamp = le32(timestamp);
+    record->session = 0;           // 提交时填入
+    record->item = le32(item);
+    record->rank = (uint8_t)rank;
+    record->reserved[0] = 0;
+    record->reserved[1] = 0;
+    record->reserved[2] = 0;
+
+    if (writer->batch_len == HISTORY_BATCH_RECORDS) {
+        history_commit(writer);
+    }
+}
+
+// 提交剩余记录、同步到磁盘并关闭
+int history_close(HistoryWriter* writer) {
+    if (writer == NULL) {
+        return -1;
+    }
+
+    history_commit(writer);
+
+    // 一次会话只同步一次
+#ifdef _WIN32
+    if (_commit(writer->fd) != 0) {
+        writer->error = 1;
+    }
+#else
+    if (fsync(writer->fd) != 0) {
+        writer->error = 1;
+    }
+#endif
+
+    int result = writer->error ? -1 : 0;
+    history_close_fd(writer->fd);
+    free(writer->batch);
+    free(writer);
+    return result;
+}
+
+// 统计一段记录
+static void scan_records(const HistoryRecord* records, size_t count, HistoryQuery* query) {
+    size_t i = 0;
+    uint32_t first = query->first_time;
+    uint32_t last = query->last_time;
+
+#ifdef __SSE2__
+    // 每次 4 条记录：转置成时间、会话、条目、等级四个向量后比较计数
+    //   SSE2 只在小端的 x86 上可用，记录直接按本机字节序读取；SSE2 只有有符号比较，时间先翻转符号位
+    const __m128i sign = _mm_set1_epi32((int)0x80000000u);
+    const __m128i since = _mm_set1_epi32((int)(query->since ^ 0x80000000u));
+    const __m128i until = _mm_set1_epi32((int)(query->until ^ 0x80000000u));
+    const __m128i low_byte = _mm_set1_epi32(0xFF);
+    __m128i acc[5];
+    for (int k = 0; k < 5; k++) {
+        acc[k] = _mm_setzero_si128();
+    }
+    __m128i min_time = _mm_set1_epi32((int)(first ^ 0x80000000u));
+    __m128i max_time = _mm_set1_epi32((int)(last ^ 0x80000000u));
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i r0 = _mm_loadu_si128((const __m128i*)(records + i));
+        __m128i r1 = _mm_loadu_si128((const __m128i*)(records + i + 1));
+        __m128i r2 = _mm_loadu_si128((const __m128i*)(records + i + 2));
+        __m128i r3 = _mm_loadu_si128((const __m128i*)(records + i + 3));
+
+        // 取出时间（第 0 列）与等级字（第 3 列）
+        __m128i t01 = _mm_unpacklo_epi32(r0, r1);
+        __m128i t23 = _mm_unpacklo_epi32(r2, r3);
+        __m128i k01 = _mm_unpackhi_epi32(r0, r1);
+        __m128i k23 = _mm_unpackhi_epi32(r2, r3);
+        __m128i time = _mm_xor_si128(_mm_unpacklo_epi64(t01, t23), sign);
+        __m128i rank = _mm_and_si128(_mm_unpackhi_epi64(k01, k23), low_byte);
+
+        // since <= time < until
+        __m128i in_range = _mm_andnot_si128(_mm_cmplt_epi32(time, since), _mm_cmplt_epi32(time, until));
+
+        for (int k = 0; k < 5; k++) {
+            __m128i hit = _mm_and_si128(_mm_cmpeq_epi32(rank, _mm_set1_epi32(k)), in_range);
+            acc[k] = _mm_sub_epi32(acc[k], hit);
+        }
+
+        // 范围内的最早与最晚时间（范围外的记录用当前值代替）
+        __m128i lower = _mm_or_si128(_mm_and_si128(in_range, time), _mm_andnot_si128(in_range, min_time));
+        __m128i upper = _mm_or_si128(_mm_and_si128(in_range, time), _mm_andnot_si128(in_range, max_time));
+        __m128i less = _mm_cmplt_epi32(lower, min_time);
+        __m128i greater = _mm_cmpgt_epi32(upper, max_time);
+        min_time = _mm_or_si128(_mm_and_si128(less, lower), _mm_andnot_si128(less, min_time));
+        max_time = _mm_or_si128(_mm_and_si128(greater, upper), _mm_andnot_si128(greater, max_time));
+    }
+
+    uint32_t lanes[4];
+    for (int k = 0; k < 5; k++) {
+        _mm_storeu_si128((__m128i*)lanes, acc[k]);
+        long long sum = (long long)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        query->rank_counts[k] += sum;
+        query->matched += sum;
+    }
+    _mm_storeu_si128((__m128i*)lanes, min_time);
+    for (int l = 0; l < 4; l++) {
+        if ((lanes[l] ^ 0x80000000u) < first) {
+            first = lanes[l] ^ 0x80000000u;
+        }
+    }
+    _mm_storeu_si128((__m128i*)lanes, max_time);
+    for (int l = 0; l < 4; l++) {
+        if ((lanes[l] ^ 0x80000000u) > last) {
+            last = lanes[l] ^ 0x80000000u;
+        }
+    }
+#endif
+
+    // 尾部（或不支持 SSE2 时的全部记录）
+    for (; i < count; i++) {
+        const HistoryRecord* r = &records[i];
+        uint32_t timestamp = le32(r->timestamp);
+        if (timestamp < query->since || timestamp >= query->until) {
+            continue;
+        }
+        if (r->rank < 5) {
+            query->rank_counts[r->rank]++;
+            query->matched++;
+        }
+        if (timestamp < first) {
+            first = timestamp;
+        }
+        if (timestamp > last) {
+            last = timestamp;
+        }
+    }
+
+    query->first_time = first;
+    query->last_time = last;
+
+    // 按条目统计（散列写入无法向量化，单独扫描）
+    if (query->item_counts != NULL) {
+        for (i = 0; i < count; i++) {
+            const HistoryRecord* r = &records[i];
+            uint32_t timestamp = le32(r->timestamp);
+            uint32_t item = le32(r->item);
+            if (timestamp >= query->since && timestamp < query->until &&
+                item < (uint32_t)query->item_count) {
+                query->item_counts[item]++;
+            }
+        }
+    }
+}
+
+// 打开历史文件并校验文件头，返回记录数（失败返回 -1）
+static long long open_for_read(const char* path, int* fd_out) {
+#ifdef _WIN32
+    int fd = _open(path, _O_RDONLY | _O_BINARY);
+#else
+    int fd = open(path, O_RDONLY);
+#endif
+    if (fd < 0) {
+        return -1;
+    }
+
+    char header[HISTORY_HEADER_SIZE];
+    long long size = file_size(fd);
+    if (size < HISTORY_HEADER_SIZE || read_all(fd, header, HISTORY_HEADER_SIZE) != 0 ||
+        check_header(header) != 0) {
+        history_close_fd(fd);
+        return -1;
+    }
+
+    *fd_out = fd;
+    return (size - HISTORY_HEADER_SIZE) / HISTORY_RECORD_SIZE;
+}
+
+// 映射历史文件并按时间范围统计
+int history_query(const char* path, HistoryQuery* query) {
+    if (path == NULL || query == NULL) {
+        return -1;
+    }
+
+    query->total = 0;
+    query->matched = 0;
+    memset(query->rank_counts, 0, sizeof(query->rank_counts));
+    query->first_time = UINT32_MAX;
+    query->last_time = 0;
+
+    int fd;
+    long long count = open_for_read(path, &fd);
+    if (count < 0) {
+        return -1;
+    }
+    query->total = count;
+    if (count == 0) {
+        history_close_fd(fd);
+        return 0;
+    }
+
+#ifdef _WIN32
+    // Windows 下分块读入
+    HistoryRecord* chunk = (HistoryRecord*)malloc((size_t)HISTORY_SCAN_CHUNK * sizeof(HistoryRecord));
+    if (chunk == NULL) {
+        history_close_fd(fd);
+        return -1;
+    }
+    for (long long done = 0; done < count; ) {
+        size_t n = count - done < HISTORY_SCAN_CHUNK ? (size_t)(count - done) : HISTORY_SCAN_CHUNK;
+        if (read_all(fd, chunk, n * sizeof(HistoryRecord)) != 0) {
+            free(chunk);
+            history_close_fd(fd);
+            return -1;
+        }
+        scan_records(chunk, n, query);
+        done += (long long)n;
+    }
+    free(chunk);
+    history_close_fd(fd);
+#else
+    size_t length = (size_t)(HISTORY_HEADER_SIZE + count * HISTORY_RECORD_SIZE);
+    void* data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    history_close_fd(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(data, length, MADV_SEQUENTIAL);
+#endif
+
+    const HistoryRecord* records = (const HistoryRecord*)((const char*)data + HISTORY_HEADER_SIZE);
+    for (long long done = 0; done < count; done += HISTORY_SCAN_CHUNK) {
+        size_t n = count - done < HISTORY_SCAN_CHUNK ? (size_t)(count - done) : HISTORY_SCAN_CHUNK;
+        scan_records(records + done, n, query);
+    }
+    munmap(data, length);
+#endif
+
+    return 0;
+}
+
+// 读取最后 count 条记录
+int history_last(const char* path, int count, HistoryRecord** records) {
+    if (path == NULL || records == NULL || count < 0) {
+        return -1;
+    }
+    *records = NULL;
+
+    int fd;
+    long long total = open_for_read(path, &fd);
+    if (total < 0) {
+        return -1;
+    }
+
+    int n = total < count ? (int)total : count;
+    HistoryRecord* result = (HistoryRecord*)malloc((size_t)(n > 0 ? n : 1) * sizeof(HistoryRecord));
+    if (result == NULL ||
+        seek_to(fd, HISTORY_HEADER_SIZE + (total - n) * HISTORY_RECORD_SIZE) != 0 ||
+        read_all(fd, result, (size_t)n * sizeof(HistoryRecord)) != 0) {
+        free(result);
+        history_close_fd(fd);
+        return -1;
+    }
+
+    history_close_fd(fd);
+    for (int i = 0; i < n; i++) {
+        result[i].timestamp = le32(result[i].timestamp);
+        result[i].session = le32(result[i].session);
+        result[i].item = le32(result[i].item);
+    }
+    *records = result;
+    return n;
+}
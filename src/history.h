@@ -0,0 +1,72 @@
+#ifndef GACHA_HISTORY_H
+#define GACHA_HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 抽卡历史记录（定长 16 字节，整数在文件中为小端，直接映射到文件）
+typedef struct {
+    uint32_t timestamp;        // 抽取时间（Unix 秒）
+    uint32_t session;          // 会话 id（每次 gacha 运行递增）
+    uint32_t item;             // 条目序号（gachalist 中的行序号）
+    uint8_t rank;              // 等级索引 [N,R,SR,SSR,UR]
+    uint8_t reserved[3];       // 保留（填 0）
+} HistoryRecord;
+
+// 文件头（16 字节）：魔数、版本、记录长度
+#define HISTORY_MAGIC "GACHAHST"
+#define HISTORY_VERSION 1
+#define HISTORY_HEADER_SIZE 16
+#define HISTORY_RECORD_SIZE 16
+
+// 历史文件名（与 gacha.conf 同目录）
+#define HISTORY_FILE_NAME "history.log"
+
+// 组提交：缓冲这么多条记录后一次写入
+#define HISTORY_BATCH_RECORDS 4096
+
+// 追加写入器
+typedef struct {
+    int fd;                    // 文件描述符（追加模式）
+    uint32_t session;          // 本次会话 id（首次提交时在文件锁内分配，0 表示尚未分配）
+    HistoryRecord* batch;      // 待提交的记录
+    int batch_len;             // 待提交记录数
+    int error;                 // 是否发生写入错误
+} HistoryWriter;
+
+// 查询条件与结果
+typedef struct {
+    uint32_t since;            // 起始时间（含）
+    uint32_t until;            // 结束时间（不含）
+    int item_count;            // 条目计数数组长度（0 表示不按条目统计）
+
+    long long total;           // 日志中的记录总数
+    long long matched;         // 满足时间范围的记录数
+    long long rank_counts[5];  // 各等级次数
+    long long* item_counts;    // 各条目次数（item_count 个，超出范围的条目不计）
+    uint32_t first_time;       // 满足条件的最早记录时间
+    uint32_t last_time;        // 满足条件的最晚记录时间
+} HistoryQuery;
+
+// 核心函数
+
+// 获取历史文件路径
+char* get_history_path();
+
+// 打开历史文件准备追加（不存在时创建），持独占文件锁检查文件头并截掉中断写入留下的尾部
+//   会话 id 在首次提交时持锁分配（上一条记录的会话 + 1），多个进程同时抽卡时互不覆盖、不会重号
+HistoryWriter* history_open(const char* path);
+
+// 追加一条记录（缓冲，满一批时持锁追加写入）
+void history_append(HistoryWriter* writer, uint32_t timestamp, uint32_t item, int rank);
+
+// 提交剩余记录、同步到磁盘并关闭，发生错误时返回 -1
+int history_close(HistoryWriter* writer);
+
+// 映射历史文件并按时间范围统计（各等级与各条目次数），失败返回 -1
+int history_query(const char* path, HistoryQuery* query);
+
+// 读取最后 count 条记录（已转换为本机字节序），返回实际条数（records 由调用方释放），失败返回 -1
+int history_last(const char* path, int count, HistoryRecord** records);
+
+#endif // GACHA_HISTORY_H
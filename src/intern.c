@@ -0,0 +1,224 @@
+#include "intern.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+
+// FNV-1a 哈希
+static unsigned int hash_bytes(const char* str, size_t len) {
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)str[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// 比较池中字符串与给定内容
+static int pool_equals(const StringPool* pool, int id, unsigned int hash,
+                       const char* str, size_t len) {
+    if (pool->hashes[id] != hash) {
+        return 0;
+    }
+    const char* stored = pool->strings[id];
+    return strncmp(stored, str, len) == 0 && stored[len] == '\0';
+}
+
+// 在存储块中分配空间
+static char* pool_alloc_chars(StringPool* pool, size_t size) {
+    InternBlock* block = pool->blocks;
+
+    if (block == NULL || block->capacity - block->used < size) {
+        // 超长字符串单独占用一个块
+        size_t capacity = size > INTERN_BLOCK_SIZE ? size : INTERN_BLOCK_SIZE;
+        InternBlock* new_block = (InternBlock*)malloc(sizeof(InternBlock) + capacity);
+        if (new_block == NULL) {
+            return NULL;
+        }
+        new_block->used = 0;
+        new_block->capacity = capacity;
+
+        if (block != NULL && capacity > INTERN_BLOCK_SIZE) {
+            // 超长块挂在当前块之后，当前块继续使用
+            new_block->next = block->next;
+            block->next = new_block;
+        } else {
+            new_block->next = block;
+            pool->blocks = new_block;
+        }
+        block = new_block;
+    }
+
+    char* ptr = block->data + block->used;
+    block->used += size;
+    return ptr;
+}
+
+// 哈希表扩容
+static int pool_grow_table(StringPool* pool) {
+    int new_size = pool->table_size * 2;
+    int* new_table = (int*)malloc(new_size * sizeof(int));
+    if (new_table == NULL) {
+        return -1;
+    }
+    memset(new_table, -1, new_size * sizeof(int));
+
+    int mask = new_size - 1;
+    for (int id = 0; id < pool->count; id++) {
+        int slot = (int)(pool->hashes[id] & (unsigned int)mask);
+        while (new_table[slot] >= 0) {
+            slot = (slot + 1) & mask;
+        }
+        new_table[slot] = id;
+    }
+
+    free(pool->table);
+    pool->table = new_table;
+    pool->table_size = new_size;
+    return 0;
+}
+
+// 创建字符串池
+StringPool* string_pool_create() {
+    StringPool* pool = (StringPool*)malloc(sizeof(StringPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    pool->count = 0;
+    pool->capacity = 0;
+    pool->strings = NULL;
+    pool->hashes = NULL;
+    pool->blocks = NULL;
+
+    pool->table_size = INTERN_INITIAL_TABLE;
+    pool->table = (int*)malloc(pool->table_size * sizeof(int));
+    if (pool->table == NULL) {
+        free(pool);
+        return NULL;
+    }
+    memset(pool->table, -1, pool->table_size * sizeof(int));
+
+    return pool;
+}
+
+// 查找字符串 id
+int string_pool_find(const StringPool* pool, const char* str, size_t len) {
+    if (pool == NULL || str == NULL) {
+        return -1;
+    }
+
+    unsigned int hash = hash_bytes(str, len);
+    int mask = pool->table_size - 1;
+    int slot = (int)(hash & (unsigned int)mask);
+
+    while (pool->table[slot] >= 0) {
+        if (pool_equals(pool, pool->table[slot], hash, str, len)) {
+            return pool->table[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    return -1;
+}
+
+// 驻留字符串
+int string_pool_intern(StringPool* pool, const char* str, size_t len) {
+    if (pool == NULL || str == NULL) {
+        return -1;
+    }
+
+    unsigned int hash = hash_bytes(str, len);
+    int mask = pool->table_size - 1;
+    int slot = (int)(hash & (unsigned int)mask);
+
+    // 已存在则直接返回
+    while (pool->table[slot] >= 0) {
+        if (pool_equals(pool, pool->table[slot], hash, str, len)) {
+            return pool->table[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    // 负载因子超过 1/2 时先扩容，再重新定位空槽
+    if ((pool->count + 1) * 2 > pool->table_size) {
+        if (pool_grow_table(pool) != 0) {
+            return -1;
+        }
+        mask = pool->table_size - 1;
+        slot = (int)(hash & (unsigned int)mask);
+        while (pool->table[slot] >= 0) {
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    // 扩展 id 数组
+    if (pool->count >= pool->capacity) {
+        int new_capacity = pool->capacity > 0 ? pool->capacity * 2 : 64;
+        const char** new_strings = (const char**)realloc((void*)pool->strings,
+                                                         new_capacity * sizeof(char*));
+        if (new_strings == NULL) {
+            return -1;
+        }
+        pool->strings = new_strings;
+
+        unsigned int* new_hashes = (unsigned int*)realloc(pool->hashes,
+                                                          new_capacity * sizeof(unsigned int));
+        if (new_hashes == NULL) {
+            return -1;
+        }
+        pool->hashes = new_hashes;
+        pool->capacity = new_capacity;
+    }
+
+    // 复制字符到存储块
+    char* stored = pool_alloc_chars(pool, len + 1);
+    if (stored == NULL) {
+        return -1;
+    }
+    memcpy(stored, str, len);
+    stored[len] = '\0';
+
+    int id = pool->count++;
+    pool->strings[id] = stored;
+    pool->hashes[id] = hash;
+    pool->table[slot] = id;
+
+    return id;
+}
+
+// 根据 id 获取字符串
+const char* string_pool_get(const StringPool* pool, int id) {
+    if (pool == NULL || id < 0 || id >= pool->count) {
+        return NULL;
+    }
+    return pool->strings[id];
+}
+
+// 获取不同字符串数量
+int string_pool_size(const StringPool* pool) {
+    if (pool == NULL) {
+        return 0;
+    }
+    return pool->count;
+}
+
+// 释放字符串池
+void string_pool_free(StringPool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    InternBlock* block = pool->blocks;
+    while (block != NULL) {
+        InternBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+
+    free((void*)pool->strings);
+    free(pool->hashes);
+    free(pool->table);
+    free(pool);
+}
@@ -0,0 +1,51 @@
+#ifndef GACHA_INTERN_H
+#define GACHA_INTERN_H
+
+#include <stddef.h>
+
+// 字符存储块（字符串一经写入不再移动）
+typedef struct InternBlock {
+    struct InternBlock* next; // 下一个存储块
+    size_t used;              // 已使用字节数
+    size_t capacity;          // 块容量
+    char data[];              // 字符数据
+} InternBlock;
+
+// 字符串池（hash-consing，相同内容只存储一份）
+typedef struct {
+    const char** strings;     // id -> 字符串
+    unsigned int* hashes;     // id -> 哈希值
+    int count;                // 不同字符串数量
+    int capacity;             // strings/hashes 容量
+
+    int* table;               // 开放寻址表（存 id，-1 表示空）
+    int table_size;           // 表大小（2 的幂）
+
+    InternBlock* blocks;      // 字符存储块链表（头部为当前块）
+} StringPool;
+
+// 默认配置
+#define INTERN_BLOCK_SIZE 65536   // 存储块大小
+#define INTERN_INITIAL_TABLE 256  // 初始哈希表大小
+
+// 核心函数
+
+// 创建字符串池
+StringPool* string_pool_create();
+
+// 驻留字符串，返回其 id（失败返回 -1）
+int string_pool_intern(StringPool* pool, const char* str, size_t len);
+
+// 查找字符串 id（不存在返回 -1）
+int string_pool_find(const StringPool* pool, const char* str, size_t len);
+
+// 根据 id 获取字符串
+const char* string_pool_get(const StringPool* pool, int id);
+
+// 获取不同字符串数量
+int string_pool_size(const StringPool* pool);
+
+// 释放字符串池
+void string_pool_free(StringPool* pool);
+
+#endif // GACHA_INTERN_H
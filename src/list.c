@@ -14,6 +14,11 @@
     #define mkdir_(_path) mkdir(_path, 0755)
 #endif
 
+#include "alloc.h"
+
+// 等级名称表
+static const char* const RANK_NAMES[RANK_COUNT] = { "N", "R", "SR", "SSR", "UR" };
+
 // 等级到索引的映射
 static int rank_to_index(const char* rank) {
     if (strcmp(rank, "N") == 0) return 0;
@@ -24,6 +29,16 @@ static int rank_to_index(const char* rank) {
     return -1;
 }
 
+// 等级到索引的映射（带长度，不要求 NUL 结尾）
+static int rank_span_to_index(const char* rank, size_t len) {
+    for (int i = 0; i < RANK_COUNT; i++) {
+        if (strlen(RANK_NAMES[i]) == len && strncmp(rank, RANK_NAMES[i], len) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 // 获取 gachalist 文件路径
 char* get_gachalist_path() {
     char* config_dir = NULL;
@@ -83,6 +98,30 @@ int validate_rank(const char* rank) {
     return rank_to_index(rank) >= 0;
 }
 
+// 获取等级名称
+const char* rank_name(int rank_index) {
+    if (rank_index < 0 || rank_index >= RANK_COUNT) {
+        return RANK_NAMES[0];
+    }
+    return RANK_NAMES[rank_index];
+}
+
+// 获取条目菜名
+const char* gachalist_item_name(const GachaList* list, int index) {
+    if (list == NULL || index < 0 || index >= list->size) {
+        return NULL;
+    }
+    return string_pool_get(list->names, list->items[index].name_id);
+}
+
+// 获取条目等级名称
+const char* gachalist_item_rank(const GachaList* list, int index) {
+    if (list == NULL || index < 0 || index >= list->size) {
+        return NULL;
+    }
+    return rank_name(list->items[index].rank_index);
+}
+
 // 读取 gachalist 文件
 GachaList* read_gachalist(const char* path) {
     if (path == NULL) {
@@ -124,6 +163,15 @@ GachaList* read_gachalist(const char* path) {
         return NULL;
     }
 
+    // 菜名字符串池：重复菜名只存储一份，条目只保存 id
+    list->names = string_pool_create();
+    if (list->names == NULL) {
+        free(list->items);
+        free(list);
+        fclose(fp);
+        return NULL;
+    }
+
     list->size = 0;
     list->file_path = strdup(path);
 
@@ -142,36 +190,34 @@ GachaList* read_gachalist(const char* path) {
         // 解析等级和菜名
         char* rank_start = strstr(buffer, "【");
         char* rank_end = strstr(buffer, "】");
+        const char* name_ptr = buffer;
+        int rank_index = 0;  // 无效或缺失的等级按 N 级处理
 
         if (rank_start != NULL && rank_end != NULL && rank_end > rank_start) {
             // 提取等级（跳过"【" 3字节）
             char* rank_ptr = rank_start + 3;
-            char* name_ptr = rank_end + 3;
+            name_ptr = rank_end + 3;
 
             // 计算等级长度
             size_t rank_len = rank_end - rank_ptr;
             if (rank_len > 0 && rank_len < 10) {
-                list->items[current_line].rank = (char*)malloc(rank_len + 1);
-                strncpy(list->items[current_line].rank, rank_ptr, rank_len);
-                list->items[current_line].rank[rank_len] = '\0';
-
                 // 验证等级
-                if (!validate_rank(list->items[current_line].rank)) {
-                    free(list->items[current_line].rank);
-                    list->items[current_line].rank = strdup("N");
+                int index = rank_span_to_index(rank_ptr, rank_len);
+                if (index >= 0) {
+                    rank_index = index;
                 }
-            } else {
-                list->items[current_line].rank = strdup("N");
             }
+        }
 
-            // 提取菜名
-            list->items[current_line].name = strdup(name_ptr);
-        } else {
-            // 没有等级标记，按 N 级处理
-            list->items[current_line].rank = strdup("N");
-            list->items[current_line].name = strdup(buffer);
+        // 驻留菜名
+        int name_id = string_pool_intern(list->names, name_ptr, strlen(name_ptr));
+        if (name_id < 0) {
+            continue;
         }
 
+        list->items[current_line].name_id = name_id;
+        list->items[current_line].rank_index = rank_index;
+
         current_line++;
     }
 
@@ -332,17 +378,13 @@ void free_gachalist(GachaList* list) {
     }
 
     if (list->items != NULL) {
-        for (int i = 0; i < list->size; i++) {
-            if (list->items[i].name != NULL) {
-                free(list->items[i].name);
-            }
-            if (list->items[i].rank != NULL) {
-                free(list->items[i].rank);
-            }
-        }
         free(list->items);
     }
 
+    if (list->names != NULL) {
+        string_pool_free(list->names);
+    }
+
     if (list->file_path != NULL) {
         free(list->file_path);
     }
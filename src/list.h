@@ -2,11 +2,12 @@
 #define GACHA_LIST_H
 
 #include <stddef.h>
+#include "intern.h"
 
 // gachalist 条目结构体
 typedef struct {
-    char* name;                // 菜名
-    char* rank;                // 等级（N/R/SR/SSR/UR）
+    int name_id;               // 菜名在字符串池中的 id
+    int rank_index;            // 等级索引 [N,R,SR,SSR,UR]
 } GachaItem;
 
 // gachalist 结构体
@@ -14,8 +15,12 @@ typedef struct {
     GachaItem* items;          // 菜名数组
     int size;                  // 菜名数量
     char* file_path;           // 文件路径
+    StringPool* names;         // 菜名字符串池（重复菜名只存一份）
 } GachaList;
 
+// 等级数量
+#define RANK_COUNT 5
+
 // 默认菜名数据结构
 typedef struct {
     const char* name;
@@ -45,4 +50,13 @@ void free_gachalist(GachaList* list);
 // 验证等级格式
 int validate_rank(const char* rank);
 
+// 获取等级名称
+const char* rank_name(int rank_index);
+
+// 获取条目菜名
+const char* gachalist_item_name(const GachaList* list, int index);
+
+// 获取条目等级名称
+const char* gachalist_item_rank(const GachaList* list, int index);
+
 #endif // GACHA_LIST_H
@@ -1,13 +1,37 @@
 #include "config.h"
 #include "random.h"
 #include "matcher.h"
+#include "pattern.h"
+#include "alphabet.h"
+#include "dictionary.h"
+#include "datrie.h"
+#include "estimate.h"
+#include "analyze.h"
 #include "output.h"
+#include "render.h"
+#include "pacer.h"
 #include "gacha.h"
 #include "list.h"
+#include "drawfmt.h"
+#include "history.h"
+#include "balance.h"
+#include "trace.h"
+#include "scan.h"
+#include "histogram.h"
+#include "metrics.h"
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <time.h>
+
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+#endif
+
+#include "alloc.h"
 
 // 全局运行标志
 volatile sig_atomic_t running = 1;
@@ -66,6 +90,21 @@ void print_usage() {
     printf("选项：\n");
     printf("  -c              chaos 模式，启动随机字母生成与单词匹配\n");
     printf("  -g [数字]       gacha 模式，从 gachalist 随机抽取内容\n");
+    printf("    --format F    抽取结果输出格式：text（默认）、json、tsv、bin\n");
+    printf("    --unique      不重复抽取（每个条目最多抽中一次）\n");
+    printf("    --secure      使用不可预测的安全随机数（ChaCha20，密钥取自系统熵源）\n");
+    printf("    --top K       统计中列出抽中次数最多的 K 道菜\n");
+    printf("    --seed S      计数模式（Philox），相同种子的抽取结果相同\n");
+    printf("    --threads N   与 --seed 一起使用，批量抽取的线程数（结果与单线程相同）\n");
+    printf("  --user ID       与 -c / -g 一起使用，余额记在多用户余额文件中该用户名下\n");
+    printf("  --history       查询抽卡历史（--by rank|item、--since/--until 时间、--last N）\n");
+    printf("  --estimate      解析估算 chaos 模式的匹配速度与运行时长\n");
+    printf("  --analyze       精确计算 gachalist 各等级 / 各菜概率与集齐期望（--top K）\n");
+    printf("  --scan FILE...  统计文件中字典单词的匹配次数（--threads N、--top K）\n");
+    printf("  --trace FILE    退出时把各阶段耗时写成 Chrome / Perfetto 跟踪文件\n");
+    printf("  --stats         退出时输出各阶段内存分配统计（需以 GACHA_TRACK_ALLOC 构建）\n");
+    printf("  --histogram     与 -c / -g 一起使用，退出时输出匹配间隔或抽取耗时的分位数\n");
+    printf("  --metrics-file PATH  与 -c 一起使用，定时写出 Prometheus 文本格式的运行指标\n");
     printf("  -h, --help      显示帮助信息\n");
     printf("  -v, --version   显示版本信息\n");
 }
@@ -76,20 +115,72 @@ void print_help() {
     printf("用法：\n");
     printf("  gacha -c              启动 chaos 模式\n");
     printf("  gacha -g [数字]       启动 gacha 模式（默认抽取 1 次）\n");
+    printf("  gacha --history       查询抽卡历史统计\n");
+    printf("  gacha --estimate      估算 chaos 模式的期望匹配间隔与运行时长\n");
+    printf("  gacha --analyze       解析 gachalist 奖池的概率与集齐期望\n");
+    printf("  gacha --scan FILE...  并行扫描文件，统计字典单词的匹配次数\n");
     printf("  gacha -h              显示帮助信息\n\n");
     printf("chaos 模式：\n");
     printf("  随机生成字母并匹配字典单词\n");
+    printf("  配置中的 \"- 字母表：\" 可把 a-zA-Z 换成任意 UTF-8 字符（如汉字）\n");
     printf("  每次匹配成功增加 1 次历史总匹配次数\n");
     printf("  历史总匹配次数用于 gacha 模式的抽卡\n\n");
     printf("gacha 模式：\n");
     printf("  从 gachalist 随机抽取菜名\n");
     printf("  每次抽卡消耗 1 次历史总匹配次数\n");
     printf("  当历史总匹配次数为 0 时无法抽卡\n");
-    printf("  若请求次数 > 余额，可确认使用剩余次数\n\n");
+    printf("  若请求次数 > 余额，可确认使用剩余次数\n");
+    printf("  --format json|tsv|bin 输出机器可读结果（序号、条目序号、等级、菜名、抽取后余额）\n");
+    printf("  --unique              不重复抽取，次数不能超过 gachalist 条目数\n");
+    printf("  --secure              安全随机模式：ChaCha20 密钥流（密钥取自 getrandom 等系统熵源，\n");
+    printf("                        缓冲 64 KiB 分摊系统调用，无偏拒绝采样），用于需要不可预测结果的抽取\n");
+    printf("  --top K               统计中列出抽中次数最多的 K 道菜（重复行合并）\n");
+    printf("  --seed S              计数模式：Philox4x32-10，第 i 次抽取只取决于 (S, i)，可按种子复现\n");
+    printf("  --threads N           与 --seed 一起使用，批量抽取按序号分段由 N 个线程生成（最多 %d），\n", GACHA_MAX_THREADS);
+    printf("                        结果与单线程逐位相同\n\n");
+    printf("多用户余额：\n");
+    printf("  -c / -g 加上 --user ID 时，余额不读写 gacha.conf，而是记在同目录的\n");
+    printf("  balances.db（映射到内存的开放寻址哈希表，查询与增减均为 O(1) 原子操作）\n\n");
+    printf("history 模式：\n");
+    printf("  每次抽卡都会追加记录到 gacha.conf 同目录的 history.log\n");
+    printf("  --by rank|item        按等级（默认）或按条目统计\n");
+    printf("  --since/--until 时间  时间范围（Unix 秒或 YYYY-MM-DD[ HH:MM[:SS]]）\n");
+    printf("  --last N              列出最近 N 次抽取\n\n");
+    printf("estimate 模式：\n");
+    printf("  基于当前字典与生成速度构建匹配自动机，精确计算\n");
+    printf("  每次匹配的期望字母数、各单词匹配概率与单次运行期望时长\n\n");
+    printf("analyze 模式：\n");
+    printf("  每次抽取在 gachalist 全部行中等概率选一行，据此精确计算（不做模拟）\n");
+    printf("  各等级与各菜的单抽概率、首次抽中某等级的期望与 50%%/90%%/99%% 分位抽取次数、\n");
+    printf("  集齐某等级全部菜及集齐全部菜的期望抽取次数\n");
+    printf("  --top K               列出单抽概率最高的 K 道菜（默认 %d）\n\n", ANALYZE_TOP_DISHES);
+    printf("scan 模式：\n");
+    printf("  把文件映射到内存，按 chaos 模式的规则（非字母回到初始状态）统计各单词匹配次数，\n");
+    printf("  大文件分块并行扫描；只做统计，不增加抽卡余额\n");
+    printf("  --threads N           线程数（默认 CPU 数，最多 %d）\n", SCAN_MAX_THREADS);
+    printf("  --top K               列出匹配次数最多的 K 个单词（默认 %d）\n\n", SCAN_TOP_WORDS);
+    printf("性能跟踪：\n");
+    printf("  任意模式加上 --trace out.json，退出时写出各阶段（路径解析、parse_config、\n");
+    printf("  read_gachalist、gacha_init、抽取分块、输出、save_config）的时间线，\n");
+    printf("  chaos 循环按 1/%d 采样，可在 chrome://tracing 或 ui.perfetto.dev 打开\n\n", TRACE_SAMPLE_INTERVAL);
+    printf("内存统计：\n");
+    printf("  以 -DGACHA_TRACK_ALLOC=ON 构建后，任意模式加上 --stats 即在退出时\n");
+    printf("  按阶段（配置加载、列表加载、字典索引、抽卡、chaos 循环）输出分配次数、字节数与峰值\n\n");
+    printf("分布统计：\n");
+    printf("  -c / -g 加上 --histogram，退出时输出 p50/p90/p99/p99.9 分位数：\n");
+    printf("  chaos 模式为相邻两次匹配之间的字母数（全部单词汇总及匹配最多的 %d 个单词），\n", HISTOGRAM_TOP_WORDS);
+    printf("  gacha 模式为每块（最多 %d 次，单抽为每次）抽取的耗时（纳秒）\n\n", GACHA_BATCH_BLOCK);
+    printf("运行指标：\n");
+    printf("  -c 加上 --metrics-file PATH，后台线程每 %d 毫秒把字母数、各单词匹配次数、余额、\n", METRICS_INTERVAL_MS);
+    printf("  每秒字母数与生成循环耗时分位数写成 Prometheus 文本格式（先写临时文件再替换），\n");
+    printf("  可交给 node_exporter 的 textfile 采集器；生成循环只做无锁的原子存储\n\n");
     printf("示例：\n");
     printf("  gacha -c              启动 chaos 模式\n");
     printf("  gacha -g              抽取 1 次\n");
-    printf("  gacha -g 10           抽取 10 次\n\n");
+    printf("  gacha -g 10           抽取 10 次\n");
+    printf("  gacha -g 10 --format json  以 NDJSON 输出 10 次抽取结果\n");
+    printf("  gacha -g 10 --unique  抽取 10 道互不相同的菜\n");
+    printf("  gacha -g 5 --user alice    用 alice 的余额抽取 5 次\n\n");
     printf("配置文件位置：\n");
     printf("  Windows: %%APPDATA%%\\gacha\\gacha.conf\n");
     printf("  Linux/macOS: ~/.config/gacha/gacha.conf\n\n");
@@ -97,16 +188,107 @@ void print_help() {
     printf("  与 gacha.conf 存放在同一目录\n");
 }
 
-// 运行 chaos 模式
-int run_chaos_mode() {
+// 打开多用户余额文件
+static BalanceStore* open_balance_store() {
+    char* path = get_balance_path();
+    BalanceStore* store = balance_open(path);
+    if (store == NULL) {
+        fprintf(stderr, "错误: 无法打开余额文件 %s\n", path != NULL ? path : BALANCE_FILE_NAME);
+    }
+    free(path);
+    return store;
+}
+
+// 余额超过 int 范围时按 INT_MAX 处理（单次最多抽取 INT_MAX 次）
+static int clamp_balance(long long balance) {
+    return balance > INT_MAX ? INT_MAX : (int)balance;
+}
+
+// 创建配置中的自定义字母表（未配置时 *alphabet 为 NULL），字母表无效时返回 -1
+static int load_alphabet(const GachaConfig* config, Alphabet** alphabet) {
+    *alphabet = NULL;
+    if (config->alphabet == NULL) {
+        return 0;
+    }
+
+    *alphabet = alphabet_create(config->alphabet);
+    if (*alphabet == NULL) {
+        fprintf(stderr, "错误: 字母表无效（须为 UTF-8，不超过 %d 个字符）\n", ALPHABET_MAX_SIZE);
+        return -1;
+    }
+    return 0;
+}
+
+// 配置的缓冲区小于最长单词时提示（更长的单词不建入 DFA / Trie，不会匹配）
+static void warn_buffer_size(const GachaConfig* config, int max_word_length) {
+    if (config->matcher_buffer_size > 0 && config->matcher_buffer_size < max_word_length) {
+        fprintf(stderr, "警告: 缓冲区大小 %d 小于最长单词（%d 个字母），更长的单词不会匹配\n",
+                config->matcher_buffer_size, max_word_length);
+    }
+}
+
+// 输出匹配间隔分布：全部单词汇总，以及匹配次数最多的单词各自的分布
+static void report_gap_histograms(const MatcherState* ms, const Dictionary* dict) {
+    Histogram* all = histogram_create();
+    if (all == NULL) {
+        return;
+    }
+    for (int i = 0; i < dict->size; i++) {
+        histogram_merge(all, matcher_gap_histogram(ms, i));
+    }
+    printf("\n匹配间隔（字母数）：");
+    histogram_print(stdout, all, "");
+    histogram_free(all);
+
+    // 按匹配次数选出前 HISTOGRAM_TOP_WORDS 个单词（次数相同时序号小者在前）
+    int shown[HISTOGRAM_TOP_WORDS];
+    int shown_count = 0;
+    while (shown_count < HISTOGRAM_TOP_WORDS) {
+        int best = -1;
+        long long best_total = 0;
+        for (int i = 0; i < dict->size; i++) {
+            const Histogram* h = matcher_gap_histogram(ms, i);
+            if (h == NULL || h->total <= best_total) {
+                continue;
+            }
+            int taken = 0;
+            for (int k = 0; k < shown_count && !taken; k++) {
+                taken = shown[k] == i;
+            }
+            if (!taken) {
+                best = i;
+                best_total = h->total;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        shown[shown_count++] = best;
+    }
+
+    for (int k = 0; k < shown_count; k++) {
+        const DictWord* word = &dict->words[shown[k]];
+        printf("  %.*s：", word->length, word->text);
+        histogram_print(stdout, matcher_gap_histogram(ms, shown[k]), "");
+    }
+    fflush(stdout);
+}
+
+// 运行 chaos 模式（user 非 NULL 时匹配次数记入多用户余额文件；histogram 非 0 时退出时输出匹配间隔分布；
+//   metrics_path 非 NULL 时定时写出运行指标）
+int run_chaos_mode(const char* user, int histogram, const char* metrics_path) {
     // 1. 加载配置
+    alloc_set_phase(ALLOC_PHASE_CONFIG);
+    long long trace_start_ns = trace_begin();
     char* config_path = get_config_path();
+    trace_complete("resolve_paths", trace_start_ns, 0);
     if (config_path == NULL) {
         fprintf(stderr, "错误: 无法获取配置文件路径\n");
         return 1;
     }
 
     GachaConfig* config = NULL;
+    trace_start_ns = trace_begin();
 
     // 检查配置文件是否存在
     if (!config_file_exists(config_path)) {
@@ -123,6 +305,7 @@ int run_chaos_mode() {
         // 解析现有配置文件
         config = parse_config(config_path);
     }
+    trace_complete("parse_config", trace_start_ns, 0);
 
     if (config == NULL) {
         fprintf(stderr, "错误: 无法加载配置\n");
@@ -139,19 +322,65 @@ int run_chaos_mode() {
         return 1;
     }
 
-    MatcherState* ms = matcher_init(config->dictionary, config->dictionary_size);
+    alloc_set_phase(ALLOC_PHASE_LIST);
+    trace_start_ns = trace_begin();
+    Dictionary* dict = dictionary_load(config, config_path);
+    trace_complete("dictionary_load", trace_start_ns, dict != NULL ? dict->size : 0);
+    if (dict == NULL) {
+        fprintf(stderr, "错误: 无法加载字典\n");
+        random_generator_free(rg);
+        free_config(config);
+        free(config_path);
+        return 1;
+    }
+
+    trace_start_ns = trace_begin();
+    // 自定义字母表（未配置时为 a-z A-Z）
+    Alphabet* alphabet = NULL;
+    if (load_alphabet(config, &alphabet) != 0) {
+        dictionary_free(dict);
+        random_generator_free(rg);
+        free_config(config);
+        free(config_path);
+        return 1;
+    }
+
+    MatcherState* ms = NULL;
+    alloc_set_phase(ALLOC_PHASE_INDEX);
+    if (alphabet != NULL) {
+        ms = matcher_init_symbols(dict->words, dict->size, config->matcher_buffer_size, alphabet);
+    } else {
+        // 大字典的 Trie 索引保存在配置目录，之后直接映射
+        char* index_path = resolve_config_relative_path(config_path, DATRIE_FILE_NAME);
+        ms = matcher_init(dict->words, dict->size, config->matcher_buffer_size,
+                          config->dictionary_ignore_case, index_path, dict->source_id);
+        free(index_path);
+    }
+    alloc_set_phase(ALLOC_PHASE_LIST);
+    trace_complete("matcher_init", trace_start_ns, 0);
     if (ms == NULL) {
-        fprintf(stderr, "错误: 无法初始化匹配器\n");
+        fprintf(stderr, "错误: 无法初始化匹配器（模式过多或过于复杂时无法编译）\n");
+        alphabet_free(alphabet);
+        dictionary_free(dict);
         random_generator_free(rg);
         free_config(config);
         free(config_path);
         return 1;
     }
 
+    warn_buffer_size(config, ms->max_word_length);
+
+    if (histogram && matcher_enable_histograms(ms) != 0) {
+        fprintf(stderr, "警告: 内存不足，不输出匹配间隔分布\n");
+    }
+
+    alloc_set_phase(ALLOC_PHASE_CHAOS);
     OutputState* os = output_init();
     if (os == NULL) {
         fprintf(stderr, "错误: 无法初始化输出模块\n");
         matcher_free(ms);
+        alphabet_free(alphabet);
+        dictionary_free(dict);
         random_generator_free(rg);
         free_config(config);
         free(config_path);
@@ -162,46 +391,153 @@ int run_chaos_mode() {
     setup_signal_handler();
 
     // 4. 主循环
-    int delay = 1000 / config->letters_per_second;  // 毫秒
 
     printf("开始随机生成 (每秒 %d 个字母)\n", config->letters_per_second);
-    printf("字典包含 %d 个单词，按 Ctrl+C 停止\n\n", config->dictionary_size);
+    printf("字典包含 %d 个单词，按 Ctrl+C 停止\n\n", dict->size);
     fflush(stdout);
 
+    // 终端输出交给独立的渲染线程，生成循环不会因终端过慢而阻塞
+    RenderState* rs = render_start(os, dict->words, ms->buffer_size > 0 ? ms->buffer_size : 1,
+                                   alphabet);
+    if (rs == NULL) {
+        fprintf(stderr, "错误: 无法启动输出线程\n");
+        output_free(os);
+        matcher_free(ms);
+        alphabet_free(alphabet);
+        dictionary_free(dict);
+        random_generator_free(rg);
+        free_config(config);
+        free(config_path);
+        return 1;
+    }
+
+    // 按绝对截止时间控制速度，速度较高时每个节拍生成一批字母
+    Pacer* pacer = pacer_init(config->letters_per_second);
+    if (pacer == NULL) {
+        fprintf(stderr, "错误: 无法初始化节拍器\n");
+        render_finish(rs);
+        output_free(os);
+        matcher_free(ms);
+        alphabet_free(alphabet);
+        dictionary_free(dict);
+        random_generator_free(rg);
+        free_config(config);
+        free(config_path);
+        return 1;
+    }
+
+    // 运行指标：余额从本次运行之前的历史总数（或用户余额）算起
+    MetricsExporter* metrics = NULL;
+    if (metrics_path != NULL) {
+        long long base_balance = config->history_total_count;
+        if (user != NULL) {
+            BalanceStore* store = open_balance_store();
+            base_balance = store != NULL ? balance_get(store, user) : 0;
+            balance_close(store);
+        }
+        metrics = metrics_start(metrics_path, dict->words, dict->size,
+                                base_balance > 0 ? base_balance : 0, user);
+        if (metrics == NULL) {
+            fprintf(stderr, "错误: 无法写出指标文件 %s\n", metrics_path);
+            pacer_free(pacer);
+            render_finish(rs);
+            output_free(os);
+            matcher_free(ms);
+            alphabet_free(alphabet);
+            dictionary_free(dict);
+            random_generator_free(rg);
+            free_config(config);
+            free(config_path);
+            return 1;
+        }
+    }
+
+    unsigned int ticks = 0;
     while (running && !matcher_should_end(ms)) {
-        // 生成字母
-        char letter = generate_random_letter(rg);
+        // 等待下一个节拍
+        int batch = pacer_wait(pacer);
+        long long tick_start = trace_sample(&ticks);
+        long long loop_start = metrics != NULL ? trace_now() : 0;
 
-        // 输出字母
-        output_letter(os, letter);
+        for (int i = 0; i < batch && !matcher_should_end(ms); i++) {
+            if (alphabet != NULL) {
+                // 自定义字母表：生成与匹配都只用编号，UTF-8 转换留给输出线程
+                int symbol = (int)random_bounded(rg, (uint32_t)alphabet->size);
+                render_push_symbol(rs, symbol);
+
+                int matched = matcher_process_symbol(ms, symbol);
+                if (matched >= 0) {
+                    render_push_match(rs, matched, 0);
+                    metrics_record_match(metrics, matched);
+                }
+                continue;
+            }
 
-        // 处理匹配
-        char matched_word[256] = {0};
-        if (matcher_process_letter(ms, letter, matched_word)) {
-            // 匹配成功，输出换行和单词
-            output_newline();
-            output_matched_word(os, matched_word);
+            // 生成字母
+            char letter = generate_random_letter(rg);
+
+            // 输出字母
+            render_push_letter(rs, letter);
+
+            // 处理匹配
+            int matched = matcher_process_letter(ms, letter);
+            if (matched >= 0) {
+                // 匹配成功，换行并加粗输出单词
+                render_push_match(rs, matched, matcher_match_length(ms, matched));
+                metrics_record_match(metrics, matched);
+            }
         }
+        if (metrics != NULL) {
+            metrics_record_loop(metrics, ms->letter_count, loop_start, trace_now());
+        }
+        trace_complete("chaos_tick", tick_start, batch);
+    }
 
-        // 延迟
-        sleep_ms(delay);
+    pacer_free(pacer);
+    if (metrics != NULL && metrics_finish(metrics) != 0) {
+        fprintf(stderr, "警告: 无法写出指标文件 %s\n", metrics_path);
     }
 
+    // 等待已生成的字母全部输出
+    trace_start_ns = trace_begin();
+    render_finish(rs);
+    trace_complete("render_finish", trace_start_ns, 0);
+
+    alloc_set_phase(ALLOC_PHASE_OTHER);
+
     // 5. 输出最终统计
     int current_run_count = matcher_get_total_count(ms);
     output_final_count(current_run_count);
+    if (ms->gaps != NULL) {
+        report_gap_histograms(ms, dict);
+    }
 
-    // 6. 更新并保存历史总匹配次数
-    config->history_total_count += current_run_count;
-    output_history_total_count(config->history_total_count);
+    // 6. 更新并保存历史总匹配次数（指定用户时原子累加到余额文件）
+    trace_start_ns = trace_begin();
+    if (user != NULL) {
+        BalanceStore* store = open_balance_store();
+        long long total = balance_credit(store, user, current_run_count);
+        if (total < 0) {
+            fprintf(stderr, "警告: 无法更新用户 %s 的余额\n", user);
+        } else {
+            output_history_total_count(clamp_balance(total));
+        }
+        balance_close(store);
+    } else {
+        config->history_total_count += current_run_count;
+        output_history_total_count(config->history_total_count);
 
-    if (save_config(config_path, config) != 0) {
-        fprintf(stderr, "警告: 无法保存配置文件\n");
+        if (save_config(config_path, config) != 0) {
+            fprintf(stderr, "警告: 无法保存配置文件\n");
+        }
     }
+    trace_complete("save_config", trace_start_ns, 0);
 
     // 7. 清理资源
     output_free(os);
     matcher_free(ms);
+    alphabet_free(alphabet);
+    dictionary_free(dict);
     random_generator_free(rg);
     free_config(config);
     free(config_path);
@@ -209,30 +545,824 @@ int run_chaos_mode() {
     return 0;
 }
 
+// 格式化时长
+static void format_duration(double seconds, char* buffer, size_t size) {
+    if (seconds != seconds || seconds > 1e15) {
+        snprintf(buffer, size, "无穷");
+    } else if (seconds >= 86400.0 * 365.0) {
+        snprintf(buffer, size, "%.3g 年", seconds / (86400.0 * 365.0));
+    } else if (seconds >= 86400.0) {
+        snprintf(buffer, size, "%.2f 天", seconds / 86400.0);
+    } else if (seconds >= 3600.0) {
+        snprintf(buffer, size, "%.2f 小时", seconds / 3600.0);
+    } else if (seconds >= 60.0) {
+        snprintf(buffer, size, "%.2f 分钟", seconds / 60.0);
+    } else {
+        snprintf(buffer, size, "%.2f 秒", seconds);
+    }
+}
+
+// 估算结果中列出的单词数量
+#define ESTIMATE_TOP_WORDS 20
+
+// 按匹配概率从高到低排序（概率相同时字典序号小者在前）
+static const double* estimate_order = NULL;
+
+static int compare_estimate_probability(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    if (estimate_order[x] != estimate_order[y]) {
+        return estimate_order[x] < estimate_order[y] ? 1 : -1;
+    }
+    return x - y;
+}
+
+// 运行 estimate 模式
+int run_estimate_mode() {
+    // 1. 加载配置与字典
+    alloc_set_phase(ALLOC_PHASE_CONFIG);
+    char* config_path = get_config_path();
+    GachaConfig* config = parse_config(config_path);
+    if (config == NULL) {
+        config = get_default_config();
+    }
+    if (config == NULL) {
+        fprintf(stderr, "错误: 无法加载配置\n");
+        free(config_path);
+        return 1;
+    }
+
+    alloc_set_phase(ALLOC_PHASE_LIST);
+    Dictionary* dict = dictionary_load(config, config_path);
+    if (dict == NULL || dict->size == 0) {
+        fprintf(stderr, "错误: 字典为空或无法加载\n");
+        dictionary_free(dict);
+        free_config(config);
+        free(config_path);
+        return 1;
+    }
+
+    Alphabet* alphabet = NULL;
+    if (load_alphabet(config, &alphabet) != 0) {
+        dictionary_free(dict);
+        free_config(config);
+        free(config_path);
+        return 1;
+    }
+
+    // 2. 解析计算（未指定缓冲区大小时匹配器会容纳最长单词）
+    alloc_set_phase(ALLOC_PHASE_OTHER);
+    int max_length = config->matcher_buffer_size > 0 ? config->matcher_buffer_size : INT_MAX;
+    int alphabet_size = alphabet != NULL ? alphabet->size : CHARSET_SIZE;
+    if (alphabet == NULL) {
+        int longest = 0;
+        for (int i = 0; i < dict->size; i++) {
+            int length = pattern_length(dict->words[i].text, dict->words[i].length);
+            if (length > longest) {
+                longest = length;
+            }
+        }
+        warn_buffer_size(config, longest);
+    }
+    clock_t start = clock();
+    ChaosEstimate* est = NULL;
+    if (alphabet != NULL) {
+        // 自定义字母表按匹配器同样的编号 DFA 计算
+        MatcherState* ms = matcher_init_symbols(dict->words, dict->size,
+                                                config->matcher_buffer_size, alphabet);
+        if (ms == NULL) {
+            fprintf(stderr, "错误: 字典过大，无法编译匹配自动机\n");
+            alphabet_free(alphabet);
+            dictionary_free(dict);
+            free_config(config);
+            free(config_path);
+            return 1;
+        }
+        warn_buffer_size(config, ms->max_word_length);
+        est = estimate_chaos_dfa(ms->dfa, config->letters_per_second, MAX_MATCH_COUNT);
+        matcher_free(ms);
+        alphabet_free(alphabet);
+    } else if (config->dictionary_ignore_case || pattern_any_syntax(dict->words, dict->size)) {
+        // 通配符与忽略大小写按匹配器同样的 DFA 计算
+        PatternDfa* dfa = pattern_compile(dict->words, dict->size,
+                                          config->dictionary_ignore_case, max_length);
+        if (dfa == NULL) {
+            fprintf(stderr, "错误: 模式过多或过于复杂，无法编译匹配自动机\n");
+            dictionary_free(dict);
+            free_config(config);
+            free(config_path);
+            return 1;
+        }
+        est = estimate_chaos_dfa(dfa, config->letters_per_second, MAX_MATCH_COUNT);
+        pattern_dfa_free(dfa);
+    } else {
+        est = estimate_chaos(dict->words, dict->size, CHARSET, CHARSET_SIZE,
+                             max_length, config->letters_per_second, MAX_MATCH_COUNT);
+    }
+    double elapsed_ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+    if (est == NULL) {
+        fprintf(stderr, "错误: 无法完成估算\n");
+        dictionary_free(dict);
+        free_config(config);
+        free(config_path);
+        return 1;
+    }
+
+    // 3. 输出结果
+    char duration[64];
+    format_duration(est->seconds_per_run, duration, sizeof(duration));
+
+    printf("字典包含 %d 个单词，其中 %d 个可能匹配\n", est->word_count, est->matchable_count);
+    printf("字母表 %d 个字母，每秒生成 %d 个\n", alphabet_size, config->letters_per_second);
+    printf("匹配自动机 %d 个状态，迭代 %d 次，耗时 %.2f ms\n\n",
+           est->state_count, est->iterations, elapsed_ms);
+
+    printf("每次匹配期望字母数：%.6g\n", est->letters_per_match);
+    printf("每小时期望抽卡余额：%.6g\n", est->balance_per_hour);
+    printf("单次运行（任一单词匹配 %d 次结束）：\n", MAX_MATCH_COUNT);
+    printf("  期望匹配次数：%.6g\n", est->matches_per_run);
+    printf("  期望字母数：%.6g\n", est->letters_per_run);
+    printf("  期望时长：%s\n", duration);
+
+    // 按匹配概率从高到低列出前若干个单词
+    if (est->matchable_count > 0) {
+        int* top = (int*)malloc((size_t)est->matchable_count * sizeof(int));
+        int top_count = 0;
+        for (int i = 0; top != NULL && i < est->word_count; i++) {
+            if (est->match_probability[i] > 0.0) {
+                top[top_count++] = i;
+            }
+        }
+        estimate_order = est->match_probability;
+        if (top != NULL) {
+            qsort(top, (size_t)top_count, sizeof(int), compare_estimate_probability);
+        }
+        if (top_count > ESTIMATE_TOP_WORDS) {
+            top_count = ESTIMATE_TOP_WORDS;
+        }
+
+        printf("\n各单词匹配概率（前 %d 个）：\n", top_count);
+        for (int k = 0; k < top_count; k++) {
+            const DictWord* word = &dict->words[top[k]];
+            printf("  %.*s  %.4f%%  每字母匹配率 %.6g\n", word->length, word->text,
+                   est->match_probability[top[k]] * 100.0, est->match_rate[top[k]]);
+        }
+        free(top);
+    }
+
+    estimate_free(est);
+    dictionary_free(dict);
+    free_config(config);
+    free(config_path);
+
+    return 0;
+}
+
+// 运行 analyze 模式（top 为列出的单抽概率最高的菜数）
+int run_analyze_mode(int top) {
+    // 1. 加载 gachalist（与 gacha 模式相同，读取失败时使用内置列表）
+    alloc_set_phase(ALLOC_PHASE_LIST);
+    char* gachalist_path = get_gachalist_path();
+    GachaList* list = read_gachalist(gachalist_path);
+    free(gachalist_path);
+    if (list == NULL || list->size == 0) {
+        fprintf(stderr, "错误: gachalist 为空或无法读取，使用内置默认列表\n");
+        free_gachalist(list);
+        list = get_default_gachalist();
+    }
+    if (list == NULL || list->size == 0) {
+        fprintf(stderr, "错误: 无法加载 gachalist\n");
+        free_gachalist(list);
+        return 1;
+    }
+
+    // 2. 解析计算
+    alloc_set_phase(ALLOC_PHASE_OTHER);
+    clock_t start = clock();
+    PoolAnalysis* analysis = analyze_pool(list);
+    double elapsed_ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+    if (analysis == NULL) {
+        fprintf(stderr, "错误: 无法完成奖池解析\n");
+        free_gachalist(list);
+        return 1;
+    }
+
+    // 3. 输出结果
+    printf("gachalist 共 %d 行，%d 道不同的菜（同名同等级的重复行合并），耗时 %.2f ms\n",
+           analysis->item_count, analysis->dish_count, elapsed_ms);
+    printf("每次抽取在全部行中等概率选一行\n");
+
+    for (int r = RANK_COUNT - 1; r >= 0; r--) {
+        const RankAnalysis* rank = &analysis->ranks[r];
+        printf("\n【%s】", rank_name(r));
+        if (rank->rows == 0) {
+            printf("无条目\n");
+            continue;
+        }
+        printf("%d 行 / %d 道菜，单抽概率 %.6g%%\n", rank->rows, rank->dish_count,
+               rank->probability * 100.0);
+
+        printf("  首次抽中：期望 %.6g 次", rank->first_mean);
+        for (int k = 0; k < ANALYZE_PERCENTILE_COUNT; k++) {
+            printf("，%g%% 在 %lld 次内", analyze_percentile_level(k) * 100.0,
+                   rank->first_percentile[k]);
+        }
+        printf("\n");
+
+        double low = (double)rank->min_rows / analysis->item_count * 100.0;
+        double high = (double)rank->max_rows / analysis->item_count * 100.0;
+        if (rank->min_rows == rank->max_rows) {
+            printf("  每道菜单抽概率 %.6g%%\n", low);
+        } else {
+            printf("  每道菜单抽概率 %.6g%% ~ %.6g%%\n", low, high);
+        }
+        printf("  集齐全部 %d 道：期望 %.6g 次\n", rank->dish_count, rank->complete_mean);
+    }
+
+    printf("\n集齐全部 %d 道菜：期望 %.6g 次\n", analysis->dish_count, analysis->complete_mean);
+
+    // 单抽概率最高的菜
+    int* dishes = (int*)malloc((size_t)top * sizeof(int));
+    int count = analyze_top_dishes(analysis, top, dishes);
+    if (count > 0) {
+        printf("\n单抽概率最高的 %d 道菜：\n", count);
+        for (int k = 0; k < count; k++) {
+            int item = analysis->dish_item[dishes[k]];
+            int rows = analysis->dish_rows[dishes[k]];
+            printf("%3d. 【%s】%s  %.6g%%（%d 行）\n", k + 1, gachalist_item_rank(list, item),
+                   gachalist_item_name(list, item), (double)rows / analysis->item_count * 100.0, rows);
+        }
+    }
+    free(dishes);
+
+    analyze_free(analysis);
+    free_gachalist(list);
+    return 0;
+}
+
+// history 模式命令行选项
+typedef struct {
+    int by_item;               // 是否按条目统计（默认按等级）
+    uint32_t since;            // 起始时间（含）
+    uint32_t until;            // 结束时间（不含）
+    int last;                  // 列出最后 N 条记录（0 表示不列出）
+} HistoryOptions;
+
+// 解析时间：Unix 秒，或本地时间 YYYY-MM-DD[ HH:MM[:SS]]，失败返回 -1
+static long long parse_history_time(const char* str) {
+    int year, month, day, hour = 0, minute = 0, second = 0;
+    int fields = sscanf(str, "%d-%d-%d %d:%d:%d", &year, &month, &day, &hour, &minute, &second);
+    if (fields >= 3) {
+        if (fields == 4) {
+            return -1;
+        }
+        struct tm tm;
+        memset(&tm, 0, sizeof(tm));
+        tm.tm_year = year - 1900;
+        tm.tm_mon = month - 1;
+        tm.tm_mday = day;
+        tm.tm_hour = hour;
+        tm.tm_min = minute;
+        tm.tm_sec = second;
+        tm.tm_isdst = -1;
+        time_t t = mktime(&tm);
+        return t < 0 ? -1 : (long long)t;
+    }
+
+    char* end = NULL;
+    long long value = strtoll(str, &end, 10);
+    if (end == str || *end != '\0' || value < 0 || value > (long long)UINT32_MAX) {
+        return -1;
+    }
+    return value;
+}
+
+// 解析 history 模式选项（argv[start] 起），失败返回 -1
+int parse_history_options(int argc, char* argv[], int start, HistoryOptions* options) {
+    options->by_item = 0;
+    options->since = 0;
+    options->until = UINT32_MAX;
+    options->last = 0;
+
+    for (int i = start; i < argc; i++) {
+        const char* arg = argv[i];
+        if (i + 1 >= argc) {
+            fprintf(stderr, "错误: 参数 %s 缺少取值\n", arg);
+            return -1;
+        }
+        const char* value = argv[++i];
+
+        if (strcmp(arg, "--by") == 0) {
+            if (strcmp(value, "rank") == 0) {
+                options->by_item = 0;
+            } else if (strcmp(value, "item") == 0) {
+                options->by_item = 1;
+            } else {
+                fprintf(stderr, "错误: --by 只支持 rank 或 item\n");
+                return -1;
+            }
+        } else if (strcmp(arg, "--since") == 0 || strcmp(arg, "--until") == 0) {
+            long long t = parse_history_time(value);
+            if (t < 0) {
+                fprintf(stderr, "错误: 无法解析时间 %s（Unix 秒或 YYYY-MM-DD[ HH:MM[:SS]]）\n", value);
+                return -1;
+            }
+            if (arg[2] == 's') {
+                options->since = (uint32_t)t;
+            } else {
+                options->until = (uint32_t)t;
+            }
+        } else if (strcmp(arg, "--last") == 0) {
+            options->last = parse_draw_count(value);
+            if (options->last <= 0) {
+                fprintf(stderr, "错误: --last 需要正整数\n");
+                return -1;
+            }
+        } else {
+            fprintf(stderr, "错误: 未知参数 %s\n", arg);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// 格式化 Unix 时间为本地时间
+static void format_history_time(uint32_t timestamp, char* buffer, size_t size) {
+    time_t t = (time_t)timestamp;
+    struct tm* tm = localtime(&t);
+    if (tm == NULL || strftime(buffer, size, "%Y-%m-%d %H:%M:%S", tm) == 0) {
+        snprintf(buffer, size, "%u", timestamp);
+    }
+}
+
+// 按条目次数从高到低排序（次数相同时条目序号小者在前）
+static const long long* history_order = NULL;
+
+static int compare_history_count(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    if (history_order[x] != history_order[y]) {
+        return history_order[x] < history_order[y] ? 1 : -1;
+    }
+    return x - y;
+}
+
+// 运行 history 模式
+int run_history_mode(const HistoryOptions* options) {
+    char* history_path = get_history_path();
+    if (history_path == NULL) {
+        fprintf(stderr, "错误: 无法获取历史文件路径\n");
+        return 1;
+    }
+
+    // 条目名称取自当前 gachalist（条目序号按 gachalist 行序号记录）
+    alloc_set_phase(ALLOC_PHASE_LIST);
+    char* gachalist_path = get_gachalist_path();
+    GachaList* list = read_gachalist(gachalist_path);
+    free(gachalist_path);
+    alloc_set_phase(ALLOC_PHASE_OTHER);
+
+    // 1. 最近记录
+    if (options->last > 0) {
+        HistoryRecord* records = NULL;
+        int n = history_last(history_path, options->last, &records);
+        if (n < 0) {
+            fprintf(stderr, "错误: 无法读取抽卡历史 %s\n", history_path);
+            free_gachalist(list);
+            free(history_path);
+            return 1;
+        }
+
+        printf("最近 %d 次抽取：\n", n);
+        for (int i = 0; i < n; i++) {
+            char when[32];
+            format_history_time(records[i].timestamp, when, sizeof(when));
+            const char* name = list != NULL && records[i].item < (uint32_t)list->size
+                                   ? gachalist_item_name(list, (int)records[i].item) : "?";
+            printf("%s  会话 %u  #%u  【%s】%s\n", when, records[i].session, records[i].item,
+                   rank_name(records[i].rank), name);
+        }
+        free(records);
+        free_gachalist(list);
+        free(history_path);
+        return 0;
+    }
+
+    // 2. 聚合统计
+    HistoryQuery query;
+    query.since = options->since;
+    query.until = options->until;
+    query.item_count = 0;
+    query.item_counts = NULL;
+    if (options->by_item && list != NULL) {
+        query.item_count = list->size;
+        query.item_counts = (long long*)calloc((size_t)list->size, sizeof(long long));
+    }
+
+    clock_t start = clock();
+    if (history_query(history_path, &query) != 0) {
+        fprintf(stderr, "错误: 无法读取抽卡历史 %s\n", history_path);
+        free(query.item_counts);
+        free_gachalist(list);
+        free(history_path);
+        return 1;
+    }
+    double elapsed_ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+    printf("抽卡历史：%s\n", history_path);
+    printf("共 %lld 条记录，符合时间范围 %lld 条（扫描耗时 %.1f ms）\n",
+           query.total, query.matched, elapsed_ms);
+    if (query.matched > 0) {
+        char first[32], last[32];
+        format_history_time(query.first_time, first, sizeof(first));
+        format_history_time(query.last_time, last, sizeof(last));
+        printf("时间范围：%s ~ %s\n", first, last);
+    }
+
+    printf("\n各等级抽取次数：\n");
+    for (int k = 0; k < RANK_COUNT; k++) {
+        double share = query.matched > 0 ? (double)query.rank_counts[k] * 100.0 / query.matched : 0.0;
+        printf("【%s】%lld 次（%.2f%%）\n", rank_name(k), query.rank_counts[k], share);
+    }
+
+    if (query.item_counts != NULL) {
+        int* order = (int*)malloc((size_t)list->size * sizeof(int));
+        int shown = 0;
+        for (int i = 0; order != NULL && i < list->size; i++) {
+            if (query.item_counts[i] > 0) {
+                order[shown++] = i;
+            }
+        }
+        history_order = query.item_counts;
+        if (order != NULL) {
+            qsort(order, (size_t)shown, sizeof(int), compare_history_count);
+        }
+
+        printf("\n各条目抽取次数（%d 个条目）：\n", shown);
+        for (int k = 0; k < shown; k++) {
+            int i = order[k];
+            printf("#%d 【%s】%s  %lld 次\n", i, gachalist_item_rank(list, i),
+                   gachalist_item_name(list, i), query.item_counts[i]);
+        }
+        free(order);
+    } else if (options->by_item) {
+        fprintf(stderr, "警告: 无法读取 gachalist，不能按条目统计\n");
+    }
+
+    free(query.item_counts);
+    free_gachalist(list);
+    free(history_path);
+    return 0;
+}
+
+// scan 模式命令行选项
+typedef struct {
+    char** files;              // 待扫描的文件
+    int file_count;            // 文件数
+    int threads;               // 线程数（0 表示按 CPU 数）
+    int top;                   // 列出匹配次数最多的单词数
+} ScanOptions;
+
+// 解析 scan 模式选项（argv[start] 起），失败返回 -1
+int parse_scan_options(int argc, char* argv[], int start, ScanOptions* options) {
+    options->files = argv + start;
+    options->file_count = 0;
+    options->threads = 0;
+    options->top = SCAN_TOP_WORDS;
+
+    // 文件名原地收拢到 argv[start] 起，选项可与文件名交错
+    for (int i = start; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--threads") == 0 || strncmp(arg, "--threads=", 10) == 0) {
+            const char* value = arg[9] == '=' ? arg + 10 : (i + 1 < argc ? argv[++i] : "");
+            options->threads = parse_draw_count(value);
+            if (options->threads <= 0 || options->threads > SCAN_MAX_THREADS) {
+                fprintf(stderr, "错误: --threads 需要 1 到 %d 的整数\n", SCAN_MAX_THREADS);
+                return -1;
+            }
+        } else if (strcmp(arg, "--top") == 0 || strncmp(arg, "--top=", 6) == 0) {
+            const char* value = arg[5] == '=' ? arg + 6 : (i + 1 < argc ? argv[++i] : "");
+            options->top = parse_draw_count(value);
+            if (options->top <= 0) {
+                fprintf(stderr, "错误: --top 需要正整数\n");
+                return -1;
+            }
+        } else if (arg[0] == '-' && arg[1] != '\0') {
+            fprintf(stderr, "错误: 未知参数 %s\n", arg);
+            return -1;
+        } else {
+            options->files[options->file_count++] = argv[i];
+        }
+    }
+
+    if (options->file_count == 0) {
+        fprintf(stderr, "错误: --scan 需要至少一个文件\n");
+        return -1;
+    }
+    return 0;
+}
+
+// 运行 scan 模式（统计文件中字典单词的匹配次数，不计入抽卡余额）
+int run_scan_mode(const ScanOptions* options) {
+    // 1. 加载配置、字典与匹配器（与 chaos 模式相同的匹配规则）
+    alloc_set_phase(ALLOC_PHASE_CONFIG);
+    char* config_path = get_config_path();
+    GachaConfig* config = parse_config(config_path);
+    if (config == NULL) {
+        config = get_default_config();
+    }
+    if (config == NULL) {
+        fprintf(stderr, "错误: 无法加载配置\n");
+        free(config_path);
+        return 1;
+    }
+
+    alloc_set_phase(ALLOC_PHASE_LIST);
+    Dictionary* dict = dictionary_load(config, config_path);
+    if (dict == NULL || dict->size == 0) {
+        fprintf(stderr, "错误: 字典为空或无法加载\n");
+        dictionary_free(dict);
+        free_config(config);
+        free(config_path);
+        return 1;
+    }
+
+    Alphabet* alphabet = NULL;
+    if (load_alphabet(config, &alphabet) != 0) {
+        dictionary_free(dict);
+        free_config(config);
+        free(config_path);
+        return 1;
+    }
+
+    long long trace_start_ns = trace_begin();
+    MatcherState* ms = NULL;
+    alloc_set_phase(ALLOC_PHASE_INDEX);
+    if (alphabet != NULL) {
+        ms = matcher_init_symbols(dict->words, dict->size, config->matcher_buffer_size, alphabet);
+    } else {
+        // 大字典的 Trie 索引保存在配置目录，之后直接映射
+        char* index_path = resolve_config_relative_path(config_path, DATRIE_FILE_NAME);
+        ms = matcher_init(dict->words, dict->size, config->matcher_buffer_size,
+                          config->dictionary_ignore_case, index_path, dict->source_id);
+        free(index_path);
+    }
+    alloc_set_phase(ALLOC_PHASE_LIST);
+    Scanner* sc = scanner_create(ms, alphabet);
+    long long* counts = (long long*)calloc((size_t)dict->size, sizeof(long long));
+    trace_complete("matcher_init", trace_start_ns, 0);
+    if (ms == NULL || sc == NULL || counts == NULL) {
+        fprintf(stderr, "错误: 无法初始化匹配器（模式过多或过于复杂时无法编译）\n");
+        free(counts);
+        scanner_free(sc);
+        matcher_free(ms);
+        alphabet_free(alphabet);
+        dictionary_free(dict);
+        free_config(config);
+        free(config_path);
+        return 1;
+    }
+    warn_buffer_size(config, ms->max_word_length);
+
+    // 2. 逐个文件扫描
+    alloc_set_phase(ALLOC_PHASE_OTHER);
+    int threads = options->threads > 0 ? options->threads : scan_default_threads();
+    int failed = 0;
+    size_t total_bytes = 0;
+    long long total_matches = 0;
+    long long total_ns = 0;
+    for (int f = 0; f < options->file_count; f++) {
+        const char* path = options->files[f];
+        ScanStats stats;
+        trace_start_ns = trace_begin();
+        long long start_ns = trace_now();
+        if (scan_file(sc, path, threads, counts, &stats) != 0) {
+            fprintf(stderr, "错误: 无法扫描文件 %s\n", path);
+            failed = 1;
+            continue;
+        }
+        long long elapsed_ns = trace_now() - start_ns;
+        trace_complete("scan_file", trace_start_ns, (long long)stats.bytes);
+
+        double seconds = (double)elapsed_ns / 1e9;
+        printf("%s：%zu 字节，%lld 次匹配，耗时 %.2f ms，%.3f GiB/s（%d 线程",
+               path, stats.bytes, stats.matches, seconds * 1000.0,
+               seconds > 0.0 ? (double)stats.bytes / seconds / (1024.0 * 1024.0 * 1024.0) : 0.0,
+               stats.threads);
+        if (stats.resyncs > 0) {
+            printf("，%d 个分块修正起点", stats.resyncs);
+        }
+        printf("）\n");
+
+        total_bytes += stats.bytes;
+        total_matches += stats.matches;
+        total_ns += elapsed_ns;
+    }
+
+    // 3. 汇总与匹配次数最多的单词
+    if (options->file_count > 1) {
+        double seconds = (double)total_ns / 1e9;
+        printf("\n合计 %d 个文件：%zu 字节，%lld 次匹配，%.3f GiB/s\n", options->file_count,
+               total_bytes, total_matches,
+               seconds > 0.0 ? (double)total_bytes / seconds / (1024.0 * 1024.0 * 1024.0) : 0.0);
+    }
+
+    int* order = (int*)malloc((size_t)dict->size * sizeof(int));
+    int matched = 0;
+    for (int i = 0; order != NULL && i < dict->size; i++) {
+        if (counts[i] > 0) {
+            order[matched++] = i;
+        }
+    }
+    if (matched > 0) {
+        history_order = counts;
+        qsort(order, (size_t)matched, sizeof(int), compare_history_count);
+        int shown = matched < options->top ? matched : options->top;
+        printf("\n匹配次数最多的 %d 个单词（共 %d 个单词有匹配）：\n", shown, matched);
+        for (int k = 0; k < shown; k++) {
+            const DictWord* word = &dict->words[order[k]];
+            printf("%3d. %.*s  %lld 次\n", k + 1, word->length, word->text, counts[order[k]]);
+        }
+    }
+    free(order);
+
+    free(counts);
+    scanner_free(sc);
+    matcher_free(ms);
+    alphabet_free(alphabet);
+    dictionary_free(dict);
+    free_config(config);
+    free(config_path);
+    return failed;
+}
+
+// gacha 模式命令行选项
+typedef struct {
+    int draw_count;            // 抽取次数
+    int format;                // 输出格式（见 DRAW_FORMAT_*）
+    int unique;                // 是否不重复抽取
+    int secure;                // 是否使用安全随机模式（ChaCha20 + 系统熵源）
+    int top;                   // 列出抽中次数最多的菜数（0 表示不列出）
+    int seeded;                // 是否使用计数模式（--seed）
+    unsigned int seed;         // 计数模式的种子
+    int threads;               // 批量抽取的线程数（仅计数模式）
+    int histogram;             // 是否在退出时输出抽取耗时分布
+    const char* user;          // 用户 id（NULL 表示使用 gacha.conf 中的余额）
+} GachaOptions;
+
+// 解析 gacha 模式选项（argv[start] 起），失败返回 -1
+int parse_gacha_options(int argc, char* argv[], int start, GachaOptions* options) {
+    options->draw_count = 1;  // 默认值
+    options->format = DRAW_FORMAT_TEXT;
+    options->unique = 0;
+    options->secure = 0;
+    options->top = 0;
+    options->seeded = 0;
+    options->seed = 0;
+    options->threads = 1;
+    options->histogram = 0;
+    options->user = NULL;
+
+    int count_seen = 0;
+    for (int i = start; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = NULL;
+
+        if (strcmp(arg, "--unique") == 0) {
+            options->unique = 1;
+            continue;
+        }
+
+        if (strcmp(arg, "--secure") == 0) {
+            options->secure = 1;
+            continue;
+        }
+
+        if (strcmp(arg, "--top") == 0 || strncmp(arg, "--top=", 6) == 0) {
+            const char* top = arg[5] == '=' ? arg + 6 : (i + 1 < argc ? argv[++i] : "");
+            options->top = parse_draw_count(top);
+            if (options->top <= 0) {
+                fprintf(stderr, "错误: --top 需要正整数\n");
+                return -1;
+            }
+            continue;
+        }
+
+        if (strcmp(arg, "--seed") == 0 || strncmp(arg, "--seed=", 7) == 0) {
+            const char* seed = arg[6] == '=' ? arg + 7 : (i + 1 < argc ? argv[++i] : "");
+            char* end = NULL;
+            unsigned long long parsed = strtoull(seed, &end, 10);
+            if (seed[0] < '0' || seed[0] > '9' || *end != '\0' || parsed > UINT_MAX) {
+                fprintf(stderr, "错误: --seed 需要 0 到 %u 的整数\n", UINT_MAX);
+                return -1;
+            }
+            options->seeded = 1;
+            options->seed = (unsigned int)parsed;
+            continue;
+        }
+
+        if (strcmp(arg, "--threads") == 0 || strncmp(arg, "--threads=", 10) == 0) {
+            const char* threads = arg[9] == '=' ? arg + 10 : (i + 1 < argc ? argv[++i] : "");
+            options->threads = parse_draw_count(threads);
+            if (options->threads <= 0 || options->threads > GACHA_MAX_THREADS) {
+                fprintf(stderr, "错误: --threads 需要 1 到 %d 的整数\n", GACHA_MAX_THREADS);
+                return -1;
+            }
+            continue;
+        }
+
+        if (strcmp(arg, "--format") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "错误: --format 需要参数 (text|json|tsv|bin)\n");
+                return -1;
+            }
+            value = argv[++i];
+        } else if (strncmp(arg, "--format=", 9) == 0) {
+            value = arg + 9;
+        }
+
+        if (value != NULL) {
+            options->format = draw_format_parse(value);
+            if (options->format < 0) {
+                fprintf(stderr, "错误: 未知输出格式 %s (可选 text|json|tsv|bin)\n", value);
+                return -1;
+            }
+        } else if (!count_seen && (arg[0] != '-' || (arg[1] >= '0' && arg[1] <= '9'))) {
+            options->draw_count = parse_draw_count(arg);
+            if (options->draw_count <= 0) {
+                fprintf(stderr, "错误: 参数必须是正整数\n");
+                return -1;
+            }
+            count_seen = 1;
+        } else {
+            fprintf(stderr, "错误: 未知参数 %s\n", arg);
+            return -1;
+        }
+    }
+
+    if (options->seeded && options->secure) {
+        fprintf(stderr, "错误: --seed 与 --secure 不能同时使用\n");
+        return -1;
+    }
+    if (options->threads > 1 && !options->seeded) {
+        fprintf(stderr, "错误: --threads 需要与 --seed 一起使用\n");
+        return -1;
+    }
+
+    return 0;
+}
+
 // 运行 gacha 模式
-int run_gacha_mode(int draw_count) {
+int run_gacha_mode(const GachaOptions* options) {
+    int draw_count = options->draw_count;
+    int text_output = options->format == DRAW_FORMAT_TEXT;
+
     // 1. 加载配置文件获取历史总匹配次数
+    alloc_set_phase(ALLOC_PHASE_CONFIG);
+    long long trace_start_ns = trace_begin();
     char* config_path = get_config_path();
+    trace_complete("resolve_paths", trace_start_ns, 0);
+    trace_start_ns = trace_begin();
     GachaConfig* config = parse_config(config_path);
+    trace_complete("parse_config", trace_start_ns, 0);
     if (config == NULL) {
         fprintf(stderr, "错误: 无法加载配置文件\n");
         free(config_path);
         return 1;
     }
 
+    // 指定用户时余额取自多用户余额文件
+    BalanceStore* store = NULL;
     int balance = config->history_total_count;
+    if (options->user != NULL) {
+        store = open_balance_store();
+        if (store == NULL) {
+            free_config(config);
+            free(config_path);
+            return 1;
+        }
+        balance = clamp_balance(balance_get(store, options->user));
+    }
 
-    // 2. 检查余额
+    // 2. 检查余额（机器可读格式下提示信息写到 stderr）
     if (balance == 0) {
-        printf("剩余抽卡次数为 0\n");
+        fprintf(text_output ? stdout : stderr, "剩余抽卡次数为 0\n");
+        balance_close(store);
         free_config(config);
         free(config_path);
         return 0;
     }
 
     // 3. 加载 gachalist
+    alloc_set_phase(ALLOC_PHASE_LIST);
+    trace_start_ns = trace_begin();
     char* gachalist_path = get_gachalist_path();
+    trace_complete("resolve_paths", trace_start_ns, 0);
+    trace_start_ns = trace_begin();
     GachaList* list = read_gachalist(gachalist_path);
+    trace_complete("read_gachalist", trace_start_ns, list != NULL ? list->size : 0);
 
     if (list == NULL || list->size == 0) {
         fprintf(stderr, "错误: gachalist 为空或无法读取，使用内置默认列表\n");
@@ -241,6 +1371,7 @@ int run_gacha_mode(int draw_count) {
 
     if (list == NULL || list->size == 0) {
         fprintf(stderr, "错误: 无法加载 gachalist\n");
+        balance_close(store);
         free_config(config);
         free(config_path);
         free(gachalist_path);
@@ -248,17 +1379,53 @@ int run_gacha_mode(int draw_count) {
     }
 
     // 4. 初始化 gacha 模块
+    trace_start_ns = trace_begin();
     GachaState* state = gacha_init(gachalist_path, balance);
+    trace_complete("gacha_init", trace_start_ns, 0);
     if (state == NULL) {
         fprintf(stderr, "错误: 无法初始化 gacha 模块\n");
         free_gachalist(list);
+        balance_close(store);
+        free_config(config);
+        free(config_path);
+        free(gachalist_path);
+        return 1;
+    }
+
+    // 安全随机模式：无法读取系统熵源时不退回可预测的生成器
+    if (options->secure && random_generator_secure(state->rng) != 0) {
+        fprintf(stderr, "错误: 无法读取系统熵源，不能使用 --secure\n");
+        gacha_free(state);
+        free_gachalist(list);
+        balance_close(store);
+        free_config(config);
+        free(config_path);
+        free(gachalist_path);
+        return 1;
+    }
+
+    // 计数模式：第 i 次抽取只取决于种子与 i，按种子复现，多线程结果不变
+    if (options->seeded) {
+        random_generator_counter(state->rng, options->seed);
+        gacha_set_threads(state, options->threads);
+    }
+
+    if (options->histogram && gacha_enable_latency(state) != 0) {
+        fprintf(stderr, "警告: 内存不足，不输出抽取耗时分布\n");
+    }
+
+    // 5. 不重复抽取的次数不能超过条目数；检查余额是否足够
+    if (options->unique && draw_count > state->list->size) {
+        fprintf(stderr, "错误: 不重复抽取次数不能超过 gachalist 条目数（%d）\n", state->list->size);
+        gacha_free(state);
+        free_gachalist(list);
+        balance_close(store);
         free_config(config);
         free(config_path);
         free(gachalist_path);
         return 1;
     }
 
-    // 5. 检查余额是否足够
     int actual_draw_count = draw_count;
     if (!gacha_check_balance(state, draw_count)) {
         // 余额不足，确认是否继续
@@ -266,6 +1433,7 @@ int run_gacha_mode(int draw_count) {
             // 用户取消
             gacha_free(state);
             free_gachalist(list);
+            balance_close(store);
             free_config(config);
             free(config_path);
             free(gachalist_path);
@@ -274,39 +1442,117 @@ int run_gacha_mode(int draw_count) {
         actual_draw_count = balance;
     }
 
+    // 多用户余额先原子扣除（其他进程可能同时抽卡，实际扣到的次数可能更少）
+    if (store != NULL) {
+        long long left = 0;
+        long long taken = balance_take(store, options->user, actual_draw_count, &left);
+        if (taken == 0) {
+            fprintf(text_output ? stdout : stderr, "剩余抽卡次数为 0\n");
+            gacha_free(state);
+            free_gachalist(list);
+            balance_close(store);
+            free_config(config);
+            free(config_path);
+            free(gachalist_path);
+            return 0;
+        }
+        actual_draw_count = (int)taken;
+        balance = clamp_balance(left + taken);
+    }
+
     // 6. 显示当前余额
-    gacha_output_balance(balance);
+    if (text_output) {
+        gacha_output_balance(balance);
+    }
 
     // 7. 执行抽取
-    int actual_count = 0;
-    GachaResult* results = gacha_draw_multiple(state, actual_draw_count, &actual_count);
+    alloc_set_phase(ALLOC_PHASE_DRAW);
+    uint32_t* indices = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)actual_draw_count);
+    if (indices == NULL) {
+        fprintf(stderr, "错误: 内存不足\n");
+        gacha_free(state);
+        free_gachalist(list);
+        balance_close(store);
+        free_config(config);
+        free(config_path);
+        free(gachalist_path);
+        return 1;
+    }
+    trace_start_ns = trace_begin();
+    int actual_count = options->unique ? gacha_draw_unique(state, actual_draw_count, indices)
+                                       : gacha_draw_batch(state, actual_draw_count, indices);
+    trace_complete("draw", trace_start_ns, actual_count);
 
-    // 8. 输出结果
-    for (int i = 0; i < actual_count; i++) {
-        gacha_output_result(&results[i]);
+    // 未用完的扣除退回
+    if (store != NULL && actual_count < actual_draw_count) {
+        balance_credit(store, options->user, actual_draw_count - actual_count);
     }
 
+    // 记录抽卡历史（先于余额保存落盘）
+    trace_start_ns = trace_begin();
+    char* history_path = get_history_path();
+    HistoryWriter* history = history_open(history_path);
+    if (history != NULL) {
+        uint32_t now = (uint32_t)time(NULL);
+        for (int i = 0; i < actual_count; i++) {
+            history_append(history, now, indices[i], state->list->items[indices[i]].rank_index);
+        }
+    }
+    if (history == NULL || history_close(history) != 0) {
+        fprintf(stderr, "警告: 无法写入抽卡历史 %s\n", history_path != NULL ? history_path : HISTORY_FILE_NAME);
+    }
+    free(history_path);
+    trace_complete("history_append", trace_start_ns, actual_count);
+
+    // 8. 输出结果（整块缓冲写出）
+#ifdef _WIN32
+    if (options->format == DRAW_FORMAT_BIN) {
+        _setmode(_fileno(stdout), _O_BINARY);
+    }
+#endif
+    fflush(stdout);
+    trace_start_ns = trace_begin();
+    DrawWriter* writer = draw_writer_init(stdout, options->format, state->list, actual_count);
+    for (int i = 0; writer != NULL && i < actual_count; i++) {
+        draw_writer_write(writer, i + 1, indices[i], balance - (i + 1));
+    }
+    if (writer == NULL || draw_writer_finish(writer) != 0) {
+        fprintf(stderr, "警告: 抽取结果输出失败\n");
+    }
+    free(indices);
+
     // 9. 显示剩余余额
     int remaining_balance = balance - actual_count;
-    gacha_output_remaining_balance(remaining_balance);
+    if (text_output) {
+        gacha_output_remaining_balance(remaining_balance);
+
+        // 10. 输出统计
+        gacha_output_stats(state, options->top);
+    }
+    if (state->block_latency != NULL) {
+        // 机器可读格式下写到 stderr
+        FILE* fp = text_output ? stdout : stderr;
+        fprintf(fp, "\n每块抽取耗时：");
+        histogram_print(fp, state->block_latency, " ns");
+    }
+    trace_complete("output", trace_start_ns, actual_count);
 
-    // 10. 输出统计
-    gacha_output_stats(state);
+    alloc_set_phase(ALLOC_PHASE_OTHER);
 
-    // 11. 更新配置文件中的历史总匹配次数
-    config->history_total_count = remaining_balance;
-    if (save_config(config_path, config) != 0) {
-        fprintf(stderr, "警告: 无法保存配置文件\n");
+    // 11. 更新配置文件中的历史总匹配次数（多用户余额已在抽取前扣除）
+    if (store == NULL) {
+        config->history_total_count = remaining_balance;
+        trace_start_ns = trace_begin();
+        if (save_config(config_path, config) != 0) {
+            fprintf(stderr, "警告: 无法保存配置文件\n");
+        }
+        trace_complete("save_config", trace_start_ns, 0);
     }
 
     // 12. 清理资源
-    for (int i = 0; i < actual_count; i++) {
-        free(results[i].name);
-        free(results[i].rank);
-    }
-    free(results);
     gacha_free(state);
     free_gachalist(list);
+    balance_close(store);
     free_config(config);
     free(config_path);
     free(gachalist_path);
@@ -314,6 +1560,16 @@ int run_gacha_mode(int draw_count) {
     return 0;
 }
 
+// 退出时输出内存统计（写到 stderr，不影响机器可读输出）
+static void report_alloc_stats() {
+    alloc_report(stderr);
+}
+
+// 退出时写出跟踪事件
+static void write_trace() {
+    trace_finish();
+}
+
 int main(int argc, char* argv[]) {
     // 1. 检查版本参数（优先级最高）
     for (int i = 1; i < argc; i++) {
@@ -323,30 +1579,131 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    // 2. 初始化配置文件
+    // 2. 提取 --stats、--histogram、--metrics-file PATH 与 --trace FILE（可出现在任意位置），
+    //    退出时输出内存统计、分布与跟踪事件
+    int kept = 1;
+    int show_stats = 0;
+    int histogram = 0;
+    const char* trace_path = NULL;
+    const char* metrics_path = NULL;
+    const char* user = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--stats") == 0) {
+            show_stats = 1;
+        } else if (strcmp(argv[i], "--histogram") == 0) {
+            histogram = 1;
+        } else if (strcmp(argv[i], "--user") == 0 || strncmp(argv[i], "--user=", 7) == 0) {
+            user = argv[i][6] == '=' ? argv[i] + 7 : (i + 1 < argc ? argv[++i] : "");
+            if (!balance_valid_id(user)) {
+                fprintf(stderr, "错误: --user 需要 1 到 %d 字节的用户 id\n", BALANCE_ID_MAX);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "错误: --trace 需要输出文件路径\n");
+                print_usage();
+                return 1;
+            }
+            trace_path = argv[++i];
+        } else if (strncmp(argv[i], "--trace=", 8) == 0) {
+            trace_path = argv[i] + 8;
+        } else if (strcmp(argv[i], "--metrics-file") == 0 || strncmp(argv[i], "--metrics-file=", 15) == 0) {
+            metrics_path = argv[i][14] == '=' ? argv[i] + 15 : (i + 1 < argc ? argv[++i] : "");
+            if (metrics_path[0] == '\0') {
+                fprintf(stderr, "错误: --metrics-file 需要输出文件路径\n");
+                return 1;
+            }
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    argv[argc] = NULL;
+    if (show_stats) {
+        atexit(report_alloc_stats);
+    }
+    if (trace_path != NULL) {
+        if (trace_start(trace_path) != 0) {
+            fprintf(stderr, "错误: 无法创建跟踪文件 %s\n", trace_path);
+            return 1;
+        }
+        atexit(write_trace);
+    }
+
+    // 3. 初始化配置文件
+    alloc_set_phase(ALLOC_PHASE_CONFIG);
     init_config_files();
+    alloc_set_phase(ALLOC_PHASE_OTHER);
 
-    // 3. 解析命令行参数
+    // 4. 解析命令行参数
     if (argc < 2) {
         print_usage();
         return 1;
     }
 
+    if (user != NULL && strcmp(argv[1], "-c") != 0 && strcmp(argv[1], "-g") != 0) {
+        fprintf(stderr, "错误: --user 只能用于 -c 与 -g\n");
+        return 1;
+    }
+    if (histogram && strcmp(argv[1], "-c") != 0 && strcmp(argv[1], "-g") != 0) {
+        fprintf(stderr, "错误: --histogram 只能用于 -c 与 -g\n");
+        return 1;
+    }
+    if (metrics_path != NULL && strcmp(argv[1], "-c") != 0) {
+        fprintf(stderr, "错误: --metrics-file 只能用于 -c\n");
+        return 1;
+    }
+
     if (strcmp(argv[1], "-c") == 0) {
         // Chaos 模式（第一版功能）
-        return run_chaos_mode();
+        return run_chaos_mode(user, histogram, metrics_path);
     } else if (strcmp(argv[1], "-g") == 0) {
         // Gacha 模式（第二版功能）
-        int draw_count = 1;  // 默认值
-        if (argc > 2) {
-            draw_count = parse_draw_count(argv[2]);
-            if (draw_count <= 0) {
-                fprintf(stderr, "错误: 参数必须是正整数\n");
+        GachaOptions options;
+        if (parse_gacha_options(argc, argv, 2, &options) != 0) {
+            print_usage();
+            return 1;
+        }
+        options.user = user;
+        options.histogram = histogram;
+        return run_gacha_mode(&options);
+    } else if (strcmp(argv[1], "--history") == 0) {
+        // 抽卡历史查询
+        HistoryOptions options;
+        if (parse_history_options(argc, argv, 2, &options) != 0) {
+            print_usage();
+            return 1;
+        }
+        return run_history_mode(&options);
+    } else if (strcmp(argv[1], "--estimate") == 0) {
+        // 解析估算模式
+        return run_estimate_mode();
+    } else if (strcmp(argv[1], "--analyze") == 0) {
+        // 奖池解析模式
+        int top = ANALYZE_TOP_DISHES;
+        for (int i = 2; i < argc; i++) {
+            if (strcmp(argv[i], "--top") == 0 || strncmp(argv[i], "--top=", 6) == 0) {
+                const char* value = argv[i][5] == '=' ? argv[i] + 6 : (i + 1 < argc ? argv[++i] : "");
+                top = parse_draw_count(value);
+                if (top <= 0) {
+                    fprintf(stderr, "错误: --top 需要正整数\n");
+                    return 1;
+                }
+            } else {
+                fprintf(stderr, "错误: 未知参数 %s\n", argv[i]);
                 print_usage();
                 return 1;
             }
         }
-        return run_gacha_mode(draw_count);
+        return run_analyze_mode(top);
+    } else if (strcmp(argv[1], "--scan") == 0) {
+        // 文件扫描模式
+        ScanOptions options;
+        if (parse_scan_options(argc, argv, 2, &options) != 0) {
+            print_usage();
+            return 1;
+        }
+        return run_scan_mode(&options);
     } else if (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
         // 帮助信息
         print_help();
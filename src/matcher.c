@@ -3,124 +3,291 @@
 #include <stdlib.h>
 #include <string.h>
 
-// 初始化匹配器
-MatcherState* matcher_init(char** dictionary, int dictionary_size) {
-    if (dictionary == NULL || dictionary_size <= 0) {
-        return NULL;
+#include "alloc.h"
+
+// 记录匹配间隔（单词首次匹配时才分配直方图）
+static void record_gap(MatcherState* ms, int best) {
+    if (ms->gaps[best] == NULL) {
+        ms->gaps[best] = histogram_create();
+        if (ms->gaps[best] == NULL) {
+            return;
+        }
     }
+    histogram_record(ms->gaps[best], ms->letter_count - ms->last_match[best]);
+    ms->last_match[best] = ms->letter_count;
+}
 
-    MatcherState* ms = (MatcherState*)malloc(sizeof(MatcherState));
-    if (ms == NULL) {
-        return NULL;
+// 记录匹配
+static inline void record_match(MatcherState* ms, int best) {
+    if (best >= 0) {
+        if (ms->gaps != NULL) {
+            record_gap(ms, best);
+        }
+        ms->match_counts[best]++;
+        ms->total_count++;
+        if (ms->match_counts[best] > ms->top_match_count) {
+            ms->top_match_count = ms->match_counts[best];
+        }
     }
+}
 
-    // 初始化缓冲区
-    ms->buffer_size = BUFFER_SIZE;
-    ms->buffer = (char*)malloc(ms->buffer_size * sizeof(char));
-    if (ms->buffer == NULL) {
-        free(ms);
+// 分配匹配器并初始化计数
+static MatcherState* matcher_create(const DictWord* dictionary, int dictionary_size) {
+    MatcherState* ms = (MatcherState*)malloc(sizeof(MatcherState));
+    if (ms == NULL) {
         return NULL;
     }
 
-    // 初始化缓冲区状态
-    ms->buffer_pos = 0;
-    ms->buffer_len = 0;
-
     // 保存字典
     ms->dictionary = dictionary;
     ms->dictionary_size = dictionary_size;
+    ms->buffer_size = 0;
+    ms->trie = NULL;
+    ms->trie_state = 0;
+    ms->dfa = NULL;
+    ms->dfa_state = 0;
+    ms->letter_count = 0;
+    ms->last_match = NULL;
+    ms->gaps = NULL;
 
     // 初始化匹配计数
     ms->match_counts = (int*)calloc(dictionary_size, sizeof(int));
     if (ms->match_counts == NULL) {
-        free(ms->buffer);
         free(ms);
         return NULL;
     }
 
     ms->total_count = 0;
+    ms->top_match_count = 0;
     ms->max_match_count = MAX_MATCH_COUNT;
-    ms->min_search_index = 0;  // 从缓冲区开头搜索
+    ms->max_word_length = 0;
+    return ms;
+}
+
+// 初始化匹配器
+MatcherState* matcher_init(const DictWord* dictionary, int dictionary_size, int buffer_size,
+                           int ignore_case, const char* index_path, uint64_t source_id) {
+    if (dictionary == NULL || dictionary_size <= 0) {
+        return NULL;
+    }
+
+    MatcherState* ms = matcher_create(dictionary, dictionary_size);
+    if (ms == NULL) {
+        return NULL;
+    }
 
+    // 统计最长单词（按匹配的字母数，模式中的 ? 与字符类各算一个字母）
+    int needs_dfa = ignore_case || pattern_any_syntax(dictionary, dictionary_size);
+    size_t total_length = 0;
+    for (int i = 0; i < dictionary_size; i++) {
+        total_length += (size_t)dictionary[i].length;
+        int length = needs_dfa ? pattern_length(dictionary[i].text, dictionary[i].length)
+                               : dictionary[i].length;
+        if (length > ms->max_word_length) {
+            ms->max_word_length = length;
+        }
+    }
+
+    // 匹配窗口至少容纳最长单词
+    if (buffer_size <= 0) {
+        buffer_size = BUFFER_SIZE;
+        if (buffer_size < ms->max_word_length) {
+            buffer_size = ms->max_word_length;
+        }
+    }
+
+    // 模式必须编译为 DFA；纯字面单词规模较小时同样走 DFA（每个字母一次查表）
+    if (needs_dfa || total_length <= PATTERN_MAX_POSITIONS) {
+        ms->dfa = pattern_compile(dictionary, dictionary_size, ignore_case, buffer_size);
+    }
+    if (ms->dfa == NULL && !needs_dfa) {
+        // 超过缓冲区的单词不会匹配，不建入 Trie
+        ms->trie = datrie_load(dictionary, dictionary_size, buffer_size, index_path, source_id);
+    }
+    if (ms->dfa == NULL && ms->trie == NULL) {
+        matcher_free(ms);
+        return NULL;
+    }
+
+    ms->buffer_size = buffer_size;
     return ms;
 }
 
-// 处理新生成的字母
-int matcher_process_letter(MatcherState* ms, char letter, char* matched_word) {
-    if (ms == NULL || matched_word == NULL) {
-        return 0;
+// 按自定义字母表初始化匹配器
+MatcherState* matcher_init_symbols(const DictWord* dictionary, int dictionary_size,
+                                   int buffer_size, const Alphabet* alphabet) {
+    if (dictionary == NULL || dictionary_size <= 0 || alphabet == NULL) {
+        return NULL;
     }
 
-    // 1. 将字母添加到缓冲区
-    ms->buffer[ms->buffer_pos] = letter;
-    ms->buffer_pos = (ms->buffer_pos + 1) % ms->buffer_size;
+    MatcherState* ms = matcher_create(dictionary, dictionary_size);
+    if (ms == NULL) {
+        return NULL;
+    }
 
-    // 更新有效数据长度
-    if (ms->buffer_len < ms->buffer_size) {
-        ms->buffer_len++;
+    // 单词转换为编号序列（字符数不超过字节数），含字母表以外字符的单词记为空
+    size_t total_length = 0;
+    for (int i = 0; i < dictionary_size; i++) {
+        total_length += (size_t)dictionary[i].length;
+    }
+    uint16_t* symbols = (uint16_t*)malloc((total_length + 1) * sizeof(uint16_t));
+    int* offsets = (int*)malloc(((size_t)dictionary_size + 1) * sizeof(int));
+    if (symbols == NULL || offsets == NULL) {
+        free(symbols);
+        free(offsets);
+        matcher_free(ms);
+        return NULL;
     }
 
-    // 2. 在缓冲区中搜索字典单词
-    for (int i = 0; i < ms->dictionary_size; i++) {
-        const char* word = ms->dictionary[i];
-        if (word == NULL) {
-            continue;
+    offsets[0] = 0;
+    for (int i = 0; i < dictionary_size; i++) {
+        int length = alphabet_encode(alphabet, dictionary[i].text, dictionary[i].length,
+                                     symbols + offsets[i]);
+        if (length < 0) {
+            length = 0;
+        }
+        if (length > ms->max_word_length) {
+            ms->max_word_length = length;
         }
+        offsets[i + 1] = offsets[i] + length;
+    }
 
-        int word_len = strlen(word);
-        if (word_len == 0 || word_len > ms->buffer_len) {
-            continue;
+    if (buffer_size <= 0) {
+        buffer_size = BUFFER_SIZE;
+        if (buffer_size < ms->max_word_length) {
+            buffer_size = ms->max_word_length;
         }
+    }
+
+    ms->dfa = pattern_compile_symbols(symbols, offsets, dictionary_size, alphabet->size, buffer_size);
+    free(symbols);
+    free(offsets);
+    if (ms->dfa == NULL) {
+        matcher_free(ms);
+        return NULL;
+    }
+
+    ms->buffer_size = buffer_size;
+    return ms;
+}
+
+// 处理新生成的字母
+int matcher_process_letter(MatcherState* ms, char letter) {
+    if (ms == NULL) {
+        return -1;
+    }
+
+    ms->letter_count++;
 
-        // 从 min_search_index 开始搜索，避免重复匹配旧位置
-        for (int j = ms->min_search_index; j <= ms->buffer_len - word_len; j++) {
-            int match = 1;
-
-            // 检查单词是否匹配
-            for (int k = 0; k < word_len; k++) {
-                // 计算缓冲区中的位置
-                int buffer_index = (ms->buffer_pos - ms->buffer_len + j + k + ms->buffer_size) % ms->buffer_size;
-
-                if (ms->buffer[buffer_index] != word[k]) {
-                    match = 0;
-                    break;
-                }
-            }
-
-            // 如果匹配成功
-            if (match) {
-                // 更新最小搜索索引，跳过已匹配的位置
-                ms->min_search_index = j + word_len;
-                // 不要重置 min_search_index，保持它继续增长
-
-
-                ms->match_counts[i]++;
-                ms->total_count++;
-                strcpy(matched_word, word);
-                return 1;  // 匹配成功
-            }
+    // 1. 查找以当前字母结尾的字典单词
+    //    只考虑上次匹配之后的字母，多个单词同时匹配时字典序号小者优先
+    int best = -1;
+    if (ms->dfa != NULL) {
+        // DFA：每个字母一次查表，接受状态的转移与初始状态相同（匹配后从头开始）
+        unsigned int symbol = ms->dfa->symbol_of[(unsigned char)letter];
+        int state = 0;
+        if (symbol != PATTERN_NO_SYMBOL) {
+            state = ms->dfa->next[(size_t)ms->dfa_state * ms->dfa->alphabet_size + symbol];
         }
+        ms->dfa_state = state;
+        best = ms->dfa->accept[state];
+    } else {
+        // Trie：匹配后回到根，新匹配只考虑上次匹配之后的字母
+        int state = datrie_next(ms->trie, ms->trie_state, (unsigned char)letter);
+        best = datrie_word(ms->trie, state);
+        ms->trie_state = best >= 0 ? 0 : state;
     }
 
-    return 0;  // 未匹配
+    // 2. 记录匹配
+    record_match(ms, best);
+    return best;
 }
 
-// 检查是否应该结束
-int matcher_should_end(const MatcherState* ms) {
+// 处理新生成的字母表编号
+int matcher_process_symbol(MatcherState* ms, int symbol) {
     if (ms == NULL) {
+        return -1;
+    }
+
+    ms->letter_count++;
+    int state = ms->dfa->next[(size_t)ms->dfa_state * ms->dfa->alphabet_size + symbol];
+    ms->dfa_state = state;
+
+    int best = ms->dfa->accept[state];
+    record_match(ms, best);
+    return best;
+}
+
+// 清空 DFA / Trie 状态（匹配次数保留）
+void matcher_reset(MatcherState* ms) {
+    if (ms == NULL) {
+        return;
+    }
+
+    ms->dfa_state = 0;
+    ms->trie_state = 0;
+}
+
+// 启用匹配间隔统计
+int matcher_enable_histograms(MatcherState* ms) {
+    if (ms == NULL) {
+        return -1;
+    }
+    if (ms->gaps != NULL) {
         return 0;
     }
 
-    // 检查是否有单词匹配次数达到阈值
-    for (int i = 0; i < ms->dictionary_size; i++) {
-        if (ms->match_counts[i] >= ms->max_match_count) {
-            return 1;
-        }
+    ms->last_match = (long long*)malloc((size_t)ms->dictionary_size * sizeof(long long));
+    ms->gaps = (Histogram**)calloc((size_t)ms->dictionary_size, sizeof(Histogram*));
+    if (ms->last_match == NULL || ms->gaps == NULL) {
+        free(ms->last_match);
+        free(ms->gaps);
+        ms->last_match = NULL;
+        ms->gaps = NULL;
+        return -1;
     }
 
+    // 之前的字母不计入（首次匹配从启用时算起）
+    for (int i = 0; i < ms->dictionary_size; i++) {
+        ms->last_match[i] = ms->letter_count;
+    }
     return 0;
 }
 
+// 获取单词的匹配间隔分布
+const Histogram* matcher_gap_histogram(const MatcherState* ms, int word_index) {
+    if (ms == NULL || ms->gaps == NULL || word_index < 0 || word_index >= ms->dictionary_size) {
+        return NULL;
+    }
+    return ms->gaps[word_index];
+}
+
+// 获取匹配的字母数
+int matcher_match_length(const MatcherState* ms, int word_index) {
+    if (ms == NULL || word_index < 0 || word_index >= ms->dictionary_size) {
+        return 0;
+    }
+    return ms->dfa != NULL ? ms->dfa->lengths[word_index] : ms->dictionary[word_index].length;
+}
+
+// 获取字典单词
+const DictWord* matcher_get_word(const MatcherState* ms, int word_index) {
+    if (ms == NULL || word_index < 0 || word_index >= ms->dictionary_size) {
+        return NULL;
+    }
+    return &ms->dictionary[word_index];
+}
+
+// 检查是否应该结束
+int matcher_should_end(const MatcherState* ms) {
+    if (ms == NULL) {
+        return 0;
+    }
+
+    // 检查是否有单词匹配次数达到阈值
+    return ms->top_match_count >= ms->max_match_count;
+}
+
 // 获取总匹配次数
 int matcher_get_total_count(const MatcherState* ms) {
     if (ms == NULL) {
@@ -135,13 +302,20 @@ void matcher_free(MatcherState* ms) {
         return;
     }
 
-    if (ms->buffer != NULL) {
-        free(ms->buffer);
-    }
-
     if (ms->match_counts != NULL) {
         free(ms->match_counts);
     }
 
+    datrie_free(ms->trie);
+    pattern_dfa_free(ms->dfa);
+
+    if (ms->gaps != NULL) {
+        for (int i = 0; i < ms->dictionary_size; i++) {
+            histogram_free(ms->gaps[i]);
+        }
+        free(ms->gaps);
+    }
+    free(ms->last_match);
+
     free(ms);
 }
@@ -2,36 +2,75 @@
 #define GACHA_MATCHER_H
 
 #include <stddef.h>
+#include "alphabet.h"
+#include "datrie.h"
+#include "dictionary.h"
+#include "histogram.h"
+#include "pattern.h"
 
 // 匹配状态
 typedef struct {
-    char* buffer;            // 缓冲区（存储最近生成的字母）
-    int buffer_size;         // 缓冲区大小
-    int buffer_pos;          // 当前位置
-    int buffer_len;          // 当前缓冲区中有效数据长度
+    int buffer_size;         // 匹配窗口长度（更长的单词不建入 DFA / Trie，不会匹配）
 
-    char** dictionary;       // 字典
+    const DictWord* dictionary; // 字典（不持有）
     int dictionary_size;     // 字典大小
 
     int* match_counts;       // 各单词匹配次数
     int total_count;         // 总匹配次数
+    int top_match_count;     // 单个单词的最高匹配次数
 
     int max_match_count;     // 最大匹配次数（结束条件）
 
-    int min_search_index;    // 最小搜索索引（避免重复匹配旧位置）
+    Datrie* trie;               // 字典双数组 Trie（大字典的字面单词）
+    int trie_state;             // Trie 当前状态
+    int max_word_length;        // 最长单词的字母数
+
+    PatternDfa* dfa;            // 模式 DFA（NULL 表示使用 Trie）
+    int dfa_state;              // DFA 当前状态
+
+    long long letter_count;     // 已处理的字母数
+    long long* last_match;      // 各单词上次匹配时的字母数（启用间隔统计后分配）
+    Histogram** gaps;           // 各单词相邻两次匹配之间的字母数分布（NULL 表示未启用，单词首次匹配时分配）
 } MatcherState;
 
 // 默认配置
-#define BUFFER_SIZE 256      // 缓冲区大小
+#define BUFFER_SIZE 256      // 默认匹配窗口长度
 #define MAX_MATCH_COUNT 3    // 最大匹配次数
 
 // 核心函数
 
-// 初始化匹配器
-MatcherState* matcher_init(char** dictionary, int dictionary_size);
+// 初始化匹配器（buffer_size <= 0 时自动取 BUFFER_SIZE 与最长单词中的较大者）
+//   字典含模式语法或忽略大小写时编译为 DFA；纯字面单词在规模允许时也走 DFA，否则使用双数组 Trie
+//   index_path 非 NULL 时 Trie 映射该索引文件，不存在或与字典不符时构建并保存；
+//   source_id 为字典来源标识（见 Dictionary），未知时传 0（每次比较内容指纹）
+MatcherState* matcher_init(const DictWord* dictionary, int dictionary_size, int buffer_size,
+                           int ignore_case, const char* index_path, uint64_t source_id);
+
+// 按自定义字母表初始化匹配器（单词按 UTF-8 字符逐字匹配，编译为 DFA）
+//   含字母表以外字符的单词不会匹配；buffer_size 按字符计，<= 0 时自动选择
+MatcherState* matcher_init_symbols(const DictWord* dictionary, int dictionary_size,
+                                   int buffer_size, const Alphabet* alphabet);
+
+// 清空 DFA / Trie 状态，下一个字母从头匹配（匹配次数保留）
+void matcher_reset(MatcherState* ms);
+
+// 处理新生成的字母，返回匹配的字典序号（未匹配返回 -1）
+int matcher_process_letter(MatcherState* ms, char letter);
+
+// 处理新生成的字母表编号（仅用于 matcher_init_symbols 创建的匹配器），返回匹配的字典序号
+int matcher_process_symbol(MatcherState* ms, int symbol);
+
+// 启用匹配间隔统计（每个单词相邻两次匹配之间的字母数，首次匹配从启用时算起），失败返回 -1
+int matcher_enable_histograms(MatcherState* ms);
+
+// 获取单词的匹配间隔分布（未启用或尚未匹配时返回 NULL）
+const Histogram* matcher_gap_histogram(const MatcherState* ms, int word_index);
+
+// 获取匹配的字母数（模式按字母计，失败返回 0）
+int matcher_match_length(const MatcherState* ms, int word_index);
 
-// 处理新生成的字母
-int matcher_process_letter(MatcherState* ms, char letter, char* matched_word);
+// 获取字典单词
+const DictWord* matcher_get_word(const MatcherState* ms, int word_index);
 
 // 检查是否应该结束
 int matcher_should_end(const MatcherState* ms);
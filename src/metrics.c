@@ -0,0 +1,296 @@
+#include "metrics.h"
+#include "random.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <process.h>
+#else
+    #include <signal.h>
+    #include <unistd.h>
+#endif
+
+#include "alloc.h"
+
+// 输出标签值（转义反斜杠、双引号与换行）
+static void write_label(FILE* fp, const char* value, size_t length) {
+    for (const char* p = value; p < value + length; p++) {
+        if (*p == '\\') {
+            fputs("\\\\", fp);
+        } else if (*p == '"') {
+            fputs("\\\"", fp);
+        } else if (*p == '\n') {
+            fputs("\\n", fp);
+        } else {
+            fputc(*p, fp);
+        }
+    }
+}
+
+// 输出全部指标
+static void write_body(FILE* fp, MetricsExporter* m, long long letters, double letters_per_second) {
+    long long matches = atomic_load_explicit(&m->matches, memory_order_relaxed);
+
+    fprintf(fp, "# HELP gacha_letters_total Letters generated in this run.\n");
+    fprintf(fp, "# TYPE gacha_letters_total counter\n");
+    fprintf(fp, "gacha_letters_total %lld\n", letters);
+
+    fprintf(fp, "# HELP gacha_matches_total Dictionary matches in this run.\n");
+    fprintf(fp, "# TYPE gacha_matches_total counter\n");
+    fprintf(fp, "gacha_matches_total %lld\n", matches);
+
+    // 只输出已匹配的单词，大字典的指标文件不会随字典规模膨胀
+    fprintf(fp, "# HELP gacha_word_matches_total Matches per dictionary word in this run.\n");
+    fprintf(fp, "# TYPE gacha_word_matches_total counter\n");
+    for (int i = 0; i < m->dictionary_size; i++) {
+        int count = atomic_load_explicit(&m->word_matches[i], memory_order_relaxed);
+        if (count > 0) {
+            fputs("gacha_word_matches_total{word=\"", fp);
+            write_label(fp, m->dictionary[i].text, (size_t)m->dictionary[i].length);
+            fprintf(fp, "\"} %d\n", count);
+        }
+    }
+
+    fprintf(fp, "# HELP gacha_balance Current balance (history total matches plus this run).\n");
+    fprintf(fp, "# TYPE gacha_balance gauge\n");
+    if (m->user != NULL) {
+        fputs("gacha_balance{user=\"", fp);
+        write_label(fp, m->user, strlen(m->user));
+        fprintf(fp, "\"} %lld\n", m->base_balance + matches);
+    } else {
+        fprintf(fp, "gacha_balance %lld\n", m->base_balance + matches);
+    }
+
+    fprintf(fp, "# HELP gacha_letters_per_second Letters generated per second since the previous write.\n");
+    fprintf(fp, "# TYPE gacha_letters_per_second gauge\n");
+    fprintf(fp, "gacha_letters_per_second %.3f\n", letters_per_second);
+
+    fprintf(fp, "# HELP gacha_loop_latency_seconds Time spent generating and matching one pacer tick.\n");
+    fprintf(fp, "# TYPE gacha_loop_latency_seconds summary\n");
+    for (int k = 0; k < HISTOGRAM_PERCENTILE_COUNT; k++) {
+        long long value = atomic_load_explicit(&m->loop_quantiles[k], memory_order_relaxed);
+        fprintf(fp, "gacha_loop_latency_seconds{quantile=\"%g\"} %.9f\n",
+                histogram_percentile_level(k), (double)value / 1e9);
+    }
+    fprintf(fp, "gacha_loop_latency_seconds_sum %.9f\n",
+            (double)atomic_load_explicit(&m->loop_sum_ns, memory_order_relaxed) / 1e9);
+    fprintf(fp, "gacha_loop_latency_seconds_count %lld\n",
+            atomic_load_explicit(&m->loop_count, memory_order_relaxed));
+}
+
+// 写出指标文件（先写临时文件再替换），失败返回 -1
+static int write_metrics(MetricsExporter* m, long long now) {
+    long long letters = atomic_load_explicit(&m->letters, memory_order_relaxed);
+    double letters_per_second = 0.0;
+    if (now > m->last_write_ns && m->last_write_ns > 0) {
+        letters_per_second = (double)(letters - m->last_letters) * 1e9 / (double)(now - m->last_write_ns);
+    }
+    m->last_letters = letters;
+    m->last_write_ns = now;
+
+    FILE* fp = fopen(m->tmp_path, "w");
+    if (fp == NULL) {
+        return -1;
+    }
+    write_body(fp, m, letters, letters_per_second);
+
+    int result = ferror(fp) ? -1 : 0;
+    if (fclose(fp) != 0) {
+        result = -1;
+    }
+    if (result == 0) {
+#ifdef _WIN32
+        result = MoveFileExA(m->tmp_path, m->path, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+        result = rename(m->tmp_path, m->path) == 0 ? 0 : -1;
+#endif
+    }
+    if (result != 0) {
+        remove(m->tmp_path);
+    }
+    return result;
+}
+
+// 导出线程：按间隔写出指标（写出失败时保留上一份文件，下次重试）
+static void metrics_loop(MetricsExporter* m) {
+    long long interval_ns = (long long)METRICS_INTERVAL_MS * 1000000;
+
+    trace_thread_begin("metrics");
+    while (!atomic_load_explicit(&m->closed, memory_order_acquire)) {
+        sleep_ms(METRICS_POLL_MS);
+
+        long long now = trace_now();
+        if (now - m->last_write_ns >= interval_ns) {
+            long long write_start = trace_begin();
+            write_metrics(m, now);
+            trace_complete("metrics_write", write_start, 0);
+        }
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI metrics_thread_main(LPVOID arg) {
+    metrics_loop((MetricsExporter*)arg);
+    return 0;
+}
+#else
+static void* metrics_thread_main(void* arg) {
+    metrics_loop((MetricsExporter*)arg);
+    return NULL;
+}
+#endif
+
+// 释放导出状态
+static void metrics_free(MetricsExporter* m) {
+    free(m->word_matches);
+    histogram_free(m->loop_window);
+    free(m->tmp_path);
+    free(m->path);
+    free(m);
+}
+
+// 写出第一份指标文件并启动导出线程
+MetricsExporter* metrics_start(const char* path, const DictWord* dictionary, int dictionary_size,
+                               long long base_balance, const char* user) {
+    if (path == NULL || dictionary == NULL || dictionary_size <= 0) {
+        return NULL;
+    }
+
+    MetricsExporter* m = (MetricsExporter*)calloc(1, sizeof(MetricsExporter));
+    if (m == NULL) {
+        return NULL;
+    }
+
+    size_t path_length = strlen(path);
+    m->path = (char*)malloc(path_length + 1);
+    m->tmp_path = (char*)malloc(path_length + 32);
+    m->word_matches = (atomic_int*)malloc((size_t)dictionary_size * sizeof(atomic_int));
+    m->loop_window = histogram_create();
+    if (m->path == NULL || m->tmp_path == NULL || m->word_matches == NULL || m->loop_window == NULL) {
+        metrics_free(m);
+        return NULL;
+    }
+    memcpy(m->path, path, path_length + 1);
+    // 临时文件与目标在同一目录，替换是原子的；textfile 采集器只读取 *.prom，不会读到临时文件
+#ifdef _WIN32
+    snprintf(m->tmp_path, path_length + 32, "%s.%d.tmp", path, _getpid());
+#else
+    snprintf(m->tmp_path, path_length + 32, "%s.%d.tmp", path, (int)getpid());
+#endif
+
+    atomic_init(&m->letters, 0);
+    atomic_init(&m->matches, 0);
+    atomic_init(&m->loop_count, 0);
+    atomic_init(&m->loop_sum_ns, 0);
+    for (int k = 0; k < HISTOGRAM_PERCENTILE_COUNT; k++) {
+        atomic_init(&m->loop_quantiles[k], 0);
+    }
+    for (int i = 0; i < dictionary_size; i++) {
+        atomic_init(&m->word_matches[i], 0);
+    }
+    atomic_init(&m->closed, 0);
+    m->dictionary = dictionary;
+    m->dictionary_size = dictionary_size;
+    m->base_balance = base_balance;
+    m->user = user;
+    m->window_start_ns = trace_now();
+
+    // 先同步写出一次，路径不可写时立即报错
+    if (write_metrics(m, m->window_start_ns) != 0) {
+        metrics_free(m);
+        return NULL;
+    }
+
+    // 启动导出线程
+#ifdef _WIN32
+    m->thread = CreateThread(NULL, 0, metrics_thread_main, m, 0, NULL);
+    if (m->thread == NULL) {
+        metrics_free(m);
+        return NULL;
+    }
+#else
+    // 导出线程不处理 Ctrl+C，信号统一由生成线程响应
+    sigset_t block, previous;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &block, &previous);
+    int error = pthread_create(&m->thread, NULL, metrics_thread_main, m);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if (error != 0) {
+        metrics_free(m);
+        return NULL;
+    }
+#endif
+
+    return m;
+}
+
+// 记录一次匹配（只有生成线程写入，读后写即可，无需原子读改写）
+void metrics_record_match(MetricsExporter* m, int word_index) {
+    if (m == NULL || word_index < 0 || word_index >= m->dictionary_size) {
+        return;
+    }
+
+    int count = atomic_load_explicit(&m->word_matches[word_index], memory_order_relaxed);
+    atomic_store_explicit(&m->word_matches[word_index], count + 1, memory_order_relaxed);
+    long long matches = atomic_load_explicit(&m->matches, memory_order_relaxed);
+    atomic_store_explicit(&m->matches, matches + 1, memory_order_relaxed);
+}
+
+// 发布当前窗口的循环耗时分位数并开始新窗口
+static void publish_window(MetricsExporter* m, long long now) {
+    for (int k = 0; k < HISTOGRAM_PERCENTILE_COUNT; k++) {
+        long long value = histogram_percentile(m->loop_window, histogram_percentile_level(k));
+        atomic_store_explicit(&m->loop_quantiles[k], value, memory_order_relaxed);
+    }
+    histogram_reset(m->loop_window);
+    m->window_start_ns = now;
+}
+
+// 记录一个生成循环
+void metrics_record_loop(MetricsExporter* m, long long letters, long long start_ns, long long end_ns) {
+    if (m == NULL) {
+        return;
+    }
+
+    long long duration = end_ns - start_ns;
+    histogram_record(m->loop_window, duration);
+
+    long long count = atomic_load_explicit(&m->loop_count, memory_order_relaxed);
+    atomic_store_explicit(&m->loop_count, count + 1, memory_order_relaxed);
+    long long sum = atomic_load_explicit(&m->loop_sum_ns, memory_order_relaxed);
+    atomic_store_explicit(&m->loop_sum_ns, sum + duration, memory_order_relaxed);
+    atomic_store_explicit(&m->letters, letters, memory_order_relaxed);
+
+    // 分位数每个窗口才计算一次，单次循环只多一次直方图记录
+    if (end_ns - m->window_start_ns >= (long long)METRICS_INTERVAL_MS * 1000000) {
+        publish_window(m, end_ns);
+    }
+}
+
+// 停止导出线程，写出最终指标并释放
+int metrics_finish(MetricsExporter* m) {
+    if (m == NULL) {
+        return -1;
+    }
+
+    atomic_store_explicit(&m->closed, 1, memory_order_release);
+#ifdef _WIN32
+    WaitForSingleObject(m->thread, INFINITE);
+    CloseHandle(m->thread);
+#else
+    pthread_join(m->thread, NULL);
+#endif
+
+    // 导出线程已结束，最后一个不完整窗口也计入分位数
+    long long now = trace_now();
+    if (m->loop_window->total > 0) {
+        publish_window(m, now);
+    }
+    int result = write_metrics(m, now);
+    metrics_free(m);
+    return result;
+}
@@ -0,0 +1,68 @@
+#ifndef GACHA_METRICS_H
+#define GACHA_METRICS_H
+
+#include <stdatomic.h>
+#include "dictionary.h"
+#include "histogram.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+
+// 默认配置
+#define METRICS_INTERVAL_MS 1000     // 指标文件写出间隔（毫秒），循环耗时分位数也按此窗口统计
+#define METRICS_POLL_MS 100          // 导出线程检查结束标志的间隔（毫秒）
+
+// 指标导出状态
+//   生成线程（唯一写者）只用 relaxed 原子存储发布计数，不加锁也不等待；
+//   导出线程定时读取并写出 Prometheus 文本格式，先写临时文件再替换，采集方不会读到半个文件
+typedef struct {
+    // 生成线程写入的计数与导出线程的字段分开放在不同缓存行
+    char pad_producer[64];
+    atomic_llong letters;                    // 已生成的字母数
+    atomic_llong matches;                    // 本次运行的总匹配次数
+    atomic_llong loop_count;                 // 已完成的生成循环（节拍）数
+    atomic_llong loop_sum_ns;                // 生成循环的总耗时（纳秒）
+    atomic_llong loop_quantiles[HISTOGRAM_PERCENTILE_COUNT]; // 最近一个窗口的循环耗时分位数（纳秒）
+    atomic_int* word_matches;                // 各单词的匹配次数
+    Histogram* loop_window;                  // 当前窗口的循环耗时（生成线程私有）
+    long long window_start_ns;               // 当前窗口的开始时间（生成线程私有）
+
+    char pad_exporter[64];
+    atomic_int closed;                       // 生成线程已结束
+    long long last_letters;                  // 上次写出时的字母数（导出线程私有）
+    long long last_write_ns;                 // 上次写出的时间（导出线程私有）
+    char pad_shared[64];
+
+    const DictWord* dictionary;  // 字典（不持有，只读）
+    int dictionary_size;         // 字典大小
+    long long base_balance;      // 本次运行之前的余额（历史总匹配次数）
+    const char* user;            // 用户 id（不持有；NULL 表示使用配置文件中的历史总数）
+    char* path;                  // 指标文件路径
+    char* tmp_path;              // 临时文件路径
+
+#ifdef _WIN32
+    HANDLE thread;               // 导出线程
+#else
+    pthread_t thread;            // 导出线程
+#endif
+} MetricsExporter;
+
+// 核心函数
+
+// 写出第一份指标文件并启动导出线程，写出失败或无法启动线程时返回 NULL
+MetricsExporter* metrics_start(const char* path, const DictWord* dictionary, int dictionary_size,
+                               long long base_balance, const char* user);
+
+// 记录一次匹配（由生成线程调用，不阻塞）
+void metrics_record_match(MetricsExporter* m, int word_index);
+
+// 记录一个生成循环：letters 为累计字母数，start_ns / end_ns 为循环的开始与结束时间（trace_now，不阻塞）
+void metrics_record_loop(MetricsExporter* m, long long letters, long long start_ns, long long end_ns);
+
+// 停止导出线程，写出最终指标并释放（返回最后一次写出的结果，失败返回 -1）
+int metrics_finish(MetricsExporter* m);
+
+#endif // GACHA_METRICS_H
@@ -7,6 +7,8 @@
     #include <windows.h>
 #endif
 
+#include "alloc.h"
+
 // 初始化输出
 OutputState* output_init() {
     OutputState* os = (OutputState*)malloc(sizeof(OutputState));
@@ -22,30 +24,14 @@ OutputState* output_init() {
     return os;
 }
 
-// 输出字母
-void output_letter(OutputState* os, char letter) {
+// 整块写入已格式化的输出并刷新
+void output_write(OutputState* os, const char* data, size_t length) {
     (void)os;  // 未使用的参数
-    putchar(letter);
-    fflush(stdout);
-}
-
-// 输出匹配的单词（加粗）
-void output_matched_word(OutputState* os, const char* word) {
-    if (word == NULL) {
+    if (data == NULL || length == 0) {
         return;
     }
 
-    if (os && os->bold_enabled) {
-        printf("%s%s%s", ANSI_BOLD, word, ANSI_RESET);
-    } else {
-        printf("%s", word);
-    }
-    fflush(stdout);
-}
-
-// 输出换行
-void output_newline() {
-    putchar('\n');
+    fwrite(data, 1, length, stdout);
     fflush(stdout);
 }
 
@@ -1,6 +1,8 @@
 #ifndef GACHA_OUTPUT_H
 #define GACHA_OUTPUT_H
 
+#include <stddef.h>
+
 // 输出状态
 typedef struct {
     int bold_enabled;        // 是否启用加粗
@@ -15,14 +17,8 @@ typedef struct {
 // 初始化输出
 OutputState* output_init();
 
-// 输出字母
-void output_letter(OutputState* os, char letter);
-
-// 输出匹配的单词（加粗）
-void output_matched_word(OutputState* os, const char* word);
-
-// 输出换行
-void output_newline();
+// 整块写入已格式化的输出并刷新（渲染线程每帧调用一次）
+void output_write(OutputState* os, const char* data, size_t length);
 
 // 输出最终统计
 void output_final_count(int count);
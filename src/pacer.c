@@ -0,0 +1,116 @@
+#include "pacer.h"
+#include <stdlib.h>
+#include <time.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <errno.h>
+#endif
+
+#include "alloc.h"
+
+#define NS_PER_SECOND 1000000000LL
+
+// 读取单调时钟（纳秒）
+static long long monotonic_ns() {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (long long)(counter.QuadPart / frequency.QuadPart) * NS_PER_SECOND +
+           (long long)(counter.QuadPart % frequency.QuadPart) * NS_PER_SECOND / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * NS_PER_SECOND + ts.tv_nsec;
+#endif
+}
+
+// 睡眠到绝对时间 deadline_ns（单调时钟）
+static void sleep_until(long long deadline_ns) {
+#if defined(_WIN32)
+    long long remaining = deadline_ns - monotonic_ns();
+    if (remaining > 0) {
+        Sleep((DWORD)((remaining + 999999) / 1000000));
+    }
+#elif defined(TIMER_ABSTIME) && !defined(__APPLE__)
+    struct timespec ts;
+    ts.tv_sec = (time_t)(deadline_ns / NS_PER_SECOND);
+    ts.tv_nsec = (long)(deadline_ns % NS_PER_SECOND);
+    // 被信号打断时返回，由调用方检查运行标志
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+#else
+    // 没有绝对睡眠时每次按剩余时间计算，误差不会累积
+    long long remaining = deadline_ns - monotonic_ns();
+    if (remaining > 0) {
+        struct timespec ts;
+        ts.tv_sec = (time_t)(remaining / NS_PER_SECOND);
+        ts.tv_nsec = (long)(remaining % NS_PER_SECOND);
+        nanosleep(&ts, NULL);
+    }
+#endif
+}
+
+// 第 count 个字母的截止时间（相对起始时间）
+static long long letter_offset_ns(long long count, int rate) {
+    // 拆成整秒与余数，避免长时间运行时 count * 1e9 溢出
+    return (count / rate) * NS_PER_SECOND + (count % rate) * NS_PER_SECOND / rate;
+}
+
+// 初始化节拍器
+Pacer* pacer_init(int letters_per_second) {
+    if (letters_per_second <= 0) {
+        return NULL;
+    }
+
+    Pacer* pacer = (Pacer*)malloc(sizeof(Pacer));
+    if (pacer == NULL) {
+        return NULL;
+    }
+
+    pacer->rate = letters_per_second;
+    pacer->emitted = 0;
+
+    // 每个节拍至少间隔 PACER_TICK_NS
+    long long batch = ((long long)letters_per_second * PACER_TICK_NS + NS_PER_SECOND - 1) / NS_PER_SECOND;
+    pacer->batch = batch > 1 ? (int)batch : 1;
+
+    pacer->start_ns = monotonic_ns();
+
+    return pacer;
+}
+
+// 等待下一个节拍，返回本节拍应生成的字母数
+int pacer_wait(Pacer* pacer) {
+    if (pacer == NULL) {
+        return 0;
+    }
+
+    // 本节拍的最后一个字母到期时放行
+    long long deadline = pacer->start_ns + letter_offset_ns(pacer->emitted + pacer->batch, pacer->rate);
+    long long now = monotonic_ns();
+
+    if (now - deadline > PACER_MAX_LAG_NS) {
+        // 落后太多：以当前时间重新计时，不做突发追赶
+        pacer->start_ns = now - letter_offset_ns(pacer->emitted, pacer->rate);
+        deadline = pacer->start_ns + letter_offset_ns(pacer->emitted + pacer->batch, pacer->rate);
+    }
+
+    if (deadline > now) {
+        sleep_until(deadline);
+    }
+
+    pacer->emitted += pacer->batch;
+    return pacer->batch;
+}
+
+// 释放节拍器
+void pacer_free(Pacer* pacer) {
+    if (pacer != NULL) {
+        free(pacer);
+    }
+}
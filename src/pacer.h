@@ -0,0 +1,29 @@
+#ifndef GACHA_PACER_H
+#define GACHA_PACER_H
+
+// 节拍器：按绝对截止时间控制字母生成速度
+//   第 n 个字母的截止时间为 start + n / rate，与每轮循环耗时无关，长时间运行不会漂移；
+//   速度超过计时精度时每个节拍放行一批字母
+typedef struct {
+    long long start_ns;      // 起始时间（单调时钟，纳秒）
+    long long emitted;       // 已放行字母数
+    int rate;                // 每秒字母数
+    int batch;               // 每个节拍放行的字母数
+} Pacer;
+
+// 默认配置
+#define PACER_TICK_NS 1000000LL          // 最短节拍（1 毫秒）
+#define PACER_MAX_LAG_NS 1000000000LL    // 落后超过 1 秒时放弃追赶（例如进程被挂起）
+
+// 核心函数
+
+// 初始化节拍器
+Pacer* pacer_init(int letters_per_second);
+
+// 等待下一个节拍，返回本节拍应生成的字母数
+int pacer_wait(Pacer* pacer);
+
+// 释放节拍器
+void pacer_free(Pacer* pacer);
+
+#endif // GACHA_PACER_H
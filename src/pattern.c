@@ -0,0 +1,855 @@
+#include "pattern.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+
+#define ALL_LETTERS ((UINT64_C(1) << PATTERN_ALPHABET) - 1)
+#define LOWER_LETTERS ((UINT64_C(1) << 26) - 1)
+
+// 子集构造中的 NFA 位置（模式已匹配若干字母后的状态）
+//   target >= 0 为下一个位置编号，< 0 为 -(模式序号 + 1)（模式匹配完成）
+typedef struct {
+    uint64_t mask;             // 可接受的字母集合
+    int target;                // 接受字母后的去向
+} PatternItem;
+
+// DFA 构造状态
+typedef struct {
+    int* next;                 // 转移表
+    int* accept;               // 接受的模式序号（-1 表示不接受）
+    int* set_start;            // 状态对应的位置集合在 pool 中的起点
+    int* set_len;              // 位置集合大小（接受状态为 -1）
+    int state_count;           // 状态数量
+    int state_capacity;        // 状态数组容量
+    int alphabet;              // 字母表大小（转移表每行的列数）
+
+    int* pool;                 // 位置集合存储
+    size_t pool_len;           // 已用长度
+    size_t pool_capacity;      // 容量
+
+    int* table;                // 位置集合 -> 状态 的哈希表（-1 为空槽）
+    unsigned int table_mask;   // 哈希表大小 - 1
+} DfaBuilder;
+
+// 字符对应的符号（非字母返回 -1）
+static int letter_symbol(unsigned char c) {
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a';
+    }
+    if (c >= 'A' && c <= 'Z') {
+        return 26 + (c - 'A');
+    }
+    return -1;
+}
+
+// 单个字符的字母集合
+static uint64_t letter_mask(int c) {
+    int symbol = letter_symbol((unsigned char)c);
+    return symbol >= 0 ? UINT64_C(1) << symbol : 0;
+}
+
+// 忽略大小写：大小写字母互相补全
+static uint64_t fold_case(uint64_t mask) {
+    uint64_t both = (mask | (mask >> 26)) & LOWER_LETTERS;
+    return both | (both << 26);
+}
+
+// 字符集合 [...] 的结束位置（']' 的下标），未闭合返回 -1
+static int class_end(const char* text, int start, int length) {
+    int k = start + 1;
+    if (k < length && (text[k] == '!' || text[k] == '^')) {
+        k++;
+    }
+    // 开头的 ] 是普通字符
+    if (k < length && text[k] == ']') {
+        k++;
+    }
+    while (k < length && text[k] != ']') {
+        if (text[k] == '\\' && k + 1 < length) {
+            k++;
+        }
+        k++;
+    }
+    return k < length ? k : -1;
+}
+
+// 解析字符集合（text[start] 为 '['，text[end] 为 ']'），支持范围 a-z、取反 [!...] / [^...]
+static uint64_t parse_class(const char* text, int start, int end) {
+    int k = start + 1;
+    int negate = 0;
+    if (text[k] == '!' || text[k] == '^') {
+        negate = 1;
+        k++;
+    }
+
+    uint64_t mask = 0;
+    while (k < end) {
+        unsigned char lo = (unsigned char)text[k];
+        if (lo == '\\' && k + 1 < end) {
+            lo = (unsigned char)text[++k];
+        }
+        k++;
+
+        // 范围（末尾的 - 是普通字符）
+        unsigned char hi = lo;
+        if (k + 1 < end && text[k] == '-') {
+            k++;
+            hi = (unsigned char)text[k];
+            if (hi == '\\' && k + 1 < end) {
+                hi = (unsigned char)text[++k];
+            }
+            k++;
+        }
+
+        for (int c = lo; c <= hi; c++) {
+            mask |= letter_mask(c);
+        }
+    }
+
+    return negate ? ALL_LETTERS & ~mask : mask;
+}
+
+// 解析模式为逐位置的字母集合，返回位置数；有位置不可能匹配时 *impossible 置 1
+static int parse_pattern(const char* text, int length, int ignore_case,
+                         uint64_t* masks, int* impossible) {
+    int count = 0;
+    *impossible = 0;
+
+    for (int k = 0; k < length;) {
+        uint64_t mask;
+        int end;
+        if (text[k] == '?') {
+            mask = ALL_LETTERS;
+            k++;
+        } else if (text[k] == '[' && (end = class_end(text, k, length)) > 0) {
+            mask = parse_class(text, k, end);
+            k = end + 1;
+        } else {
+            // 普通字符（\ 转义下一个字符，未闭合的 [ 按普通字符处理）
+            if (text[k] == '\\' && k + 1 < length) {
+                k++;
+            }
+            mask = letter_mask((unsigned char)text[k]);
+            k++;
+        }
+
+        if (ignore_case) {
+            mask = fold_case(mask);
+        }
+        if (mask == 0) {
+            *impossible = 1;
+        }
+        masks[count++] = mask;
+    }
+
+    return count;
+}
+
+// 位置集合哈希
+static unsigned int set_hash(const int* set, int length) {
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash ^= (unsigned int)set[i];
+        hash *= 16777619u;
+    }
+    return hash ^ (unsigned int)length;
+}
+
+static int compare_int(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// 哈希表扩容
+static int builder_rehash(DfaBuilder* b, unsigned int size) {
+    int* table = (int*)malloc(size * sizeof(int));
+    if (table == NULL) {
+        return -1;
+    }
+    for (unsigned int i = 0; i < size; i++) {
+        table[i] = -1;
+    }
+
+    for (int s = 0; s < b->state_count; s++) {
+        if (b->set_len[s] < 0) {
+            continue;
+        }
+        unsigned int slot = set_hash(b->pool + b->set_start[s], b->set_len[s]) & (size - 1);
+        while (table[slot] >= 0) {
+            slot = (slot + 1) & (size - 1);
+        }
+        table[slot] = s;
+    }
+
+    free(b->table);
+    b->table = table;
+    b->table_mask = size - 1;
+    return 0;
+}
+
+// 扩大 int 数组
+static int grow_ints(int** array, int capacity) {
+    int* grown = (int*)realloc(*array, (size_t)capacity * sizeof(int));
+    if (grown == NULL) {
+        return -1;
+    }
+    *array = grown;
+    return 0;
+}
+
+// 新增状态（set_len 为 -1 表示接受状态），返回状态编号，失败返回 -1
+static int builder_add_state(DfaBuilder* b, const int* set, int set_len, int accept) {
+    if (b->state_count >= PATTERN_MAX_STATES) {
+        return -1;
+    }
+
+    if (b->state_count == b->state_capacity) {
+        int capacity = b->state_capacity * 2;
+        int* next = (int*)realloc(b->next, (size_t)capacity * b->alphabet * sizeof(int));
+        if (next == NULL) {
+            return -1;
+        }
+        b->next = next;
+        if (grow_ints(&b->accept, capacity) != 0 || grow_ints(&b->set_start, capacity) != 0 ||
+            grow_ints(&b->set_len, capacity) != 0) {
+            return -1;
+        }
+        b->state_capacity = capacity;
+    }
+
+    if (set_len > 0 && b->pool_len + (size_t)set_len > b->pool_capacity) {
+        size_t capacity = b->pool_capacity;
+        while (b->pool_len + (size_t)set_len > capacity) {
+            capacity *= 2;
+        }
+        int* pool = (int*)realloc(b->pool, capacity * sizeof(int));
+        if (pool == NULL) {
+            return -1;
+        }
+        b->pool = pool;
+        b->pool_capacity = capacity;
+    }
+
+    int state = b->state_count++;
+    b->accept[state] = accept;
+    b->set_start[state] = (int)b->pool_len;
+    b->set_len[state] = set_len;
+    if (set_len > 0) {
+        memcpy(b->pool + b->pool_len, set, (size_t)set_len * sizeof(int));
+        b->pool_len += (size_t)set_len;
+    }
+
+    // 负载因子不超过 1/2
+    if (set_len >= 0) {
+        if ((unsigned int)b->state_count * 2 > b->table_mask + 1) {
+            if (builder_rehash(b, (b->table_mask + 1) * 2) != 0) {
+                return -1;
+            }
+        } else {
+            unsigned int slot = set_hash(set, set_len) & b->table_mask;
+            while (b->table[slot] >= 0) {
+                slot = (slot + 1) & b->table_mask;
+            }
+            b->table[slot] = state;
+        }
+    }
+
+    return state;
+}
+
+// 查找位置集合对应的状态，不存在时新增
+static int builder_find_state(DfaBuilder* b, const int* set, int set_len) {
+    unsigned int slot = set_hash(set, set_len) & b->table_mask;
+    while (b->table[slot] >= 0) {
+        int state = b->table[slot];
+        if (b->set_len[state] == set_len &&
+            memcmp(b->pool + b->set_start[state], set, (size_t)set_len * sizeof(int)) == 0) {
+            return state;
+        }
+        slot = (slot + 1) & b->table_mask;
+    }
+    return builder_add_state(b, set, set_len, -1);
+}
+
+// 释放构造状态
+static void builder_free(DfaBuilder* b) {
+    free(b->next);
+    free(b->accept);
+    free(b->set_start);
+    free(b->set_len);
+    free(b->pool);
+    free(b->table);
+}
+
+// 两个状态在当前划分下是否等价（所在块相同且每个字母都转移到相同的块）
+static int same_signature(const int* next, int alphabet, const int* block, int s, int r) {
+    if (block[s] != block[r]) {
+        return 0;
+    }
+    const int* row_s = next + (size_t)s * alphabet;
+    const int* row_r = next + (size_t)r * alphabet;
+    for (int c = 0; c < alphabet; c++) {
+        if (block[row_s[c]] != block[row_r[c]]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Moore 划分细化最小化：初始按接受的模式划分，反复按转移签名拆分直到稳定
+static int minimize(const DfaBuilder* b, int pattern_count, PatternDfa* dfa) {
+    int n = b->state_count;
+    int alphabet = b->alphabet;
+    unsigned int size = 16;
+    while (size < (unsigned int)n * 2) {
+        size *= 2;
+    }
+
+    int* block = (int*)malloc((size_t)n * sizeof(int));
+    int* next_block = (int*)malloc((size_t)n * sizeof(int));
+    int* rep = (int*)malloc((size_t)n * sizeof(int));
+    int* table = (int*)malloc(size * sizeof(int));
+    unsigned char* used = (unsigned char*)calloc((size_t)pattern_count + 1, 1);
+    if (block == NULL || next_block == NULL || rep == NULL || table == NULL || used == NULL) {
+        free(block);
+        free(next_block);
+        free(rep);
+        free(table);
+        free(used);
+        return -1;
+    }
+
+    int prev_count = 0;
+    for (int s = 0; s < n; s++) {
+        block[s] = b->accept[s] + 1;
+        if (!used[block[s]]) {
+            used[block[s]] = 1;
+            prev_count++;
+        }
+    }
+    free(used);
+
+    int block_count;
+    for (;;) {
+        for (unsigned int i = 0; i < size; i++) {
+            table[i] = -1;
+        }
+
+        block_count = 0;
+        for (int s = 0; s < n; s++) {
+            const int* row = b->next + (size_t)s * alphabet;
+            unsigned int hash = (unsigned int)block[s] * 2654435761u;
+            for (int c = 0; c < alphabet; c++) {
+                hash = (hash ^ (unsigned int)block[row[c]]) * 16777619u;
+            }
+
+            unsigned int slot = hash & (size - 1);
+            for (;;) {
+                int r = table[slot];
+                if (r < 0) {
+                    table[slot] = s;
+                    next_block[s] = block_count;
+                    rep[block_count++] = s;
+                    break;
+                }
+                if (same_signature(b->next, alphabet, block, s, r)) {
+                    next_block[s] = next_block[r];
+                    break;
+                }
+                slot = (slot + 1) & (size - 1);
+            }
+        }
+
+        int* swap = block;
+        block = next_block;
+        next_block = swap;
+
+        // 细化只会拆分块，块数不变即已稳定
+        if (block_count == prev_count) {
+            break;
+        }
+        prev_count = block_count;
+    }
+
+    // 按块生成最小化 DFA（状态 0 最先编号，仍是初始状态）
+    dfa->state_count = block_count;
+    dfa->alphabet_size = alphabet;
+    dfa->next = (int*)malloc((size_t)block_count * alphabet * sizeof(int));
+    dfa->accept = (int*)malloc((size_t)block_count * sizeof(int));
+    if (dfa->next != NULL && dfa->accept != NULL) {
+        for (int k = 0; k < block_count; k++) {
+            const int* row = b->next + (size_t)rep[k] * alphabet;
+            for (int c = 0; c < alphabet; c++) {
+                dfa->next[(size_t)k * alphabet + c] = block[row[c]];
+            }
+            dfa->accept[k] = b->accept[rep[k]];
+        }
+    }
+
+    free(block);
+    free(next_block);
+    free(rep);
+    free(table);
+    return dfa->next != NULL && dfa->accept != NULL ? 0 : -1;
+}
+
+// 检查单词是否包含模式语法
+int pattern_has_syntax(const char* text, int length) {
+    for (int k = 0; k < length; k++) {
+        if (text[k] == '?' || text[k] == '[' || text[k] == '\\') {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 模式匹配的字母数
+int pattern_length(const char* text, int length) {
+    int count = 0;
+    for (int k = 0; k < length; count++) {
+        int end;
+        if (text[k] == '[' && (end = class_end(text, k, length)) > 0) {
+            k = end + 1;
+        } else {
+            if (text[k] == '\\' && k + 1 < length) {
+                k++;
+            }
+            k++;
+        }
+    }
+    return count;
+}
+
+// 检查字典中是否有单词包含模式语法
+int pattern_any_syntax(const DictWord* words, int count) {
+    for (int i = 0; i < count; i++) {
+        if (pattern_has_syntax(words[i].text, words[i].length)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 编译模式为最小化 DFA
+PatternDfa* pattern_compile(const DictWord* patterns, int count, int ignore_case, int max_length) {
+    if (patterns == NULL || count <= 0) {
+        return NULL;
+    }
+
+    // 1. 统计规模（位置数不超过模式字节数）
+    size_t total_bytes = 0;
+    int longest = 0;
+    for (int i = 0; i < count; i++) {
+        total_bytes += (size_t)patterns[i].length;
+        if (patterns[i].length > longest) {
+            longest = patterns[i].length;
+        }
+    }
+    if (total_bytes > PATTERN_MAX_POSITIONS) {
+        return NULL;
+    }
+
+    PatternDfa* dfa = (PatternDfa*)malloc(sizeof(PatternDfa));
+    if (dfa == NULL) {
+        return NULL;
+    }
+    memset(dfa, 0, sizeof(PatternDfa));
+    dfa->pattern_count = count;
+    for (int c = 0; c < 256; c++) {
+        int symbol = letter_symbol((unsigned char)c);
+        dfa->symbol_of[c] = symbol >= 0 ? (unsigned char)symbol : PATTERN_NO_SYMBOL;
+    }
+
+    DfaBuilder b;
+    memset(&b, 0, sizeof(DfaBuilder));
+
+    dfa->lengths = (int*)calloc((size_t)count, sizeof(int));
+    uint64_t* masks = (uint64_t*)malloc(((size_t)longest + 1) * sizeof(uint64_t));
+    PatternItem* positions = (PatternItem*)malloc((total_bytes + 1) * sizeof(PatternItem));
+    PatternItem* starts = (PatternItem*)malloc((size_t)count * sizeof(PatternItem));
+    int* start_offset = (int*)calloc(PATTERN_ALPHABET + 1, sizeof(int));
+    int* start_targets = (int*)malloc(((size_t)count * PATTERN_ALPHABET + 1) * sizeof(int));
+    int* scratch = (int*)malloc((total_bytes + 1) * sizeof(int));
+    b.state_capacity = 64;
+    b.alphabet = PATTERN_ALPHABET;
+    b.next = (int*)malloc((size_t)b.state_capacity * PATTERN_ALPHABET * sizeof(int));
+    b.accept = (int*)malloc((size_t)b.state_capacity * sizeof(int));
+    b.set_start = (int*)malloc((size_t)b.state_capacity * sizeof(int));
+    b.set_len = (int*)malloc((size_t)b.state_capacity * sizeof(int));
+    b.pool_capacity = 256;
+    b.pool = (int*)malloc(b.pool_capacity * sizeof(int));
+
+    int* accept_state = (int*)malloc((size_t)count * sizeof(int));
+    int ok = dfa->lengths != NULL && masks != NULL && positions != NULL && starts != NULL &&
+             start_offset != NULL && start_targets != NULL && scratch != NULL &&
+             b.next != NULL && b.accept != NULL && b.set_start != NULL && b.set_len != NULL &&
+             b.pool != NULL && accept_state != NULL && builder_rehash(&b, 64) == 0;
+
+    // 2. 解析模式：每个模式的第一个字母集合作为起点，其余为 NFA 位置
+    int start_count = 0;
+    int position_count = 0;
+    for (int i = 0; ok && i < count; i++) {
+        accept_state[i] = -1;
+
+        int impossible;
+        int length = parse_pattern(patterns[i].text, patterns[i].length, ignore_case,
+                                   masks, &impossible);
+        if (length == 0 || impossible || length > max_length) {
+            continue;
+        }
+        dfa->lengths[i] = length;
+
+        int base = position_count;
+        starts[start_count].mask = masks[0];
+        starts[start_count].target = length == 1 ? -(i + 1) : base;
+        start_count++;
+        for (int j = 1; j < length; j++) {
+            positions[position_count].mask = masks[j];
+            positions[position_count].target = j + 1 == length ? -(i + 1) : base + j;
+            position_count++;
+        }
+    }
+
+    // 各字母的起点列表
+    for (int k = 0; ok && k < start_count; k++) {
+        for (int c = 0; c < PATTERN_ALPHABET; c++) {
+            if ((starts[k].mask >> c) & 1) {
+                start_offset[c + 1]++;
+            }
+        }
+    }
+    for (int c = 0; ok && c < PATTERN_ALPHABET; c++) {
+        start_offset[c + 1] += start_offset[c];
+    }
+    for (int c = 0; ok && c < PATTERN_ALPHABET; c++) {
+        int fill = start_offset[c];
+        for (int k = 0; k < start_count; k++) {
+            if ((starts[k].mask >> c) & 1) {
+                start_targets[fill++] = starts[k].target;
+            }
+        }
+    }
+
+    // 3. 子集构造：状态 = 正在进行中的位置集合（初始状态为空集）
+    ok = ok && builder_add_state(&b, NULL, 0, -1) == 0;
+    for (int q = 0; ok && q < b.state_count; q++) {
+        if (b.set_len[q] < 0) {
+            continue; // 接受状态的转移最后从初始状态复制
+        }
+
+        for (int c = 0; ok && c < PATTERN_ALPHABET; c++) {
+            int winner = INT_MAX;
+            int n = 0;
+
+            for (int k = start_offset[c]; k < start_offset[c + 1]; k++) {
+                int target = start_targets[k];
+                if (target < 0) {
+                    if (-target - 1 < winner) {
+                        winner = -target - 1;
+                    }
+                } else {
+                    scratch[n++] = target;
+                }
+            }
+
+            const int* set = b.pool + b.set_start[q];
+            for (int k = 0; k < b.set_len[q]; k++) {
+                const PatternItem* item = &positions[set[k]];
+                if ((item->mask >> c) & 1) {
+                    if (item->target < 0) {
+                        if (-item->target - 1 < winner) {
+                            winner = -item->target - 1;
+                        }
+                    } else {
+                        scratch[n++] = item->target;
+                    }
+                }
+            }
+
+            // 有模式匹配完成时序号最小者胜出，随后从头开始
+            int state;
+            if (winner != INT_MAX) {
+                if (accept_state[winner] < 0) {
+                    accept_state[winner] = builder_add_state(&b, NULL, -1, winner);
+                }
+                state = accept_state[winner];
+            } else {
+                qsort(scratch, (size_t)n, sizeof(int), compare_int);
+                state = builder_find_state(&b, scratch, n);
+            }
+
+            if (state < 0) {
+                ok = 0;
+                break;
+            }
+            b.next[(size_t)q * PATTERN_ALPHABET + c] = state;
+        }
+    }
+
+    // 接受状态的转移与初始状态相同
+    for (int q = 0; ok && q < b.state_count; q++) {
+        if (b.set_len[q] < 0) {
+            memcpy(b.next + (size_t)q * PATTERN_ALPHABET, b.next, PATTERN_ALPHABET * sizeof(int));
+        }
+    }
+
+    // 4. 最小化
+    ok = ok && minimize(&b, count, dfa) == 0;
+
+    builder_free(&b);
+    free(masks);
+    free(positions);
+    free(starts);
+    free(start_offset);
+    free(start_targets);
+    free(scratch);
+    free(accept_state);
+
+    if (!ok) {
+        pattern_dfa_free(dfa);
+        return NULL;
+    }
+    return dfa;
+}
+
+// 编译编号序列模式为最小化 DFA（Aho-Corasick 字典树展开为稠密转移表）
+PatternDfa* pattern_compile_symbols(const uint16_t* symbols, const int* offsets, int count,
+                                    int alphabet_size, int max_length) {
+    if (symbols == NULL || offsets == NULL || count <= 0 ||
+        alphabet_size <= 0 || alphabet_size > PATTERN_MAX_SYMBOLS) {
+        return NULL;
+    }
+
+    size_t total = (size_t)offsets[count];
+    if (total > PATTERN_MAX_POSITIONS) {
+        return NULL;
+    }
+
+    PatternDfa* dfa = (PatternDfa*)malloc(sizeof(PatternDfa));
+    if (dfa == NULL) {
+        return NULL;
+    }
+    memset(dfa, 0, sizeof(PatternDfa));
+    dfa->pattern_count = count;
+    memset(dfa->symbol_of, PATTERN_NO_SYMBOL, sizeof(dfa->symbol_of));
+
+    // 字典树节点数不超过模式总长 + 1
+    size_t max_nodes = total + 1;
+    unsigned int size = 16;
+    while (size < max_nodes * 2) {
+        size *= 2;
+    }
+
+    dfa->lengths = (int*)calloc((size_t)count, sizeof(int));
+    int* edge_node = (int*)malloc(size * sizeof(int));       // 边表：子节点（-1 为空槽）
+    int* parent = (int*)malloc(max_nodes * sizeof(int));
+    int* via = (int*)malloc(max_nodes * sizeof(int));        // 到达该节点的字母
+    int* term = (int*)malloc(max_nodes * sizeof(int));       // 恰好在该节点结束的最小模式序号
+    int* out = (int*)malloc(max_nodes * sizeof(int));        // 后缀链上结束的最小模式序号
+    int* fail = (int*)malloc(max_nodes * sizeof(int));
+    int* order = (int*)malloc(max_nodes * sizeof(int));      // 广度优先顺序
+    int* first_child = (int*)malloc(max_nodes * sizeof(int));
+    int* sibling = (int*)malloc(max_nodes * sizeof(int));
+    int* remap = (int*)malloc(max_nodes * sizeof(int));
+    int* accept_of = (int*)malloc((size_t)count * sizeof(int));
+    int ok = dfa->lengths != NULL && edge_node != NULL && parent != NULL && via != NULL &&
+             term != NULL && out != NULL && fail != NULL && order != NULL &&
+             first_child != NULL && sibling != NULL && remap != NULL && accept_of != NULL;
+
+    DfaBuilder b;
+    memset(&b, 0, sizeof(DfaBuilder));
+    b.alphabet = alphabet_size;
+
+    // 1. 构造字典树（边用 (父节点, 字母) 哈希表存储）
+    int node_count = 1;
+    if (ok) {
+        for (unsigned int i = 0; i < size; i++) {
+            edge_node[i] = -1;
+        }
+        parent[0] = -1;
+        via[0] = -1;
+        term[0] = INT_MAX;
+        first_child[0] = -1;
+        sibling[0] = -1;
+    }
+    for (int i = 0; ok && i < count; i++) {
+        accept_of[i] = -1;
+        int length = offsets[i + 1] - offsets[i];
+        if (length == 0 || length > max_length) {
+            continue;
+        }
+        dfa->lengths[i] = length;
+
+        int node = 0;
+        for (int j = 0; j < length; j++) {
+            int c = symbols[offsets[i] + j];
+            unsigned int slot = ((unsigned int)node * 2654435761u ^ (unsigned int)c * 40503u) & (size - 1);
+            int child = -1;
+            while (edge_node[slot] >= 0) {
+                int candidate = edge_node[slot];
+                if (parent[candidate] == node && via[candidate] == c) {
+                    child = candidate;
+                    break;
+                }
+                slot = (slot + 1) & (size - 1);
+            }
+            if (child < 0) {
+                child = node_count++;
+                edge_node[slot] = child;
+                parent[child] = node;
+                via[child] = c;
+                term[child] = INT_MAX;
+                first_child[child] = -1;
+                sibling[child] = first_child[node];
+                first_child[node] = child;
+            }
+            node = child;
+        }
+        if (i < term[node]) {
+            term[node] = i;
+        }
+    }
+
+    // 2. 广度优先排列节点（失败节点总比自身浅，按此顺序可逐行展开）
+    if (ok) {
+        int head = 0;
+        int tail = 0;
+        order[tail++] = 0;
+        fail[0] = 0;
+        out[0] = INT_MAX;
+        while (head < tail) {
+            int node = order[head++];
+            for (int child = first_child[node]; child >= 0; child = sibling[child]) {
+                order[tail++] = child;
+            }
+        }
+    }
+
+    // 3. 展开为稠密转移表：节点的行 = 失败节点的行 + 自身的子边，
+    //    同时求出输出（后缀链上结束的序号最小的模式）
+    size_t cells = 0;
+    ok = ok && node_count + count <= PATTERN_MAX_STATES;
+    if (ok) {
+        cells = (size_t)(node_count + count) * (size_t)alphabet_size;
+        ok = cells <= PATTERN_MAX_CELLS;
+    }
+    if (ok) {
+        b.state_capacity = node_count + count;
+        b.next = (int*)malloc(cells * sizeof(int));
+        b.accept = (int*)malloc((size_t)b.state_capacity * sizeof(int));
+        ok = b.next != NULL && b.accept != NULL;
+    }
+    for (int k = 0; ok && k < node_count; k++) {
+        int node = order[k];
+        int* row = b.next + (size_t)node * alphabet_size;
+        if (node == 0) {
+            memset(row, 0, (size_t)alphabet_size * sizeof(int));
+        } else {
+            int f = parent[node] == 0 ? 0 : b.next[(size_t)fail[parent[node]] * alphabet_size + via[node]];
+            fail[node] = f;
+            out[node] = term[node] < out[f] ? term[node] : out[f];
+            memcpy(row, b.next + (size_t)f * alphabet_size, (size_t)alphabet_size * sizeof(int));
+        }
+        for (int child = first_child[node]; child >= 0; child = sibling[child]) {
+            row[via[child]] = child;
+        }
+    }
+
+    // 4. 到达有输出节点的转移改为到达对应模式的接受状态（匹配后从头开始），
+    //    有输出的节点与只能经由它们到达的节点因此不可达；
+    //    从初始状态出发标记可达节点（-2）与用到的接受状态，再按原顺序重新编号
+    int accept_count = 0;
+    if (ok) {
+        for (int node = 0; node < node_count; node++) {
+            remap[node] = -1;
+        }
+        int head = 0;
+        int tail = 0;
+        remap[0] = -2;
+        order[tail++] = 0;
+        while (head < tail) {
+            const int* row = b.next + (size_t)order[head++] * alphabet_size;
+            for (int c = 0; c < alphabet_size; c++) {
+                int target = row[c];
+                if (out[target] != INT_MAX) {
+                    accept_of[out[target]] = -2;
+                } else if (remap[target] == -1) {
+                    remap[target] = -2;
+                    order[tail++] = target;
+                }
+            }
+        }
+
+        int kept = 0;
+        for (int node = 0; node < node_count; node++) {
+            if (remap[node] == -2) {
+                remap[node] = kept++;
+            }
+        }
+        for (int i = 0; i < count; i++) {
+            if (accept_of[i] == -2) {
+                accept_of[i] = kept + accept_count++;
+            }
+        }
+
+        for (int node = 0; node < node_count; node++) {
+            if (remap[node] < 0) {
+                continue;
+            }
+            const int* row = b.next + (size_t)node * alphabet_size;
+            int* dest = b.next + (size_t)remap[node] * alphabet_size;
+            for (int c = 0; c < alphabet_size; c++) {
+                int target = row[c];
+                dest[c] = out[target] == INT_MAX ? remap[target] : accept_of[out[target]];
+            }
+            b.accept[remap[node]] = -1;
+        }
+
+        // 接受状态的转移与初始状态相同
+        for (int i = 0; i < count; i++) {
+            if (accept_of[i] >= 0) {
+                memcpy(b.next + (size_t)accept_of[i] * alphabet_size, b.next,
+                       (size_t)alphabet_size * sizeof(int));
+                b.accept[accept_of[i]] = i;
+            }
+        }
+        b.state_count = kept + accept_count;
+    }
+
+    // 5. 最小化
+    ok = ok && minimize(&b, count, dfa) == 0;
+
+    builder_free(&b);
+    free(edge_node);
+    free(parent);
+    free(via);
+    free(term);
+    free(out);
+    free(fail);
+    free(order);
+    free(first_child);
+    free(sibling);
+    free(remap);
+    free(accept_of);
+
+    if (!ok) {
+        pattern_dfa_free(dfa);
+        return NULL;
+    }
+    return dfa;
+}
+
+// 释放 DFA
+void pattern_dfa_free(PatternDfa* dfa) {
+    if (dfa == NULL) {
+        return;
+    }
+
+    free(dfa->next);
+    free(dfa->accept);
+    free(dfa->lengths);
+    free(dfa);
+}
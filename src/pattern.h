@@ -0,0 +1,54 @@
+#ifndef GACHA_PATTERN_H
+#define GACHA_PATTERN_H
+
+#include <stdint.h>
+#include "dictionary.h"
+
+// 模式字母表（与随机字母表一致：a-z 为 0-25，A-Z 为 26-51）
+#define PATTERN_ALPHABET 52
+#define PATTERN_NO_SYMBOL 0xFF     // 非字母
+
+// 编译上限（稠密转移表为 状态数 × 字母表大小 个 int）
+#define PATTERN_MAX_STATES (1 << 16)
+#define PATTERN_MAX_POSITIONS (1 << 16)
+#define PATTERN_MAX_CELLS (1 << 25)
+#define PATTERN_MAX_SYMBOLS 65536  // 编号序列模式的字母表上限（uint16_t）
+
+// 模式 DFA（所有模式合并后最小化）
+//   状态 0 为初始状态；到达接受状态即匹配，接受状态的转移与初始状态相同，
+//   因此匹配后自动从头开始，新匹配不会与旧匹配重叠
+typedef struct {
+    int state_count;           // 状态数量
+    int alphabet_size;         // 字母表大小（字母模式为 PATTERN_ALPHABET）
+    int* next;                 // 稠密转移表 [state * alphabet_size + symbol]
+    int* accept;               // 到达该状态时胜出的模式序号（-1 表示不匹配）
+    int* lengths;              // 各模式匹配的字母数（0 表示不可能匹配）
+    int pattern_count;         // 模式数量
+    unsigned char symbol_of[256]; // 字符 -> 符号（PATTERN_NO_SYMBOL 表示非字母）
+} PatternDfa;
+
+// 核心函数
+
+// 检查单词是否包含模式语法（? [...] \）
+int pattern_has_syntax(const char* text, int length);
+
+// 模式匹配的字母数（? 与字符类各算一个字母，不含模式语法的单词即为字节数）
+int pattern_length(const char* text, int length);
+
+// 检查字典中是否有单词包含模式语法
+int pattern_any_syntax(const DictWord* words, int count);
+
+// 编译模式为最小化 DFA（多个模式同时匹配时序号小者优先，长于 max_length 的模式不匹配）
+//   超过 PATTERN_MAX_STATES / PATTERN_MAX_POSITIONS 时返回 NULL
+PatternDfa* pattern_compile(const DictWord* patterns, int count, int ignore_case, int max_length);
+
+// 编译编号序列模式为最小化 DFA（自定义字母表用，逐字匹配，不支持模式语法）
+//   第 i 个模式为 symbols[offsets[i] .. offsets[i + 1])，空模式与长于 max_length 的模式不匹配；
+//   转移表超过 PATTERN_MAX_STATES / PATTERN_MAX_CELLS 时返回 NULL
+PatternDfa* pattern_compile_symbols(const uint16_t* symbols, const int* offsets, int count,
+                                    int alphabet_size, int max_length);
+
+// 释放 DFA
+void pattern_dfa_free(PatternDfa* dfa);
+
+#endif // GACHA_PATTERN_H
@@ -1,14 +1,517 @@
 #include "random.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #ifdef _WIN32
     #include <windows.h>
+    #include <bcrypt.h>
 #else
     #include <unistd.h>
+    #if defined(__linux__) || defined(__APPLE__)
+        #include <sys/random.h>
+    #endif
 #endif
 
+#ifdef __SSE2__
+    #include <emmintrin.h>
+#endif
+
+// GCC / Clang 在 x86 上可按函数启用 AVX2，运行时检测 CPU 后使用 8 路 ChaCha20
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #include <immintrin.h>
+    #define RANDOM_CHACHA_AVX2
+#endif
+
+#include "alloc.h"
+
+static inline uint32_t rotl32(uint32_t x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+#ifdef __SSE2__
+// 32 位循环左移（SSE2 没有向量移位合并指令）
+#define SSE_ROTL32(x, k) _mm_or_si128(_mm_slli_epi32((x), (k)), _mm_srli_epi32((x), 32 - (k)))
+#endif
+
+// splitmix64：由种子派生各路初始状态
+static uint64_t splitmix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// 所有路同时推进一步，输出 RANDOM_LANES 个随机数
+static void lanes_next(RandomGenerator* rg, uint32_t* out) {
+    uint32_t* s0 = rg->lanes[0];
+    uint32_t* s1 = rg->lanes[1];
+    uint32_t* s2 = rg->lanes[2];
+    uint32_t* s3 = rg->lanes[3];
+
+    for (int l = 0; l < RANDOM_LANES; l++) {
+        out[l] = rotl32(s1[l] * 5, 7) * 9;
+
+        uint32_t t = s1[l] << 9;
+        s2[l] ^= s0[l];
+        s3[l] ^= s1[l];
+        s1[l] ^= s2[l];
+        s0[l] ^= s3[l];
+        s2[l] ^= t;
+        s3[l] = rotl32(s3[l], 11);
+    }
+}
+
+// ChaCha20 常量 "expand 32-byte k"
+static const uint32_t CHACHA_CONSTANTS[4] = {0x61707865u, 0x3320646eu, 0x79622d32u, 0x6b206574u};
+
+// 每次填充的 ChaCha20 块数（每块 16 个字）
+#define CHACHA_BLOCKS (RANDOM_POOL_WORDS / 16)
+
+#define CHACHA_QUARTER(a, b, c, d)              \
+    do {                                        \
+        a += b; d ^= a; d = rotl32(d, 16);      \
+        c += d; b ^= c; b = rotl32(b, 12);      \
+        a += b; d ^= a; d = rotl32(d, 8);       \
+        c += d; b ^= c; b = rotl32(b, 7);       \
+    } while (0)
+
+// 生成一个 ChaCha20 块（RFC 8439，nonce 为 0：每次填充都换新密钥）
+static void chacha_block(const uint32_t key[8], uint32_t counter, uint32_t* out) {
+    uint32_t input[16];
+    uint32_t x[16];
+    for (int i = 0; i < 4; i++) {
+        input[i] = CHACHA_CONSTANTS[i];
+    }
+    for (int i = 0; i < 8; i++) {
+        input[4 + i] = key[i];
+    }
+    input[12] = counter;
+    input[13] = 0;
+    input[14] = 0;
+    input[15] = 0;
+
+    for (int i = 0; i < 16; i++) {
+        x[i] = input[i];
+    }
+    for (int round = 0; round < 10; round++) {
+        CHACHA_QUARTER(x[0], x[4], x[8], x[12]);
+        CHACHA_QUARTER(x[1], x[5], x[9], x[13]);
+        CHACHA_QUARTER(x[2], x[6], x[10], x[14]);
+        CHACHA_QUARTER(x[3], x[7], x[11], x[15]);
+        CHACHA_QUARTER(x[0], x[5], x[10], x[15]);
+        CHACHA_QUARTER(x[1], x[6], x[11], x[12]);
+        CHACHA_QUARTER(x[2], x[7], x[8], x[13]);
+        CHACHA_QUARTER(x[3], x[4], x[9], x[14]);
+    }
+    for (int i = 0; i < 16; i++) {
+        out[i] = x[i] + input[i];
+    }
+}
+
+#ifdef __SSE2__
+#define SSE_CHACHA_QUARTER(a, b, c, d)                                                  \
+    do {                                                                                \
+        a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a);                               \
+        d = _mm_shufflehi_epi16(_mm_shufflelo_epi16(d, 0xB1), 0xB1);                    \
+        c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = SSE_ROTL32(b, 12);        \
+        a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = SSE_ROTL32(d, 8);         \
+        c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = SSE_ROTL32(b, 7);         \
+    } while (0)
+
+// 同时生成 4 个连续块：每个向量存放 4 个块的同一个字，结束后转置写回
+static void chacha_blocks4(const uint32_t key[8], uint32_t counter, uint32_t* out) {
+    __m128i input[16];
+    __m128i x[16];
+    for (int i = 0; i < 4; i++) {
+        input[i] = _mm_set1_epi32((int)CHACHA_CONSTANTS[i]);
+    }
+    for (int i = 0; i < 8; i++) {
+        input[4 + i] = _mm_set1_epi32((int)key[i]);
+    }
+    input[12] = _mm_add_epi32(_mm_set1_epi32((int)counter), _mm_set_epi32(3, 2, 1, 0));
+    input[13] = _mm_setzero_si128();
+    input[14] = _mm_setzero_si128();
+    input[15] = _mm_setzero_si128();
+
+    for (int i = 0; i < 16; i++) {
+        x[i] = input[i];
+    }
+    for (int round = 0; round < 10; round++) {
+        SSE_CHACHA_QUARTER(x[0], x[4], x[8], x[12]);
+        SSE_CHACHA_QUARTER(x[1], x[5], x[9], x[13]);
+        SSE_CHACHA_QUARTER(x[2], x[6], x[10], x[14]);
+        SSE_CHACHA_QUARTER(x[3], x[7], x[11], x[15]);
+        SSE_CHACHA_QUARTER(x[0], x[5], x[10], x[15]);
+        SSE_CHACHA_QUARTER(x[1], x[6], x[11], x[12]);
+        SSE_CHACHA_QUARTER(x[2], x[7], x[8], x[13]);
+        SSE_CHACHA_QUARTER(x[3], x[4], x[9], x[14]);
+    }
+
+    // 每 4 个字一组做 4x4 转置：第 b 个块的字 i..i+3 连续写到 out + 16b + i
+    for (int i = 0; i < 16; i += 4) {
+        __m128i a = _mm_add_epi32(x[i], input[i]);
+        __m128i b = _mm_add_epi32(x[i + 1], input[i + 1]);
+        __m128i c = _mm_add_epi32(x[i + 2], input[i + 2]);
+        __m128i d = _mm_add_epi32(x[i + 3], input[i + 3]);
+        __m128i ab_lo = _mm_unpacklo_epi32(a, b);
+        __m128i ab_hi = _mm_unpackhi_epi32(a, b);
+        __m128i cd_lo = _mm_unpacklo_epi32(c, d);
+        __m128i cd_hi = _mm_unpackhi_epi32(c, d);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi64(ab_lo, cd_lo));
+        _mm_storeu_si128((__m128i*)(out + 16 + i), _mm_unpackhi_epi64(ab_lo, cd_lo));
+        _mm_storeu_si128((__m128i*)(out + 32 + i), _mm_unpacklo_epi64(ab_hi, cd_hi));
+        _mm_storeu_si128((__m128i*)(out + 48 + i), _mm_unpackhi_epi64(ab_hi, cd_hi));
+    }
+}
+#endif
+
+#ifdef RANDOM_CHACHA_AVX2
+#define AVX_ROTL32(x, k) _mm256_or_si256(_mm256_slli_epi32((x), (k)), _mm256_srli_epi32((x), 32 - (k)))
+
+#define AVX_CHACHA_QUARTER(a, b, c, d)                                                      \
+    do {                                                                                    \
+        a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = _mm256_shuffle_epi8(d, rot16); \
+        c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = AVX_ROTL32(b, 12);      \
+        a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = _mm256_shuffle_epi8(d, rot8); \
+        c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = AVX_ROTL32(b, 7);       \
+    } while (0)
+
+// 同时生成 8 个连续块（运行时检测到 AVX2 才调用），8x8 转置后按块写回
+__attribute__((target("avx2")))
+static void chacha_blocks8(const uint32_t key[8], uint32_t counter, uint32_t* out) {
+    const __m256i rot16 = _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+                                          13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+    const __m256i rot8 = _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+                                         14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3);
+    __m256i input[16];
+    __m256i x[16];
+    for (int i = 0; i < 4; i++) {
+        input[i] = _mm256_set1_epi32((int)CHACHA_CONSTANTS[i]);
+    }
+    for (int i = 0; i < 8; i++) {
+        input[4 + i] = _mm256_set1_epi32((int)key[i]);
+    }
+    input[12] = _mm256_add_epi32(_mm256_set1_epi32((int)counter), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    input[13] = _mm256_setzero_si256();
+    input[14] = _mm256_setzero_si256();
+    input[15] = _mm256_setzero_si256();
+
+    for (int i = 0; i < 16; i++) {
+        x[i] = input[i];
+    }
+    for (int round = 0; round < 10; round++) {
+        AVX_CHACHA_QUARTER(x[0], x[4], x[8], x[12]);
+        AVX_CHACHA_QUARTER(x[1], x[5], x[9], x[13]);
+        AVX_CHACHA_QUARTER(x[2], x[6], x[10], x[14]);
+        AVX_CHACHA_QUARTER(x[3], x[7], x[11], x[15]);
+        AVX_CHACHA_QUARTER(x[0], x[5], x[10], x[15]);
+        AVX_CHACHA_QUARTER(x[1], x[6], x[11], x[12]);
+        AVX_CHACHA_QUARTER(x[2], x[7], x[8], x[13]);
+        AVX_CHACHA_QUARTER(x[3], x[4], x[9], x[14]);
+    }
+    for (int i = 0; i < 16; i++) {
+        x[i] = _mm256_add_epi32(x[i], input[i]);
+    }
+
+    // 每 8 个字一组：32 位与 64 位交织得到各 128 位半边的 4 个字，再拼接两组半边
+    for (int i = 0; i < 16; i += 8) {
+        __m256i half[2][4];
+        for (int h = 0; h < 2; h++) {
+            const __m256i* a = x + i + 4 * h;
+            __m256i t0 = _mm256_unpacklo_epi32(a[0], a[1]);
+            __m256i t1 = _mm256_unpackhi_epi32(a[0], a[1]);
+            __m256i t2 = _mm256_unpacklo_epi32(a[2], a[3]);
+            __m256i t3 = _mm256_unpackhi_epi32(a[2], a[3]);
+            half[h][0] = _mm256_unpacklo_epi64(t0, t2);
+            half[h][1] = _mm256_unpackhi_epi64(t0, t2);
+            half[h][2] = _mm256_unpacklo_epi64(t1, t3);
+            half[h][3] = _mm256_unpackhi_epi64(t1, t3);
+        }
+        for (int b = 0; b < 4; b++) {
+            _mm256_storeu_si256((__m256i*)(out + 16 * b + i),
+                                _mm256_permute2x128_si256(half[0][b], half[1][b], 0x20));
+            _mm256_storeu_si256((__m256i*)(out + 16 * (b + 4) + i),
+                                _mm256_permute2x128_si256(half[0][b], half[1][b], 0x31));
+        }
+    }
+}
+#endif
+
+// Philox4x32-10 乘数与密钥增量（Salmon 等，Random123）
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+// 批量生成时同时计算的块数（各块同时推进便于向量化）
+#define PHILOX_WAYS 8
+
+// 计数器 (c0, c1, c2, 0) 的一个输出块（4 个字）
+static void philox_block(const uint32_t key[2], uint32_t c0, uint32_t c1, uint32_t c2, uint32_t* out) {
+    uint32_t c3 = 0;
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+
+    for (int r = 0; r < PHILOX_ROUNDS; r++) {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+        c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1;
+        c3 = (uint32_t)p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+// 序号 index 的首个候选值：第 index / 4 块（c2 = 0）的第 index % 4 个字
+static uint32_t philox_word(const uint32_t key[2], uint64_t index) {
+    uint32_t block[4];
+    uint64_t b = index >> 2;
+    philox_block(key, (uint32_t)b, (uint32_t)(b >> 32), 0, block);
+    return block[index & 3];
+}
+
+// 序号 index 的 [0, bound) 均匀随机数（Lemire 方法）：首个候选被拒绝时，
+//   依次取计数器 (index, attempt) 块中的 4 个字（attempt 从 1 开始，与首个候选的块互不重叠）
+static uint32_t philox_bounded(const uint32_t key[2], uint64_t index, uint32_t first,
+                               uint32_t bound, uint32_t threshold) {
+    uint64_t m = (uint64_t)first * bound;
+    for (uint32_t attempt = 1; (uint32_t)m < threshold; attempt++) {
+        uint32_t block[4];
+        philox_block(key, (uint32_t)index, (uint32_t)(index >> 32), attempt, block);
+        for (int k = 0; k < 4; k++) {
+            m = (uint64_t)block[k] * bound;
+            if ((uint32_t)m >= threshold) {
+                break;
+            }
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+#ifdef __SSE2__
+// 4 路 32 位无符号乘法的高、低 32 位（偶数路与奇数路分别做 32x32->64 乘法）
+static inline void sse_mulhilo32(__m128i x, __m128i m, __m128i* hi, __m128i* lo) {
+    __m128i even = _mm_mul_epu32(x, m);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), m);
+    *hi = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(3, 1, 3, 1)),
+                             _mm_shuffle_epi32(odd, _MM_SHUFFLE(3, 1, 3, 1)));
+    *lo = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(2, 0, 2, 0)),
+                             _mm_shuffle_epi32(odd, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+// 同时计算 PHILOX_WAYS 个相邻块（第 b ~ b + PHILOX_WAYS - 1 块，c2 = 0），输出按序号排列
+//   每个向量装 4 个块的同一个计数器字，最后 4x4 转置回按块排列
+static void philox_blocks(const uint32_t key[2], uint64_t b, uint32_t* out) {
+    const __m128i m0 = _mm_set1_epi32((int)PHILOX_M0);
+    const __m128i m1 = _mm_set1_epi32((int)PHILOX_M1);
+    __m128i c0[PHILOX_WAYS / 4], c1[PHILOX_WAYS / 4], c2[PHILOX_WAYS / 4], c3[PHILOX_WAYS / 4];
+
+    for (int g = 0; g < PHILOX_WAYS / 4; g++) {
+        uint32_t lo[4], hi[4];
+        for (int w = 0; w < 4; w++) {
+            uint64_t block = b + (uint64_t)(4 * g + w);
+            lo[w] = (uint32_t)block;
+            hi[w] = (uint32_t)(block >> 32);
+        }
+        c0[g] = _mm_loadu_si128((const __m128i*)lo);
+        c1[g] = _mm_loadu_si128((const __m128i*)hi);
+        c2[g] = _mm_setzero_si128();
+        c3[g] = _mm_setzero_si128();
+    }
+
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+    for (int r = 0; r < PHILOX_ROUNDS; r++) {
+        const __m128i vk0 = _mm_set1_epi32((int)k0);
+        const __m128i vk1 = _mm_set1_epi32((int)k1);
+        for (int g = 0; g < PHILOX_WAYS / 4; g++) {
+            __m128i hi0, lo0, hi1, lo1;
+            sse_mulhilo32(c0[g], m0, &hi0, &lo0);
+            sse_mulhilo32(c2[g], m1, &hi1, &lo1);
+            c0[g] = _mm_xor_si128(_mm_xor_si128(hi1, c1[g]), vk0);
+            c2[g] = _mm_xor_si128(_mm_xor_si128(hi0, c3[g]), vk1);
+            c1[g] = lo1;
+            c3[g] = lo0;
+        }
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    for (int g = 0; g < PHILOX_WAYS / 4; g++) {
+        __m128i t0 = _mm_unpacklo_epi32(c0[g], c1[g]);
+        __m128i t1 = _mm_unpacklo_epi32(c2[g], c3[g]);
+        __m128i t2 = _mm_unpackhi_epi32(c0[g], c1[g]);
+        __m128i t3 = _mm_unpackhi_epi32(c2[g], c3[g]);
+        __m128i* dst = (__m128i*)(out + 16 * g);
+        _mm_storeu_si128(dst + 0, _mm_unpacklo_epi64(t0, t1));
+        _mm_storeu_si128(dst + 1, _mm_unpackhi_epi64(t0, t1));
+        _mm_storeu_si128(dst + 2, _mm_unpacklo_epi64(t2, t3));
+        _mm_storeu_si128(dst + 3, _mm_unpackhi_epi64(t2, t3));
+    }
+}
+#else
+// 同时计算 PHILOX_WAYS 个相邻块（第 b ~ b + PHILOX_WAYS - 1 块，c2 = 0），输出按序号排列
+static void philox_blocks(const uint32_t key[2], uint64_t b, uint32_t* out) {
+    uint32_t c0[PHILOX_WAYS], c1[PHILOX_WAYS], c2[PHILOX_WAYS], c3[PHILOX_WAYS];
+    for (int w = 0; w < PHILOX_WAYS; w++) {
+        c0[w] = (uint32_t)(b + (uint64_t)w);
+        c1[w] = (uint32_t)((b + (uint64_t)w) >> 32);
+        c2[w] = 0;
+        c3[w] = 0;
+    }
+
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+    for (int r = 0; r < PHILOX_ROUNDS; r++) {
+        for (int w = 0; w < PHILOX_WAYS; w++) {
+            uint64_t p0 = (uint64_t)PHILOX_M0 * c0[w];
+            uint64_t p1 = (uint64_t)PHILOX_M1 * c2[w];
+            c0[w] = (uint32_t)(p1 >> 32) ^ c1[w] ^ k0;
+            c2[w] = (uint32_t)(p0 >> 32) ^ c3[w] ^ k1;
+            c1[w] = (uint32_t)p1;
+            c3[w] = (uint32_t)p0;
+        }
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    for (int w = 0; w < PHILOX_WAYS; w++) {
+        out[4 * w + 0] = c0[w];
+        out[4 * w + 1] = c1[w];
+        out[4 * w + 2] = c2[w];
+        out[4 * w + 3] = c3[w];
+    }
+}
+#endif
+
+// 清零密钥材料（volatile 写入不会被当作无用存储优化掉）
+static void secure_zero(void* data, size_t size) {
+    volatile unsigned char* p = (volatile unsigned char*)data;
+    while (size-- > 0) {
+        *p++ = 0;
+    }
+}
+
+// 从操作系统熵源读取 size 字节，失败返回 -1
+static int entropy_fill(void* data, size_t size) {
+#ifdef _WIN32
+    return BCryptGenRandom(NULL, (PUCHAR)data, (ULONG)size, BCRYPT_USE_SYSTEM_PREFERRED_RNG) == 0 ? 0 : -1;
+#elif defined(__linux__)
+    unsigned char* p = (unsigned char*)data;
+    while (size > 0) {
+        ssize_t n = getrandom(p, size, 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        size -= (size_t)n;
+    }
+    return 0;
+#else
+    // getentropy 每次最多 256 字节
+    unsigned char* p = (unsigned char*)data;
+    while (size > 0) {
+        size_t n = size > 256 ? 256 : size;
+        if (getentropy(p, n) != 0) {
+            return -1;
+        }
+        p += n;
+        size -= n;
+    }
+    return 0;
+#endif
+}
+
+// 用当前密钥填满密钥流缓冲区，前 8 个字留作下一次的密钥并清零（快速密钥擦除：
+//   之后即使内存泄露，也无法倒推出已经取出的随机数）
+static void pool_refill(RandomGenerator* rg) {
+    uint32_t counter = 0;
+#ifdef RANDOM_CHACHA_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        for (; counter + 8 <= CHACHA_BLOCKS; counter += 8) {
+            chacha_blocks8(rg->key, counter, rg->pool + (size_t)counter * 16);
+        }
+    }
+#endif
+#ifdef __SSE2__
+    for (; counter + 4 <= CHACHA_BLOCKS; counter += 4) {
+        chacha_blocks4(rg->key, counter, rg->pool + (size_t)counter * 16);
+    }
+#endif
+    for (; counter < CHACHA_BLOCKS; counter++) {
+        chacha_block(rg->key, counter, rg->pool + (size_t)counter * 16);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        rg->key[i] = rg->pool[i];
+        rg->pool[i] = 0;
+    }
+    rg->pool_pos = 8;
+
+    // 定期混入新的系统熵（读取失败时仍可依靠密钥擦除继续）
+    if (++rg->refills >= RANDOM_RESEED_REFILLS) {
+        uint32_t fresh[8];
+        if (entropy_fill(fresh, sizeof(fresh)) == 0) {
+            for (int i = 0; i < 8; i++) {
+                rg->key[i] ^= fresh[i];
+            }
+        }
+        secure_zero(fresh, sizeof(fresh));
+        rg->refills = 0;
+    }
+}
+
+// 切换到安全模式
+int random_generator_secure(RandomGenerator* rg) {
+    if (rg == NULL) {
+        return -1;
+    }
+    if (rg->mode == RANDOM_MODE_SECURE) {
+        return 0;
+    }
+
+    uint32_t* pool = (uint32_t*)malloc(RANDOM_POOL_WORDS * sizeof(uint32_t));
+    if (pool == NULL) {
+        return -1;
+    }
+    if (entropy_fill(rg->key, sizeof(rg->key)) != 0) {
+        secure_zero(rg->key, sizeof(rg->key));
+        free(pool);
+        return -1;
+    }
+
+    rg->pool = pool;
+    rg->refills = 0;
+    pool_refill(rg);
+    rg->mode = RANDOM_MODE_SECURE;
+    return 0;
+}
+
+// 切换到计数模式
+int random_generator_counter(RandomGenerator* rg, unsigned int seed) {
+    if (rg == NULL || rg->mode == RANDOM_MODE_SECURE) {
+        return -1;
+    }
+
+    rg->mode = RANDOM_MODE_COUNTER;
+    random_generator_seed(rg, seed);
+    return 0;
+}
+
 // 初始化随机生成器
 RandomGenerator* random_generator_init() {
     RandomGenerator* rg = (RandomGenerator*)malloc(sizeof(RandomGenerator));
@@ -16,29 +519,293 @@ RandomGenerator* random_generator_init() {
         return NULL;
     }
 
-    rg->seed = (unsigned int)time(NULL);
     rg->charset = CHARSET;
     rg->charset_size = CHARSET_SIZE;
-
-    // 初始化标准随机数生成器
-    srand(rg->seed);
+    rg->mode = RANDOM_MODE_FAST;
+    rg->pool = NULL;
+    rg->pool_pos = 0;
+    rg->refills = 0;
+    rg->sequence = 0;
+    random_generator_seed(rg, (unsigned int)time(NULL));
 
     return rg;
 }
 
+// 以指定种子重置随机生成器（相同种子产生相同序列）
+void random_generator_seed(RandomGenerator* rg, unsigned int seed) {
+    if (rg == NULL || rg->mode == RANDOM_MODE_SECURE) {
+        return;
+    }
+
+    rg->seed = seed;
+
+    // 计数模式：密钥由种子派生，序号归零
+    if (rg->mode == RANDOM_MODE_COUNTER) {
+        uint64_t sm = seed;
+        uint64_t key = splitmix64(&sm);
+        rg->philox_key[0] = (uint32_t)key;
+        rg->philox_key[1] = (uint32_t)(key >> 32);
+        rg->sequence = 0;
+        return;
+    }
+
+    // 各路状态由种子派生（全零状态的概率可以忽略）
+    uint64_t sm = rg->seed;
+    for (int l = 0; l < RANDOM_LANES; l++) {
+        uint64_t a = splitmix64(&sm);
+        uint64_t b = splitmix64(&sm);
+        rg->lanes[0][l] = (uint32_t)a;
+        rg->lanes[1][l] = (uint32_t)(a >> 32);
+        rg->lanes[2][l] = (uint32_t)b;
+        rg->lanes[3][l] = (uint32_t)(b >> 32) | 1u;
+    }
+    rg->buffer_pos = RANDOM_LANES;
+}
+
+// 生成 32 位随机数
+uint32_t random_next(RandomGenerator* rg) {
+    if (rg->mode == RANDOM_MODE_SECURE) {
+        if (rg->pool_pos == RANDOM_POOL_WORDS) {
+            pool_refill(rg);
+        }
+        uint32_t x = rg->pool[rg->pool_pos];
+        rg->pool[rg->pool_pos++] = 0;
+        return x;
+    }
+    if (rg->mode == RANDOM_MODE_COUNTER) {
+        return philox_word(rg->philox_key, rg->sequence++);
+    }
+
+    if (rg->buffer_pos == RANDOM_LANES) {
+        lanes_next(rg, rg->buffer);
+        rg->buffer_pos = 0;
+    }
+    return rg->buffer[rg->buffer_pos++];
+}
+
+// 生成 [0, bound) 内的均匀随机数
+//   取 x * bound 的高 32 位，低 32 位落入偏差区间时重新抽取（Lemire 方法）
+uint32_t random_bounded(RandomGenerator* rg, uint32_t bound) {
+    if (rg->mode == RANDOM_MODE_COUNTER) {
+        uint64_t index = rg->sequence++;
+        return philox_bounded(rg->philox_key, index, philox_word(rg->philox_key, index),
+                              bound, (0u - bound) % bound);
+    }
+
+    uint64_t m = (uint64_t)random_next(rg) * bound;
+    if ((uint32_t)m < bound) {
+        uint32_t threshold = (0u - bound) % bound;
+        while ((uint32_t)m < threshold) {
+            m = (uint64_t)random_next(rg) * bound;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+#ifdef __SSE2__
+// 所有路推进一步并映射到 [0, bound)，返回需要拒绝重抽的路掩码
+//   SSE2 没有 32 位向量乘法：*5、*9 用移位相加，x * bound 的高 32 位用两次 _mm_mul_epu32
+static uint32_t lanes_next_bounded(RandomGenerator* rg, uint32_t bound, uint32_t threshold,
+                                   uint32_t* out) {
+    const __m128i vbound = _mm_set1_epi32((int)bound);
+    const __m128i vthreshold = _mm_set1_epi32((int)(threshold ^ 0x80000000u));
+    const __m128i sign = _mm_set1_epi32((int)0x80000000u);
+    uint32_t rejected = 0;
+
+    for (int l = 0; l < RANDOM_LANES; l += 4) {
+        __m128i s0 = _mm_loadu_si128((const __m128i*)(rg->lanes[0] + l));
+        __m128i s1 = _mm_loadu_si128((const __m128i*)(rg->lanes[1] + l));
+        __m128i s2 = _mm_loadu_si128((const __m128i*)(rg->lanes[2] + l));
+        __m128i s3 = _mm_loadu_si128((const __m128i*)(rg->lanes[3] + l));
+
+        // xoshiro128** 输出：rotl(s1 * 5, 7) * 9
+        __m128i x = _mm_add_epi32(_mm_slli_epi32(s1, 2), s1);
+        x = SSE_ROTL32(x, 7);
+        x = _mm_add_epi32(_mm_slli_epi32(x, 3), x);
+
+        // 状态推进
+        __m128i t = _mm_slli_epi32(s1, 9);
+        s2 = _mm_xor_si128(s2, s0);
+        s3 = _mm_xor_si128(s3, s1);
+        s1 = _mm_xor_si128(s1, s2);
+        s0 = _mm_xor_si128(s0, s3);
+        s2 = _mm_xor_si128(s2, t);
+        s3 = SSE_ROTL32(s3, 11);
+
+        _mm_storeu_si128((__m128i*)(rg->lanes[0] + l), s0);
+        _mm_storeu_si128((__m128i*)(rg->lanes[1] + l), s1);
+        _mm_storeu_si128((__m128i*)(rg->lanes[2] + l), s2);
+        _mm_storeu_si128((__m128i*)(rg->lanes[3] + l), s3);
+
+        // x * bound：偶数路与奇数路分别做 32x32->64 乘法
+        __m128i even = _mm_mul_epu32(x, vbound);
+        __m128i odd = _mm_mul_epu32(_mm_srli_epi64(x, 32), vbound);
+        __m128i hi = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(3, 1, 3, 1)),
+                                        _mm_shuffle_epi32(odd, _MM_SHUFFLE(3, 1, 3, 1)));
+        __m128i lo = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(2, 0, 2, 0)),
+                                        _mm_shuffle_epi32(odd, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_si128((__m128i*)(out + l), hi);
+
+        // 无符号比较 lo < threshold（翻转符号位后做有符号比较）
+        __m128i reject = _mm_cmplt_epi32(_mm_xor_si128(lo, sign), vthreshold);
+        rejected |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(reject)) << l;
+    }
+
+    return rejected;
+}
+#else
+// 所有路推进一步并映射到 [0, bound)，返回需要拒绝重抽的路掩码
+static uint32_t lanes_next_bounded(RandomGenerator* rg, uint32_t bound, uint32_t threshold,
+                                   uint32_t* out) {
+    uint32_t block[RANDOM_LANES];
+    uint32_t rejected = 0;
+
+    lanes_next(rg, block);
+    for (int l = 0; l < RANDOM_LANES; l++) {
+        uint64_t m = (uint64_t)block[l] * bound;
+        out[l] = (uint32_t)(m >> 32);
+        rejected |= (uint32_t)((uint32_t)m < threshold) << l;
+    }
+
+    return rejected;
+}
+#endif
+
+// 批量生成 [0, bound) 内的均匀随机数
+void random_fill_bounded(RandomGenerator* rg, uint32_t bound, uint32_t* out, size_t count) {
+    if (rg == NULL || out == NULL || bound == 0) {
+        return;
+    }
+
+    uint32_t threshold = (0u - bound) % bound;
+    size_t i = 0;
+
+    // 安全模式：整段取用密钥流缓冲区（取出后清零），被拒绝的位置先标记为 UINT32_MAX
+    //   （bound <= UINT32_MAX 时不是合法结果），整段处理完再逐个重抽
+    if (rg->mode == RANDOM_MODE_SECURE) {
+        while (i < count) {
+            if (rg->pool_pos == RANDOM_POOL_WORDS) {
+                pool_refill(rg);
+            }
+            size_t n = (size_t)(RANDOM_POOL_WORDS - rg->pool_pos);
+            if (n > count - i) {
+                n = count - i;
+            }
+
+            uint32_t* src = rg->pool + rg->pool_pos;
+            uint32_t* dst = out + i;
+            size_t rejected = 0;
+            for (size_t k = 0; k < n; k++) {
+                uint64_t m = (uint64_t)src[k] * bound;
+                int reject = (uint32_t)m < threshold;
+                dst[k] = reject ? UINT32_MAX : (uint32_t)(m >> 32);
+                rejected += (size_t)reject;
+            }
+            memset(src, 0, n * sizeof(uint32_t));
+            rg->pool_pos += (int)n;
+
+            for (size_t k = 0; rejected > 0 && k < n; k++) {
+                if (dst[k] == UINT32_MAX) {
+                    dst[k] = random_bounded(rg, bound);
+                    rejected--;
+                }
+            }
+            i += n;
+        }
+        return;
+    }
+
+    // 计数模式：按序号生成，结果与依次调用 random_bounded 相同
+    if (rg->mode == RANDOM_MODE_COUNTER) {
+        random_fill_bounded_at(rg, random_reserve(rg, count), bound, out, count);
+        return;
+    }
+
+    // 整块：各路一起推进并做乘法映射，拒绝极少发生，单独重抽
+    for (; i + RANDOM_LANES <= count; i += RANDOM_LANES) {
+        uint32_t rejected = lanes_next_bounded(rg, bound, threshold, out + i);
+
+        while (rejected != 0) {
+            int l = 0;
+            while (!(rejected & (1u << l))) {
+                l++;
+            }
+            out[i + l] = random_bounded(rg, bound);
+            rejected &= rejected - 1;
+        }
+    }
+
+    // 尾部
+    for (; i < count; i++) {
+        out[i] = random_bounded(rg, bound);
+    }
+}
+
+// 计数模式：预留 count 个序号
+uint64_t random_reserve(RandomGenerator* rg, uint64_t count) {
+    if (rg == NULL || rg->mode != RANDOM_MODE_COUNTER) {
+        return 0;
+    }
+    uint64_t first = rg->sequence;
+    rg->sequence += count;
+    return first;
+}
+
+// 计数模式：按序号批量生成 [0, bound) 内的均匀随机数
+int random_fill_bounded_at(const RandomGenerator* rg, uint64_t first, uint32_t bound,
+                           uint32_t* out, size_t count) {
+    if (rg == NULL || rg->mode != RANDOM_MODE_COUNTER || out == NULL || bound == 0) {
+        return -1;
+    }
+
+    const uint32_t* key = rg->philox_key;
+    uint32_t threshold = (0u - bound) % bound;
+    size_t i = 0;
+
+    // 对齐到块边界之前的零散序号
+    for (; i < count && ((first + i) & 3) != 0; i++) {
+        uint64_t index = first + i;
+        out[i] = philox_bounded(key, index, philox_word(key, index), bound, threshold);
+    }
+
+    // 整组：PHILOX_WAYS 块共 4 * PHILOX_WAYS 个序号一起计算，拒绝极少发生，单独重抽
+    uint32_t words[4 * PHILOX_WAYS];
+    for (; i + 4 * PHILOX_WAYS <= count; i += 4 * PHILOX_WAYS) {
+        philox_blocks(key, (first + i) >> 2, words);
+        for (int k = 0; k < 4 * PHILOX_WAYS; k++) {
+            uint64_t m = (uint64_t)words[k] * bound;
+            out[i + k] = (uint32_t)m < threshold
+                             ? philox_bounded(key, first + i + k, words[k], bound, threshold)
+                             : (uint32_t)(m >> 32);
+        }
+    }
+
+    // 尾部
+    for (; i < count; i++) {
+        uint64_t index = first + i;
+        out[i] = philox_bounded(key, index, philox_word(key, index), bound, threshold);
+    }
+    return 0;
+}
+
 // 生成下一个随机字母
 char generate_random_letter(RandomGenerator* rg) {
     if (rg == NULL) {
         return 'a';
     }
 
-    int index = rand() % rg->charset_size;
+    int index = (int)random_bounded(rg, (uint32_t)rg->charset_size);
     return rg->charset[index];
 }
 
 // 释放随机生成器
 void random_generator_free(RandomGenerator* rg) {
     if (rg != NULL) {
+        if (rg->pool != NULL) {
+            secure_zero(rg->pool, RANDOM_POOL_WORDS * sizeof(uint32_t));
+            free(rg->pool);
+        }
+        secure_zero(rg->key, sizeof(rg->key));
         free(rg);
     }
 }
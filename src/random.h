@@ -1,11 +1,39 @@
 #ifndef GACHA_RANDOM_H
 #define GACHA_RANDOM_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+// 并行随机数路数（每路一个独立的 xoshiro128** 状态）
+#define RANDOM_LANES 8
+
+// 生成模式
+#define RANDOM_MODE_FAST 0           // xoshiro128**（默认，可用种子复现）
+#define RANDOM_MODE_SECURE 1         // ChaCha20 密钥流，密钥取自操作系统熵源（不可预测）
+#define RANDOM_MODE_COUNTER 2        // Philox4x32-10 计数模式（序号 i 的结果只取决于种子与 i，可并行复现）
+
+// 安全模式参数
+#define RANDOM_POOL_WORDS 16384      // 密钥流缓冲区字数（64 KiB，一次填充供上万次取数）
+#define RANDOM_RESEED_REFILLS 64     // 每填充多少次混入一次新的系统熵
+
 // 随机生成器状态
 typedef struct {
     unsigned int seed;       // 随机种子
     const char* charset;     // 字符集 [a-zA-Z]
     int charset_size;        // 字符集大小
+
+    uint32_t lanes[4][RANDOM_LANES];  // xoshiro128** 状态（按状态字分组，各路同时推进便于向量化）
+    uint32_t buffer[RANDOM_LANES];    // 单个取数时缓存的一轮输出
+    int buffer_pos;                   // 缓存中下一个可用位置
+
+    int mode;                         // 生成模式（见 RANDOM_MODE_*）
+    uint32_t* pool;                   // 安全模式：ChaCha20 密钥流缓冲区（取出的字随即清零）
+    int pool_pos;                     // 密钥流缓冲区中下一个可用位置
+    uint32_t key[8];                  // 安全模式：下一次填充使用的密钥（取自上一次密钥流）
+    int refills;                      // 上次混入系统熵之后的填充次数
+
+    uint32_t philox_key[2];           // 计数模式：由种子派生的 Philox 密钥
+    uint64_t sequence;                // 计数模式：下一个数的全局序号
 } RandomGenerator;
 
 // 字符集定义
@@ -17,9 +45,37 @@ typedef struct {
 // 初始化随机生成器
 RandomGenerator* random_generator_init();
 
+// 切换到安全模式（ChaCha20 密钥流，密钥取自 getrandom / getentropy / BCryptGenRandom），
+//   无法读取系统熵源时返回 -1 且保持原模式
+int random_generator_secure(RandomGenerator* rg);
+
+// 切换到计数模式（Philox4x32-10，以 seed 派生密钥，序号从 0 开始），安全模式下返回 -1
+//   序号 i 的结果只取决于 (seed, i)：每次取数（random_next / random_bounded / 批量中的每一项）占用一个序号
+int random_generator_counter(RandomGenerator* rg, unsigned int seed);
+
+// 以指定种子重置随机生成器（相同种子产生相同序列，安全模式下无效；计数模式下序号归零）
+void random_generator_seed(RandomGenerator* rg, unsigned int seed);
+
 // 生成下一个随机字母
 char generate_random_letter(RandomGenerator* rg);
 
+// 生成 32 位随机数
+uint32_t random_next(RandomGenerator* rg);
+
+// 生成 [0, bound) 内的均匀随机数（bound > 0）
+uint32_t random_bounded(RandomGenerator* rg, uint32_t bound);
+
+// 批量生成 [0, bound) 内的均匀随机数（各路并行推进，乘法映射 + 少量拒绝采样）
+void random_fill_bounded(RandomGenerator* rg, uint32_t bound, uint32_t* out, size_t count);
+
+// 计数模式：预留 count 个序号，返回第一个（其他模式返回 0）
+uint64_t random_reserve(RandomGenerator* rg, uint64_t count);
+
+// 计数模式：生成序号 first ~ first + count - 1 的 [0, bound) 均匀随机数（不修改生成器，可多线程同时调用），
+//   与依次调用 random_bounded 的结果相同；其他模式返回 -1
+int random_fill_bounded_at(const RandomGenerator* rg, uint64_t first, uint32_t bound,
+                           uint32_t* out, size_t count);
+
 // 释放随机生成器
 void random_generator_free(RandomGenerator* rg);
 
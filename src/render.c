@@ -0,0 +1,334 @@
+#include "render.h"
+#include "random.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <signal.h>
+#endif
+
+#include "alloc.h"
+
+// 帧缓冲区初始容量
+#define RENDER_FRAME_INITIAL 4096
+
+// 向帧缓冲区追加内容
+static int frame_append(RenderState* rs, const char* data, size_t length) {
+    if (rs->frame_len + length > rs->frame_capacity) {
+        size_t capacity = rs->frame_capacity;
+        while (rs->frame_len + length > capacity) {
+            capacity *= 2;
+        }
+        char* frame = (char*)realloc(rs->frame, capacity);
+        if (frame == NULL) {
+            return -1;
+        }
+        rs->frame = frame;
+        rs->frame_capacity = capacity;
+    }
+
+    memcpy(rs->frame + rs->frame_len, data, length);
+    rs->frame_len += length;
+    return 0;
+}
+
+// 将事件格式化到帧缓冲区（与原先逐字母输出的格式一致）
+static void frame_event(RenderState* rs, const RenderEvent* event) {
+    switch (event->type) {
+    case RENDER_EVENT_LETTER:
+        frame_append(rs, &event->letter, 1);
+        rs->recent[rs->recent_pos] = event->letter;
+        rs->recent[rs->recent_pos + rs->recent_size] = event->letter;
+        if (++rs->recent_pos == rs->recent_size) {
+            rs->recent_pos = 0;
+        }
+        if (rs->recent_len < rs->recent_size) {
+            rs->recent_len++;
+        }
+        break;
+
+    case RENDER_EVENT_SYMBOL:
+        // 编号只在输出时转换为 UTF-8；字母表匹配为逐字匹配，匹配时直接显示字典写法
+        frame_append(rs, rs->alphabet->bytes + (size_t)event->value * ALPHABET_MAX_BYTES,
+                     rs->alphabet->lengths[event->value]);
+        break;
+
+    case RENDER_EVENT_MATCH: {
+        // 换行后加粗显示匹配的原文（模式匹配到的字母可能与字典写法不同），
+        // 字母被省略时退回显示字典中的写法
+        const char* text;
+        size_t length;
+        if (event->count > 0 && event->count <= rs->recent_len) {
+            text = rs->recent + rs->recent_pos + rs->recent_size - event->count;
+            length = (size_t)event->count;
+        } else {
+            text = rs->dictionary[event->value].text;
+            length = (size_t)rs->dictionary[event->value].length;
+        }
+        rs->recent_len = 0;
+
+        frame_append(rs, "\n", 1);
+        if (rs->os->bold_enabled) {
+            frame_append(rs, ANSI_BOLD, strlen(ANSI_BOLD));
+        }
+        frame_append(rs, text, length);
+        if (rs->os->bold_enabled) {
+            frame_append(rs, ANSI_RESET, strlen(ANSI_RESET));
+        }
+        break;
+    }
+
+    case RENDER_EVENT_SKIP: {
+        char note[128];
+        int length;
+        if (event->count > 0) {
+            length = snprintf(note, sizeof(note), "\n[输出过慢，省略 %d 个字母、%d 次匹配]\n",
+                              event->value, event->count);
+        } else {
+            length = snprintf(note, sizeof(note), "\n[输出过慢，省略 %d 个字母]\n", event->value);
+        }
+        if (length > 0) {
+            frame_append(rs, note, (size_t)length);
+        }
+        rs->recent_len = 0;
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+// 取出事件环中已有的全部事件，返回取出的数量
+static unsigned int drain_events(RenderState* rs) {
+    unsigned int head = atomic_load_explicit(&rs->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&rs->tail, memory_order_acquire);
+
+    for (unsigned int pos = head; pos != tail; pos++) {
+        frame_event(rs, &rs->ring[pos & rs->ring_mask]);
+    }
+
+    // 事件格式化完成后再归还槽位
+    atomic_store_explicit(&rs->head, tail, memory_order_release);
+    return tail - head;
+}
+
+// 输出线程：每帧合并一次事件并整块写入终端
+static void render_loop(RenderState* rs) {
+    int frame_ms = 1000 / RENDER_FPS;
+
+    trace_thread_begin("render");
+    for (;;) {
+        int closed = atomic_load_explicit(&rs->closed, memory_order_acquire);
+        long long frame_start = trace_begin();
+
+        rs->frame_len = 0;
+        drain_events(rs);
+        if (rs->frame_len > 0) {
+            output_write(rs->os, rs->frame, rs->frame_len);
+            trace_complete("render_frame", frame_start, (long long)rs->frame_len);
+        }
+
+        // 生产者结束后，closed 之前写入的事件已全部取出
+        if (closed) {
+            break;
+        }
+
+        sleep_ms(frame_ms);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI render_thread_main(LPVOID arg) {
+    render_loop((RenderState*)arg);
+    return 0;
+}
+#else
+static void* render_thread_main(void* arg) {
+    render_loop((RenderState*)arg);
+    return NULL;
+}
+#endif
+
+// 创建事件环并启动输出线程
+RenderState* render_start(OutputState* os, const DictWord* dictionary, int window,
+                          const Alphabet* alphabet) {
+    if (os == NULL || dictionary == NULL || window <= 0) {
+        return NULL;
+    }
+
+    RenderState* rs = (RenderState*)malloc(sizeof(RenderState));
+    if (rs == NULL) {
+        return NULL;
+    }
+
+    rs->ring = (RenderEvent*)malloc(RENDER_RING_SIZE * sizeof(RenderEvent));
+    rs->frame = (char*)malloc(RENDER_FRAME_INITIAL);
+    rs->recent = (char*)malloc((size_t)window * 2);
+    if (rs->ring == NULL || rs->frame == NULL || rs->recent == NULL) {
+        free(rs->recent);
+        free(rs->ring);
+        free(rs->frame);
+        free(rs);
+        return NULL;
+    }
+
+    rs->ring_mask = RENDER_RING_SIZE - 1;
+    atomic_init(&rs->tail, 0u);
+    atomic_init(&rs->head, 0u);
+    atomic_init(&rs->closed, 0);
+    rs->head_cache = 0;
+    rs->skipped_letters = 0;
+    rs->skipped_matches = 0;
+    rs->dictionary = dictionary;
+    rs->alphabet = alphabet;
+    rs->os = os;
+    rs->recent_size = window;
+    rs->recent_pos = 0;
+    rs->recent_len = 0;
+    rs->frame_len = 0;
+    rs->frame_capacity = RENDER_FRAME_INITIAL;
+
+    // 启动输出线程
+#ifdef _WIN32
+    rs->thread = CreateThread(NULL, 0, render_thread_main, rs, 0, NULL);
+    if (rs->thread == NULL) {
+        free(rs->recent);
+        free(rs->ring);
+        free(rs->frame);
+        free(rs);
+        return NULL;
+    }
+#else
+    // 输出线程不处理 Ctrl+C，信号统一由生成线程响应
+    sigset_t block, previous;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &block, &previous);
+    int error = pthread_create(&rs->thread, NULL, render_thread_main, rs);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if (error != 0) {
+        free(rs->recent);
+        free(rs->ring);
+        free(rs->frame);
+        free(rs);
+        return NULL;
+    }
+#endif
+
+    return rs;
+}
+
+// 写入一个事件，事件环已满时返回 -1
+static int ring_push(RenderState* rs, const RenderEvent* event) {
+    unsigned int tail = atomic_load_explicit(&rs->tail, memory_order_relaxed);
+
+    // 先用缓存的消费位置判断，只有看起来已满时才读取共享的 head
+    if (tail - rs->head_cache > rs->ring_mask) {
+        rs->head_cache = atomic_load_explicit(&rs->head, memory_order_acquire);
+        if (tail - rs->head_cache > rs->ring_mask) {
+            return -1;
+        }
+    }
+
+    rs->ring[tail & rs->ring_mask] = *event;
+    atomic_store_explicit(&rs->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+// 补报此前省略的事件，事件环仍然已满时返回 -1
+static int flush_skipped(RenderState* rs) {
+    if (rs->skipped_letters == 0 && rs->skipped_matches == 0) {
+        return 0;
+    }
+
+    RenderEvent event;
+    event.type = RENDER_EVENT_SKIP;
+    event.value = rs->skipped_letters;
+    event.count = rs->skipped_matches;
+    event.letter = 0;
+    if (ring_push(rs, &event) != 0) {
+        return -1;
+    }
+
+    rs->skipped_letters = 0;
+    rs->skipped_matches = 0;
+    return 0;
+}
+
+// 提交生成的字母（不阻塞）
+void render_push_letter(RenderState* rs, char letter) {
+    if (rs == NULL) {
+        return;
+    }
+
+    RenderEvent event;
+    event.type = RENDER_EVENT_LETTER;
+    event.value = 0;
+    event.count = 0;
+    event.letter = letter;
+    if (flush_skipped(rs) != 0 || ring_push(rs, &event) != 0) {
+        rs->skipped_letters++;
+    }
+}
+
+// 提交生成的字母表编号（不阻塞）
+void render_push_symbol(RenderState* rs, int symbol) {
+    if (rs == NULL) {
+        return;
+    }
+
+    RenderEvent event;
+    event.type = RENDER_EVENT_SYMBOL;
+    event.value = symbol;
+    event.count = 0;
+    event.letter = 0;
+    if (flush_skipped(rs) != 0 || ring_push(rs, &event) != 0) {
+        rs->skipped_letters++;
+    }
+}
+
+// 提交匹配事件（不阻塞）
+void render_push_match(RenderState* rs, int word_index, int length) {
+    if (rs == NULL) {
+        return;
+    }
+
+    RenderEvent event;
+    event.type = RENDER_EVENT_MATCH;
+    event.value = word_index;
+    event.count = length;
+    event.letter = 0;
+    if (flush_skipped(rs) != 0 || ring_push(rs, &event) != 0) {
+        rs->skipped_matches++;
+    }
+}
+
+// 结束输出：等待输出线程写完剩余事件并退出，然后释放渲染状态
+void render_finish(RenderState* rs) {
+    if (rs == NULL) {
+        return;
+    }
+
+    // 最后的省略数量必须报出，此时等待输出线程腾出空间
+    while (flush_skipped(rs) != 0) {
+        sleep_ms(1);
+    }
+
+    atomic_store_explicit(&rs->closed, 1, memory_order_release);
+
+#ifdef _WIN32
+    WaitForSingleObject(rs->thread, INFINITE);
+    CloseHandle(rs->thread);
+#else
+    pthread_join(rs->thread, NULL);
+#endif
+
+    free(rs->recent);
+    free(rs->ring);
+    free(rs->frame);
+    free(rs);
+}
@@ -0,0 +1,92 @@
+#ifndef GACHA_RENDER_H
+#define GACHA_RENDER_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include "alphabet.h"
+#include "dictionary.h"
+#include "output.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+
+// 渲染事件类型
+#define RENDER_EVENT_LETTER 0    // 生成的字母
+#define RENDER_EVENT_MATCH 1     // 匹配成功（value 为字典序号，count 为匹配的字母数）
+#define RENDER_EVENT_SKIP 2      // 输出过慢被省略的事件（value 为字母数，count 为匹配数）
+#define RENDER_EVENT_SYMBOL 3    // 生成的自定义字母表字符（value 为字母表编号）
+
+// 渲染事件
+typedef struct {
+    int type;                // 事件类型（见 RENDER_EVENT_*）
+    int value;               // 字典序号或省略的字母数
+    int count;               // 省略的匹配数或匹配的字母数
+    char letter;             // 字母
+} RenderEvent;
+
+// 默认配置
+#define RENDER_RING_SIZE 65536   // 事件环容量（2 的幂）
+#define RENDER_FPS 60            // 最高刷新率（帧/秒）
+
+// 渲染状态
+//   生成线程（唯一生产者）写入事件环，输出线程（唯一消费者）按帧合并后写终端；
+//   事件环满时生产者不等待，只累计省略数量，稍后以一条 SKIP 事件补报
+typedef struct {
+    RenderEvent* ring;           // 事件环
+    unsigned int ring_mask;      // 事件环容量 - 1
+
+    // 生产者与消费者各自频繁写入的字段分开放在不同缓存行
+    char pad_producer[64];
+    atomic_uint tail;                // 生产者写入位置
+    unsigned int head_cache;         // 生产者缓存的消费位置
+    int skipped_letters;             // 尚未补报的省略字母数
+    int skipped_matches;             // 尚未补报的省略匹配数
+
+    char pad_consumer[64];
+    atomic_uint head;                // 消费者读取位置
+    atomic_int closed;               // 生产者已结束
+    char pad_shared[64];
+
+    const DictWord* dictionary;  // 字典（不持有，只读）
+    const Alphabet* alphabet;    // 自定义字母表（不持有，只读；NULL 表示不使用）
+    OutputState* os;             // 输出状态（不持有）
+
+    char* recent;                // 最近输出的字母（镜像，2 * recent_size，用于显示模式匹配到的原文）
+    int recent_size;             // 最近字母窗口大小
+    int recent_pos;              // 当前位置
+    int recent_len;              // 上次匹配或省略之后的字母数（不超过 recent_size）
+
+    char* frame;                 // 帧缓冲区
+    size_t frame_len;            // 帧缓冲区已用长度
+    size_t frame_capacity;       // 帧缓冲区容量
+
+#ifdef _WIN32
+    HANDLE thread;               // 输出线程
+#else
+    pthread_t thread;            // 输出线程
+#endif
+} RenderState;
+
+// 核心函数
+
+// 创建事件环并启动输出线程（window 为匹配缓冲区大小，即最长可显示的匹配原文）
+//   alphabet 非 NULL 时可提交字母表编号，由输出线程转换为 UTF-8
+RenderState* render_start(OutputState* os, const DictWord* dictionary, int window,
+                          const Alphabet* alphabet);
+
+// 提交生成的字母（不阻塞）
+void render_push_letter(RenderState* rs, char letter);
+
+// 提交生成的字母表编号（不阻塞）
+void render_push_symbol(RenderState* rs, int symbol);
+
+// 提交匹配事件（不阻塞），length 为匹配的字母数
+void render_push_match(RenderState* rs, int word_index, int length);
+
+// 结束输出：等待输出线程写完剩余事件并退出，然后释放渲染状态
+void render_finish(RenderState* rs);
+
+#endif // GACHA_RENDER_H
@@ -0,0 +1,467 @@
+#include "scan.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <pthread.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "alloc.h"
+
+// 一个分块的扫描任务
+typedef struct {
+    const Scanner* sc;
+    const unsigned char* warm;       // 预热起点（前一块末尾的最长单词长度，只推进状态不计数）
+    const unsigned char* start;      // 分块起点
+    const unsigned char* end;        // 分块终点
+    int start_row;                   // 预热后推测的起点状态（DFA 为行偏移，Trie 为节点）
+    int end_row;                     // 按推测起点扫描到终点的状态
+    long long* counts;               // 本块各单词匹配次数（按推测起点）
+
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+    int started;                     // 是否已启动线程
+} ScanChunk;
+
+// 解码 UTF-8 多字节字符，返回字节数，column 返回所在列（无效编码或字母表外的字符为重置列）
+static int decode_column(const Scanner* sc, const unsigned char* p, const unsigned char* end,
+                         unsigned int* column) {
+    uint32_t code_point;
+    int left = end - p < ALPHABET_MAX_BYTES ? (int)(end - p) : ALPHABET_MAX_BYTES;
+    int bytes = utf8_decode((const char*)p, left, &code_point);
+    int reset = sc->columns - 1;
+    if (bytes < 0) {
+        *column = (unsigned int)reset;
+        return 1;
+    }
+
+    int symbol = alphabet_symbol(sc->alphabet, code_point);
+    *column = symbol >= 0 ? (unsigned int)symbol : (unsigned int)reset;
+    return bytes;
+}
+
+// 接受状态胜出的模式序号
+static inline int accepted_word(const Scanner* sc, int row) {
+    return sc->accept[(row - sc->accept_from) / sc->columns];
+}
+
+// Trie 推进一个字节：word 返回匹配的单词序号（-1 表示没有），匹配后回到根（匹配不重叠）
+static inline int trie_step(const Datrie* trie, int state, unsigned char byte, int* word) {
+    int next = datrie_next(trie, state, byte);
+    *word = datrie_word(trie, next);
+    return *word >= 0 ? 0 : next;
+}
+
+// Trie 版本的 scan_range
+static int scan_range_trie(const Datrie* trie, const unsigned char* p, const unsigned char* end,
+                           int state, long long* counts) {
+    int word;
+    while (p < end) {
+        state = trie_step(trie, state, *p++, &word);
+        if (word >= 0 && counts != NULL) {
+            counts[word]++;
+        }
+    }
+    return state;
+}
+
+// 从状态 row 起扫描 [p, end)，返回结束状态；counts 为 NULL 时只推进状态（预热）
+static int scan_range(const Scanner* sc, const unsigned char* p, const unsigned char* end,
+                      int row, long long* counts) {
+    if (sc->trie != NULL) {
+        return scan_range_trie(sc->trie, p, end, row, counts);
+    }
+
+    const int* table = sc->table;
+    const uint16_t* byte_column = sc->byte_column;
+    int accept_from = sc->accept_from;
+
+    while (p < end) {
+        unsigned int column = byte_column[*p];
+        if (column == SCAN_DECODE) {
+            p += decode_column(sc, p, end, &column);
+        } else {
+            p++;
+        }
+
+        // 每个字符一次查表
+        row = table[row + (int)column];
+        if (row >= accept_from && counts != NULL) {
+            counts[accepted_word(sc, row)]++;
+        }
+    }
+    return row;
+}
+
+// 推测起点错误时的修正：从 p 起同时推进真实状态与推测状态，
+//   把推测扫描的匹配换成真实匹配，两者一旦相同后续就完全一致；返回真实的结束状态
+static int resync(const Scanner* sc, const unsigned char* p, const unsigned char* end,
+                  int truth, int guess, int guess_end, long long* counts) {
+    if (sc->trie != NULL) {
+        int word;
+        while (p < end && truth != guess) {
+            truth = trie_step(sc->trie, truth, *p, &word);
+            if (word >= 0) {
+                counts[word]++;
+            }
+            guess = trie_step(sc->trie, guess, *p, &word);
+            if (word >= 0) {
+                counts[word]--;
+            }
+            p++;
+        }
+        return truth == guess ? guess_end : truth;
+    }
+
+    while (p < end && truth != guess) {
+        unsigned int column = sc->byte_column[*p];
+        if (column == SCAN_DECODE) {
+            p += decode_column(sc, p, end, &column);
+        } else {
+            p++;
+        }
+
+        truth = sc->table[truth + (int)column];
+        if (truth >= sc->accept_from) {
+            counts[accepted_word(sc, truth)]++;
+        }
+        guess = sc->table[guess + (int)column];
+        if (guess >= sc->accept_from) {
+            counts[accepted_word(sc, guess)]--;
+        }
+    }
+    return truth == guess ? guess_end : truth;
+}
+
+// 扫描一个分块（预热 + 计数）
+static void scan_chunk(ScanChunk* chunk) {
+    long long trace_start_ns = trace_begin();
+    chunk->start_row = scan_range(chunk->sc, chunk->warm, chunk->start, 0, NULL);
+    chunk->end_row = scan_range(chunk->sc, chunk->start, chunk->end, chunk->start_row,
+                                chunk->counts);
+    trace_complete("scan_chunk", trace_start_ns, (long long)(chunk->end - chunk->start));
+}
+
+#ifdef _WIN32
+static DWORD WINAPI scan_thread_main(LPVOID arg) {
+    trace_thread_begin("scan");
+    scan_chunk((ScanChunk*)arg);
+    return 0;
+}
+#else
+static void* scan_thread_main(void* arg) {
+    trace_thread_begin("scan");
+    scan_chunk((ScanChunk*)arg);
+    return NULL;
+}
+#endif
+
+// 由匹配器创建扫描器
+Scanner* scanner_create(MatcherState* ms, const Alphabet* alphabet) {
+    if (ms == NULL) {
+        return NULL;
+    }
+
+    Scanner* sc = (Scanner*)malloc(sizeof(Scanner));
+    if (sc == NULL) {
+        return NULL;
+    }
+    memset(sc, 0, sizeof(Scanner));
+    sc->alphabet = alphabet;
+    sc->word_count = ms->dictionary_size;
+
+    // 大型纯字面字典没有 DFA，直接使用匹配器的 Trie（只收录不超过缓冲区大小的单词）
+    const PatternDfa* dfa = ms->dfa;
+    if (dfa == NULL) {
+        sc->trie = ms->trie;
+        sc->max_length = ms->max_word_length < ms->buffer_size ? ms->max_word_length : ms->buffer_size;
+        return sc;
+    }
+
+    int alphabet_size = dfa->alphabet_size;
+    sc->columns = alphabet_size + 1;
+    for (int i = 0; i < dfa->pattern_count; i++) {
+        if (dfa->lengths[i] > sc->max_length) {
+            sc->max_length = dfa->lengths[i];
+        }
+    }
+
+    // 重新编号：非接受状态在前（初始状态仍为 0，接受状态的转移与初始状态相同，初始状态不会是接受状态）
+    int* order = (int*)malloc((size_t)dfa->state_count * sizeof(int));
+    sc->table = (int*)malloc((size_t)dfa->state_count * sc->columns * sizeof(int));
+    sc->accept = (int*)malloc((size_t)dfa->state_count * sizeof(int));
+    if (order == NULL || sc->table == NULL || sc->accept == NULL) {
+        free(order);
+        scanner_free(sc);
+        return NULL;
+    }
+    int renumbered = 0;
+    for (int s = 0; s < dfa->state_count; s++) {
+        if (dfa->accept[s] < 0) {
+            order[s] = renumbered++;
+        }
+    }
+    sc->accept_from = renumbered * sc->columns;
+    for (int s = 0; s < dfa->state_count; s++) {
+        if (dfa->accept[s] >= 0) {
+            sc->accept[renumbered - sc->accept_from / sc->columns] = dfa->accept[s];
+            order[s] = renumbered++;
+        }
+    }
+
+    // 展开转移表（行偏移代替状态编号，省去热循环中的乘法）
+    for (int s = 0; s < dfa->state_count; s++) {
+        int* row = sc->table + (size_t)order[s] * sc->columns;
+        for (int c = 0; c < alphabet_size; c++) {
+            row[c] = order[dfa->next[(size_t)s * alphabet_size + c]] * sc->columns;
+        }
+        row[alphabet_size] = 0;
+    }
+    free(order);
+
+    // 字节 -> 列：默认字母表按 DFA 的字符表；自定义字母表中 ASCII 直接查表，多字节字符解码
+    int reset = alphabet_size;
+    for (int b = 0; b < 256; b++) {
+        if (alphabet == NULL) {
+            unsigned char symbol = dfa->symbol_of[b];
+            sc->byte_column[b] = (uint16_t)(symbol == PATTERN_NO_SYMBOL ? reset : symbol);
+        } else if (b < 0x80) {
+            int symbol = alphabet_symbol(alphabet, (uint32_t)b);
+            sc->byte_column[b] = (uint16_t)(symbol >= 0 ? symbol : reset);
+        } else {
+            sc->byte_column[b] = (uint16_t)(b >= 0xC0 ? SCAN_DECODE : reset);
+        }
+    }
+
+    return sc;
+}
+
+// 默认线程数
+int scan_default_threads() {
+    long cpus;
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    cpus = (long)info.dwNumberOfProcessors;
+#else
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (cpus < 1) {
+        return 1;
+    }
+    return cpus > SCAN_MAX_THREADS ? SCAN_MAX_THREADS : (int)cpus;
+}
+
+// 跳过 UTF-8 后续字节，返回字符起点
+static const unsigned char* char_start(const Scanner* sc, const unsigned char* p,
+                                       const unsigned char* end) {
+    if (sc->alphabet == NULL) {
+        return p;
+    }
+    while (p < end && (*p & 0xC0) == 0x80) {
+        p++;
+    }
+    return p;
+}
+
+// 扫描内存中的文本
+int scan_buffer(const Scanner* sc, const char* data, size_t size, int threads,
+                long long* counts, ScanStats* stats) {
+    if (sc == NULL || (data == NULL && size > 0) || counts == NULL || stats == NULL) {
+        return -1;
+    }
+
+    memset(stats, 0, sizeof(ScanStats));
+    stats->bytes = size;
+    stats->threads = 1;
+    if (size == 0) {
+        return 0;
+    }
+
+    const unsigned char* text = (const unsigned char*)data;
+
+    // 1. 分块：每块不少于 SCAN_MIN_CHUNK 字节，块边界对齐到字符起点
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (threads > SCAN_MAX_THREADS) {
+        threads = SCAN_MAX_THREADS;
+    }
+    if ((size_t)threads > size / SCAN_MIN_CHUNK) {
+        threads = size / SCAN_MIN_CHUNK > 0 ? (int)(size / SCAN_MIN_CHUNK) : 1;
+    }
+
+    ScanChunk* chunks = (ScanChunk*)calloc((size_t)threads, sizeof(ScanChunk));
+    long long* chunk_counts = (long long*)calloc((size_t)threads * sc->word_count, sizeof(long long));
+    if (chunks == NULL || chunk_counts == NULL) {
+        free(chunks);
+        free(chunk_counts);
+        return -1;
+    }
+
+    const unsigned char* end = text + size;
+    size_t warm_bytes = (size_t)sc->max_length * (sc->alphabet != NULL ? ALPHABET_MAX_BYTES : 1);
+    for (int k = 0; k < threads; k++) {
+        ScanChunk* chunk = &chunks[k];
+        chunk->sc = sc;
+        chunk->start = k == 0 ? text : chunks[k - 1].end;
+        chunk->end = k + 1 == threads ? end : char_start(sc, text + size / threads * (k + 1), end);
+        chunk->warm = (size_t)(chunk->start - text) > warm_bytes ? chunk->start - warm_bytes : text;
+        chunk->warm = char_start(sc, chunk->warm, chunk->start);
+        chunk->counts = chunk_counts + (size_t)k * sc->word_count;
+    }
+
+    // 2. 并行扫描（最后一块由当前线程扫描）
+    for (int k = 0; k + 1 < threads; k++) {
+#ifdef _WIN32
+        chunks[k].thread = CreateThread(NULL, 0, scan_thread_main, &chunks[k], 0, NULL);
+        chunks[k].started = chunks[k].thread != NULL;
+#else
+        chunks[k].started = pthread_create(&chunks[k].thread, NULL, scan_thread_main, &chunks[k]) == 0;
+#endif
+        if (!chunks[k].started) {
+            scan_chunk(&chunks[k]);
+        }
+    }
+    scan_chunk(&chunks[threads - 1]);
+    for (int k = 0; k + 1 < threads; k++) {
+        if (!chunks[k].started) {
+            continue;
+        }
+#ifdef _WIN32
+        WaitForSingleObject(chunks[k].thread, INFINITE);
+        CloseHandle(chunks[k].thread);
+#else
+        pthread_join(chunks[k].thread, NULL);
+#endif
+    }
+
+    // 3. 合并计数，并按顺序检查每块的推测起点（第一块从初始状态开始，总是正确）
+    int truth = 0;
+    for (int k = 0; k < threads; k++) {
+        ScanChunk* chunk = &chunks[k];
+        for (int i = 0; i < sc->word_count; i++) {
+            counts[i] += chunk->counts[i];
+            stats->matches += chunk->counts[i];
+        }
+
+        if (truth == chunk->start_row) {
+            truth = chunk->end_row;
+            continue;
+        }
+
+        // 修正前后的计数差额计入 matches
+        long long before = 0;
+        long long after = 0;
+        for (int i = 0; i < sc->word_count; i++) {
+            before += counts[i];
+        }
+        truth = resync(sc, chunk->start, chunk->end, truth, chunk->start_row, chunk->end_row, counts);
+        for (int i = 0; i < sc->word_count; i++) {
+            after += counts[i];
+        }
+        stats->matches += after - before;
+        stats->resyncs++;
+    }
+    stats->threads = threads;
+
+    free(chunks);
+    free(chunk_counts);
+    return 0;
+}
+
+// 映射文件并扫描
+int scan_file(const Scanner* sc, const char* path, int threads, long long* counts,
+              ScanStats* stats) {
+    if (sc == NULL || path == NULL) {
+        return -1;
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return -1;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return -1;
+    }
+    size_t size = (size_t)file_size.QuadPart;
+    if (size == 0) {
+        CloseHandle(file);
+        return scan_buffer(sc, NULL, 0, threads, counts, stats);
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) {
+        return -1;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (data == NULL) {
+        return -1;
+    }
+
+    int result = scan_buffer(sc, (const char*)data, size, threads, counts, stats);
+    UnmapViewOfFile(data);
+    return result;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return -1;
+    }
+
+    // 空文件没有可映射的内容
+    size_t size = (size_t)st.st_size;
+    if (size == 0) {
+        close(fd);
+        return scan_buffer(sc, NULL, 0, threads, counts, stats);
+    }
+
+    void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+
+#ifdef MADV_SEQUENTIAL
+    // 各线程顺序扫描自己的分块
+    madvise(data, size, MADV_SEQUENTIAL);
+#endif
+
+    int result = scan_buffer(sc, (const char*)data, size, threads, counts, stats);
+    munmap(data, size);
+    return result;
+#endif
+}
+
+// 释放扫描器
+void scanner_free(Scanner* sc) {
+    if (sc == NULL) {
+        return;
+    }
+
+    free(sc->table);
+    free(sc->accept);
+    free(sc);
+}
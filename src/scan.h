@@ -0,0 +1,61 @@
+#ifndef GACHA_SCAN_H
+#define GACHA_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "alphabet.h"
+#include "matcher.h"
+
+// 并行扫描参数
+#define SCAN_MAX_THREADS 64          // 线程数上限
+#define SCAN_MIN_CHUNK (1 << 20)     // 每块最少字节数（小文件不值得拆分）
+#define SCAN_DECODE 0xFFFF           // 字节列表中表示"UTF-8 多字节字符的首字节，需要解码"
+
+// 默认列出的匹配次数最多的单词数
+#define SCAN_TOP_WORDS 20
+
+// 扫描器（由匹配器的 DFA 展开，只读，多个线程共享）
+//   状态重新编号，接受状态排在最后：热循环只做一次查表，是否匹配只需比较行偏移，
+//   不在状态转移的依赖链上；每行 columns 列，前 alphabet_size 列为字母，最后一列为非字母（回到初始状态）
+//   没有 DFA 的大字典直接使用匹配器的双数组 Trie，状态为 Trie 节点，分块、预热与修正方式相同
+typedef struct {
+    int* table;                      // 展开的转移表（元素为目标状态的行偏移）
+    int* accept;                     // 各接受状态胜出的模式序号（按重新编号后的顺序）
+    int accept_from;                 // 第一个接受状态的行偏移
+    int columns;                     // 每行列数（字母表大小 + 1）
+    int max_length;                  // 最长模式的字符数（分块预热长度）
+    int word_count;                  // 字典单词数
+    uint16_t byte_column[256];       // 单字节 -> 列
+    const Alphabet* alphabet;        // 自定义字母表（NULL 表示 a-z A-Z）
+    const Datrie* trie;              // 没有 DFA 时的双数组 Trie（属于匹配器，只读）
+} Scanner;
+
+// 扫描统计
+typedef struct {
+    size_t bytes;                    // 扫描字节数
+    long long matches;               // 匹配次数
+    int threads;                     // 实际使用的线程数
+    int resyncs;                     // 分块起点状态推测错误、顺序修正的次数
+} ScanStats;
+
+// 核心函数
+
+// 由匹配器创建扫描器（匹配器须由 matcher_init / matcher_init_symbols 创建，扫描器不持有）
+Scanner* scanner_create(MatcherState* ms, const Alphabet* alphabet);
+
+// 默认线程数（在线 CPU 数，不超过 SCAN_MAX_THREADS）
+int scan_default_threads();
+
+// 扫描内存中的文本，各单词的匹配次数累加到 counts（与 chaos 模式相同的匹配规则，
+//   非字母字符回到初始状态，文本开头从初始状态开始），失败返回 -1
+int scan_buffer(const Scanner* sc, const char* data, size_t size, int threads,
+                long long* counts, ScanStats* stats);
+
+// 映射文件并扫描，失败返回 -1
+int scan_file(const Scanner* sc, const char* path, int threads, long long* counts,
+              ScanStats* stats);
+
+// 释放扫描器
+void scanner_free(Scanner* sc);
+
+#endif // GACHA_SCAN_H
@@ -0,0 +1,174 @@
+#include "trace.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#endif
+
+#ifdef _MSC_VER
+    #define TRACE_THREAD_LOCAL __declspec(thread)
+#else
+    #define TRACE_THREAD_LOCAL _Thread_local
+#endif
+
+#include "alloc.h"
+
+#define NS_PER_SECOND 1000000000LL
+
+// 单个线程的事件环（只由所属线程写入，退出时由主线程读取）
+typedef struct {
+    const char* thread_name;   // 线程名
+    long long written;         // 累计写入的事件数（超过容量后覆盖最早的事件）
+    TraceEvent* events;        // 事件环
+} TraceRing;
+
+int trace_enabled = 0;
+
+static FILE* trace_file = NULL;
+static char* trace_path = NULL;
+static long long trace_origin_ns = 0;
+static TraceRing rings[TRACE_MAX_THREADS];
+static atomic_int ring_count;
+static TRACE_THREAD_LOCAL TraceRing* local_ring = NULL;
+
+// 读取单调时钟（纳秒）
+long long trace_now() {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (long long)(counter.QuadPart / frequency.QuadPart) * NS_PER_SECOND +
+           (long long)(counter.QuadPart % frequency.QuadPart) * NS_PER_SECOND / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * NS_PER_SECOND + ts.tv_nsec;
+#endif
+}
+
+// 为当前线程分配事件环
+void trace_thread_begin(const char* name) {
+    if (!trace_enabled || local_ring != NULL) {
+        return;
+    }
+
+    int slot = atomic_fetch_add(&ring_count, 1);
+    if (slot >= TRACE_MAX_THREADS) {
+        return;
+    }
+
+    TraceEvent* events = (TraceEvent*)malloc(sizeof(TraceEvent) * TRACE_RING_CAPACITY);
+    if (events == NULL) {
+        return;
+    }
+
+    rings[slot].thread_name = name;
+    rings[slot].written = 0;
+    rings[slot].events = events;
+    local_ring = &rings[slot];
+}
+
+// 启用跟踪
+int trace_start(const char* path) {
+    if (path == NULL || path[0] == '\0' || trace_enabled) {
+        return -1;
+    }
+
+    trace_file = fopen(path, "w");
+    if (trace_file == NULL) {
+        return -1;
+    }
+    trace_path = strdup(path);
+
+    trace_enabled = 1;
+    trace_origin_ns = trace_now();
+    trace_thread_begin("main");
+    return 0;
+}
+
+// 记录区间事件
+void trace_complete(const char* name, long long start_ns, long long value) {
+    TraceRing* ring = local_ring;
+    if (start_ns == 0 || ring == NULL || !trace_enabled) {
+        return;
+    }
+
+    TraceEvent* event = &ring->events[ring->written & (TRACE_RING_CAPACITY - 1)];
+    event->name = name;
+    event->start_ns = start_ns;
+    event->duration_ns = trace_now() - start_ns;
+    event->value = value;
+    ring->written++;
+}
+
+// 写出全部事件
+int trace_finish() {
+    if (!trace_enabled) {
+        return 0;
+    }
+    trace_enabled = 0;
+
+    FILE* fp = trace_file;
+    int threads = atomic_load(&ring_count);
+    long long dropped = 0;
+    int untraced = 0;
+
+    // 超出线程上限的线程没有事件环，数量记录在 untraced_threads
+    if (threads > TRACE_MAX_THREADS) {
+        untraced = threads - TRACE_MAX_THREADS;
+        threads = TRACE_MAX_THREADS;
+    }
+
+    fprintf(fp, "{\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+                "\"args\":{\"name\":\"gacha\"}}");
+    for (int t = 0; t < threads; t++) {
+        TraceRing* ring = &rings[t];
+        if (ring->events == NULL) {
+            continue;
+        }
+
+        fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                    "\"args\":{\"name\":\"%s\"}}", t + 1, ring->thread_name);
+
+        // 环写满后从最早仍保留的事件开始输出
+        long long begin = 0;
+        if (ring->written > TRACE_RING_CAPACITY) {
+            begin = ring->written - TRACE_RING_CAPACITY;
+            dropped += begin;
+        }
+        for (long long i = begin; i < ring->written; i++) {
+            const TraceEvent* event = &ring->events[i & (TRACE_RING_CAPACITY - 1)];
+            fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"gacha\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                        "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"n\":%lld}}",
+                    event->name, t + 1, (event->start_ns - trace_origin_ns) / 1000.0,
+                    event->duration_ns / 1000.0, event->value);
+        }
+    }
+    fprintf(fp, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":%lld,"
+                "\"untraced_threads\":%d}}\n", dropped, untraced);
+
+    int result = ferror(fp) ? -1 : 0;
+    if (fclose(fp) != 0) {
+        result = -1;
+    }
+    if (result != 0) {
+        fprintf(stderr, "警告: 无法写入跟踪文件 %s\n", trace_path != NULL ? trace_path : "");
+    }
+
+    for (int t = 0; t < threads; t++) {
+        free(rings[t].events);
+        rings[t].events = NULL;
+    }
+    free(trace_path);
+    trace_file = NULL;
+    trace_path = NULL;
+    return result;
+}
@@ -0,0 +1,52 @@
+#ifndef GACHA_TRACE_H
+#define GACHA_TRACE_H
+
+// 每个线程的事件环容量（写满后覆盖最早的事件）
+#define TRACE_RING_CAPACITY (1 << 16)
+// 最多记录的线程数
+#define TRACE_MAX_THREADS 8
+// 热循环采样间隔（每隔多少次迭代记录一次）
+#define TRACE_SAMPLE_INTERVAL 64
+
+// 区间事件（Chrome trace 的 "ph": "X"）
+typedef struct {
+    const char* name;          // 事件名（须为字符串常量，退出时才读取）
+    long long start_ns;        // 开始时间（单调时钟）
+    long long duration_ns;     // 持续时间
+    long long value;           // 附加参数（args.n）
+} TraceEvent;
+
+// 是否已启用跟踪（trace_start 之后、启动其他线程之前设置）
+extern int trace_enabled;
+
+// 核心函数
+
+// 启用跟踪，退出时写出到 path（无法创建文件时返回 -1）
+int trace_start(const char* path);
+
+// 为当前线程分配事件环并命名（线程开始时调用，之后记录事件不再分配内存）
+void trace_thread_begin(const char* name);
+
+// 读取单调时钟（纳秒）
+long long trace_now();
+
+// 记录从 start_ns 到现在的区间事件（start_ns 为 0 时忽略）
+void trace_complete(const char* name, long long start_ns, long long value);
+
+// 写出全部线程的事件（Chrome / Perfetto JSON）并释放事件环，失败返回 -1
+int trace_finish();
+
+// 区间开始时间（未启用跟踪时为 0）
+static inline long long trace_begin() {
+    return trace_enabled ? trace_now() : 0;
+}
+
+// 采样的区间开始时间：每 TRACE_SAMPLE_INTERVAL 次调用返回一次当前时间，其余为 0
+static inline long long trace_sample(unsigned int* counter) {
+    if (!trace_enabled || (*counter)++ % TRACE_SAMPLE_INTERVAL != 0) {
+        return 0;
+    }
+    return trace_now();
+}
+
+#endif // GACHA_TRACE_H
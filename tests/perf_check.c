@@ -0,0 +1,580 @@
+// 性能回归检查
+//   以固定种子运行 chaos 匹配流、百万行 gachalist 加载与 10^7 次批量抽卡，
+//   与 tests/perf_baseline.json 中的吞吐量和内存峰值比较，超出阈值时返回非零（由 CTest 运行）
+//   吞吐量除以同一进程内、紧接每次运行计时的校准循环速度，记录的是相对值，不随机器快慢变化
+//
+//   perf_check <基线文件>
+//   环境变量：GACHA_PERF_THRESHOLD     覆盖基线文件中的阈值（0.5 表示允许慢一半 / 多用一半内存）
+//            GACHA_PERF_THROUGHPUT=0  不比较吞吐量（只输出）
+//            GACHA_PERF_UPDATE=1      用本次结果重写基线文件（不做比较）
+
+#include "random.h"
+#include "matcher.h"
+#include "gacha.h"
+#include "list.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <sys/resource.h>
+#endif
+
+#include "alloc.h"
+
+// 默认配置
+#define PERF_SEED 20240601u             // 所有负载的固定种子
+#define PERF_REPEATS 3                  // 吞吐量取多次运行中最快的一次
+#define PERF_THRESHOLD 0.5              // 基线文件未指定阈值时的默认值
+#define PERF_CHAOS_LETTERS 4000000      // 每个字典的 chaos 匹配流字母数
+#define PERF_LIST_LINES 1000000         // 合成 gachalist 行数
+#define PERF_LIST_NAMES 50000           // 合成 gachalist 不同菜名数
+#define PERF_DRAWS 10000000             // 批量抽卡次数
+#define PERF_LITERAL_WORDS 2000         // 字面字典单词数（编译为 DFA）
+#define PERF_LARGE_WORDS 200000         // 大字典单词数（超出 DFA 规模，走双数组 Trie）
+#define PERF_PATTERNS 200               // 通配符字典模式数（忽略大小写）
+#define PERF_CALIBRATION_STEPS 10000000 // 每次校准循环的步数
+#define PERF_CALIBRATION_TABLE 65536    // 校准循环的查表项数（256 KiB）
+#define LIST_FILE "perf_check_gachalist.txt"
+#define INDEX_FILE "perf_check_dictionary.dat"
+
+// 指标方向
+#define METRIC_THROUGHPUT 0             // 越大越好，低于基线 * (1 - 阈值) 视为回归
+#define METRIC_MEMORY 1                 // 越小越好，高于基线 * (1 + 阈值) 视为回归
+
+// 非 Release 与 sanitizer 构建的吞吐量和常驻集没有可比性（CMake 检测到 -fsanitize 时定义 GACHA_PERF_SANITIZED）
+#if !defined(NDEBUG) || defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+    #define PERF_RELEASE_ONLY_SKIPPED 1
+#elif defined(GACHA_PERF_SANITIZED)
+    #define PERF_RELEASE_ONLY_SKIPPED 1
+#elif defined(__has_feature)
+    #if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || __has_feature(memory_sanitizer)
+        #define PERF_RELEASE_ONLY_SKIPPED 1
+    #endif
+#endif
+#ifndef PERF_RELEASE_ONLY_SKIPPED
+    #define PERF_RELEASE_ONLY_SKIPPED 0
+#endif
+
+// 指标
+typedef struct {
+    const char* name;
+    int kind;
+    int decimals;                       // 输出与写入基线时的小数位数
+    int needs_tracking;                 // 是否需要以 GACHA_TRACK_ALLOC 构建才能测量
+    int release_only;                   // 是否只在 Release（非 sanitizer）构建中比较
+    double value;                       // 本次结果（< 0 表示未测量）
+    double baseline;                    // 基线（< 0 表示基线中没有）
+} PerfMetric;
+
+static PerfMetric metrics[] = {
+    // 吞吐量：每个校准步对应的处理量（字母、行或次数）
+    {"chaos_literal_speed", METRIC_THROUGHPUT, 4, 0, 1, -1.0, -1.0},
+    {"chaos_large_speed", METRIC_THROUGHPUT, 4, 0, 1, -1.0, -1.0},
+    {"chaos_pattern_speed", METRIC_THROUGHPUT, 4, 0, 1, -1.0, -1.0},
+    {"load_speed", METRIC_THROUGHPUT, 4, 0, 1, -1.0, -1.0},
+    {"draw_speed", METRIC_THROUGHPUT, 4, 0, 1, -1.0, -1.0},
+    {"index_bytes_per_char", METRIC_MEMORY, 2, 0, 0, -1.0, -1.0},
+    {"chaos_peak_heap_bytes", METRIC_MEMORY, 0, 1, 0, -1.0, -1.0},
+    {"index_build_peak_heap_bytes", METRIC_MEMORY, 0, 1, 0, -1.0, -1.0},
+    {"load_peak_heap_bytes", METRIC_MEMORY, 0, 1, 0, -1.0, -1.0},
+    {"draw_peak_heap_bytes", METRIC_MEMORY, 0, 1, 0, -1.0, -1.0},
+    {"peak_rss_bytes", METRIC_MEMORY, 0, 0, 1, -1.0, -1.0},
+};
+
+#define METRIC_COUNT ((int)(sizeof(metrics) / sizeof(metrics[0])))
+
+static PerfMetric* find_metric(const char* name) {
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        if (strcmp(metrics[i].name, name) == 0) {
+            return &metrics[i];
+        }
+    }
+    return NULL;
+}
+
+// 每秒处理量
+static double per_second(long long count, long long elapsed_ns) {
+    return elapsed_ns > 0 ? (double)count * 1e9 / (double)elapsed_ns : 0.0;
+}
+
+// 校准循环的查表（静态数组，不计入堆峰值）
+static uint32_t calibration_table[PERF_CALIBRATION_TABLE];
+
+// 初始化校准查表
+static void calibration_init() {
+    for (uint32_t i = 0; i < PERF_CALIBRATION_TABLE; i++) {
+        calibration_table[i] = (i + PERF_SEED) * 2654435761u;
+    }
+}
+
+// 计时一次校准循环：依赖链上的查表与整数运算（与匹配器、抽卡的热循环同类），返回每秒步数
+static double calibration_rate() {
+    volatile uint32_t sink;
+    uint32_t x = PERF_SEED;
+    long long start_ns = trace_now();
+    for (uint32_t n = 0; n < PERF_CALIBRATION_STEPS; n++) {
+        x = calibration_table[x & (PERF_CALIBRATION_TABLE - 1)] ^ (x >> 7) ^ n;
+    }
+    long long elapsed_ns = trace_now() - start_ns;
+    sink = x;
+    (void)sink;
+    return per_second(PERF_CALIBRATION_STEPS, elapsed_ns);
+}
+
+// 吞吐量（取多次运行中最快的一次）
+typedef struct {
+    double absolute;                    // 每秒处理量
+    double relative;                    // 每个校准步的处理量（校准循环紧接在每次运行之后计时）
+} Throughput;
+
+// 记录一次运行
+static void record_run(Throughput* throughput, long long count, long long elapsed_ns) {
+    double rate = per_second(count, elapsed_ns);
+    double calibration = calibration_rate();
+    double relative = calibration > 0.0 ? rate / calibration : 0.0;
+    if (rate > throughput->absolute) {
+        throughput->absolute = rate;
+    }
+    if (relative > throughput->relative) {
+        throughput->relative = relative;
+    }
+}
+
+// 阶段内的堆峰值（未启用分配统计时为 -1）
+static double phase_peak(int phase) {
+    if (!alloc_tracking_enabled()) {
+        return -1.0;
+    }
+    AllocPhaseStats phases[ALLOC_PHASE_COUNT];
+    long long live_bytes, live_blocks, peak_bytes;
+    alloc_get_stats(phases, &live_bytes, &live_blocks, &peak_bytes);
+    return (double)phases[phase].peak_live;
+}
+
+// ---------- 基线文件 ----------
+
+// 读取基线（扁平 JSON 对象："名称": 数值），返回阈值；文件不存在时返回 -1
+static double read_baseline(const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return -1.0;
+    }
+
+    char text[4096];
+    size_t length = fread(text, 1, sizeof(text) - 1, fp);
+    fclose(fp);
+    text[length] = '\0';
+
+    double threshold = PERF_THRESHOLD;
+    const char* p = text;
+    while ((p = strchr(p, '"')) != NULL) {
+        const char* name = p + 1;
+        const char* end = strchr(name, '"');
+        if (end == NULL) {
+            break;
+        }
+        const char* colon = end + 1;
+        while (*colon == ' ' || *colon == '\t') {
+            colon++;
+        }
+        p = end + 1;
+        if (*colon != ':') {
+            continue;
+        }
+
+        char key[64];
+        size_t key_length = (size_t)(end - name);
+        if (key_length >= sizeof(key)) {
+            continue;
+        }
+        memcpy(key, name, key_length);
+        key[key_length] = '\0';
+
+        char* number_end;
+        double value = strtod(colon + 1, &number_end);
+        if (number_end == colon + 1) {
+            continue;
+        }
+        if (strcmp(key, "threshold") == 0) {
+            threshold = value;
+        } else {
+            PerfMetric* metric = find_metric(key);
+            if (metric != NULL) {
+                metric->baseline = value;
+            }
+        }
+        p = number_end;
+    }
+
+    return threshold;
+}
+
+// 写出基线（本次未测量、或本构建不比较的指标沿用旧基线）
+static int write_baseline(const char* path, double threshold) {
+    FILE* fp = fopen(path, "wb");
+    if (fp == NULL) {
+        return -1;
+    }
+
+    fprintf(fp, "{\n  \"threshold\": %.2f", threshold);
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        int measured = metrics[i].value >= 0.0 && !(metrics[i].release_only && PERF_RELEASE_ONLY_SKIPPED);
+        double value = measured ? metrics[i].value : metrics[i].baseline;
+        if (value >= 0.0) {
+            fprintf(fp, ",\n  \"%s\": %.*f", metrics[i].name, metrics[i].decimals, value);
+        }
+    }
+    fprintf(fp, "\n}\n");
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+// ---------- chaos 匹配流 ----------
+
+// 生成 count 个随机单词（长度 [min_length, max_length]），letters 为可选字符，返回单词文本块
+static char* make_words(RandomGenerator* rg, DictWord* words, int count, int min_length,
+                        int max_length, const char* letters) {
+    int letter_count = (int)strlen(letters);
+    char* text = (char*)malloc((size_t)count * (size_t)max_length);
+    if (text == NULL) {
+        return NULL;
+    }
+
+    for (int i = 0; i < count; i++) {
+        char* word = text + (size_t)i * max_length;
+        int length = min_length + (int)random_bounded(rg, (uint32_t)(max_length - min_length + 1));
+        for (int k = 0; k < length; k++) {
+            word[k] = letters[random_bounded(rg, (uint32_t)letter_count)];
+        }
+        words[i].text = word;
+        words[i].length = length;
+    }
+    return text;
+}
+
+// 生成 count 个模式：每个模式有一个位置是通配符 ? 或字符类 [aeiou]（每个模式预留 16 字节）
+static char* make_patterns(RandomGenerator* rg, DictWord* words, int count) {
+    char* text = (char*)malloc((size_t)count * 16);
+    if (text == NULL) {
+        return NULL;
+    }
+
+    for (int i = 0; i < count; i++) {
+        char* word = text + (size_t)i * 16;
+        int length = 3 + (int)random_bounded(rg, 4);
+        int wildcard = (int)random_bounded(rg, (uint32_t)length);
+        int position = 0;
+        for (int k = 0; k < length; k++) {
+            if (k == wildcard && (i & 1)) {
+                word[position++] = '?';
+            } else if (k == wildcard) {
+                memcpy(word + position, "[aeiou]", 7);
+                position += 7;
+            } else {
+                word[position++] = CHARSET[random_bounded(rg, 26)];
+            }
+        }
+        words[i].text = word;
+        words[i].length = position;
+    }
+    return text;
+}
+
+// 按 chaos 模式的方式逐个生成字母并匹配，返回字母吞吐量（匹配次数写入 matches）
+//   与 chaos 模式相同，匹配器在字典索引阶段编译，index_path 非 NULL 时映射大字典的 Trie 索引文件
+static Throughput chaos_stream(const DictWord* words, int count, int ignore_case, const char* index_path,
+                               long long* matches) {
+    Throughput throughput = {0.0, 0.0};
+    for (int run = 0; run < PERF_REPEATS; run++) {
+        RandomGenerator* rg = random_generator_init();
+        alloc_set_phase(ALLOC_PHASE_INDEX);
+        MatcherState* ms = matcher_init(words, count, 0, ignore_case, index_path, 0);
+        alloc_set_phase(ALLOC_PHASE_CHAOS);
+        if (rg == NULL || ms == NULL) {
+            random_generator_free(rg);
+            matcher_free(ms);
+            return throughput;
+        }
+        random_generator_seed(rg, PERF_SEED);
+
+        long long found = 0;
+        long long start_ns = trace_now();
+        for (int n = 0; n < PERF_CHAOS_LETTERS; n++) {
+            found += matcher_process_letter(ms, generate_random_letter(rg)) >= 0;
+        }
+        record_run(&throughput, PERF_CHAOS_LETTERS, trace_now() - start_ns);
+        *matches = found;
+
+        matcher_free(ms);
+        random_generator_free(rg);
+    }
+    return throughput;
+}
+
+static int test_chaos() {
+    RandomGenerator* rg = random_generator_init();
+    DictWord* literal = (DictWord*)malloc(PERF_LITERAL_WORDS * sizeof(DictWord));
+    DictWord* large = (DictWord*)malloc(PERF_LARGE_WORDS * sizeof(DictWord));
+    DictWord* patterns = (DictWord*)malloc(PERF_PATTERNS * sizeof(DictWord));
+    char* literal_text = NULL;
+    char* large_text = NULL;
+    char* pattern_text = NULL;
+    if (rg != NULL && literal != NULL && large != NULL && patterns != NULL) {
+        random_generator_seed(rg, PERF_SEED);
+        literal_text = make_words(rg, literal, PERF_LITERAL_WORDS, 3, 6, CHARSET);
+        large_text = make_words(rg, large, PERF_LARGE_WORDS, 4, 10, "abcdefghijklmnopqrstuvwxyz");
+        pattern_text = make_patterns(rg, patterns, PERF_PATTERNS);
+    }
+
+    int ok = literal_text != NULL && large_text != NULL && pattern_text != NULL;
+    if (ok) {
+        long long matches;
+        Throughput throughput = chaos_stream(literal, PERF_LITERAL_WORDS, 0, NULL, &matches);
+        find_metric("chaos_literal_speed")->value = throughput.relative;
+        printf("chaos 字面字典（%d 个单词）：%.0f 字母/秒，%lld 次匹配\n",
+               PERF_LITERAL_WORDS, throughput.absolute, matches);
+
+        // 先构建并保存索引（只计入字典索引阶段），计时的运行与 chaos 模式之后的启动一样映射索引文件
+        remove(INDEX_FILE);
+        alloc_set_phase(ALLOC_PHASE_INDEX);
+        MatcherState* ms = matcher_init(large, PERF_LARGE_WORDS, 0, 0, INDEX_FILE, 0);
+        if (ms != NULL && ms->trie != NULL) {
+            // 索引大小（文件头与全部数组）按字典字符数平均
+            long long chars = 0;
+            for (int i = 0; i < PERF_LARGE_WORDS; i++) {
+                chars += large[i].length;
+            }
+            size_t bytes = sizeof(DatrieHeader) +
+                           datrie_body_size((size_t)ms->trie->unit_count, (size_t)ms->trie->terminal_count);
+            find_metric("index_bytes_per_char")->value = (double)bytes / (double)chars;
+            printf("大字典索引：%d 个状态单元，%d 个有输出的状态，%zu 字节，每个字典字符 %.2f 字节\n",
+                   ms->trie->unit_count, ms->trie->terminal_count, bytes, (double)bytes / (double)chars);
+        }
+        matcher_free(ms);
+        alloc_set_phase(ALLOC_PHASE_CHAOS);
+        throughput = chaos_stream(large, PERF_LARGE_WORDS, 0, INDEX_FILE, &matches);
+        find_metric("chaos_large_speed")->value = throughput.relative;
+        remove(INDEX_FILE);
+        printf("chaos 大字典（%d 个单词）：%.0f 字母/秒，%lld 次匹配\n",
+               PERF_LARGE_WORDS, throughput.absolute, matches);
+
+        throughput = chaos_stream(patterns, PERF_PATTERNS, 1, NULL, &matches);
+        find_metric("chaos_pattern_speed")->value = throughput.relative;
+        printf("chaos 通配符字典（%d 个模式，忽略大小写）：%.0f 字母/秒，%lld 次匹配\n",
+               PERF_PATTERNS, throughput.absolute, matches);
+    }
+
+    free(literal_text);
+    free(large_text);
+    free(pattern_text);
+    free(literal);
+    free(large);
+    free(patterns);
+    random_generator_free(rg);
+    return ok ? 0 : -1;
+}
+
+// ---------- gachalist 加载 ----------
+
+// 写出合成 gachalist（各等级行数比例与内置列表相近，菜名有重复）
+static int write_list(const char* path) {
+    static const char* ranks[RANK_COUNT] = {"N", "R", "SR", "SSR", "UR"};
+    static const int weights[RANK_COUNT] = {40, 30, 18, 9, 3};
+
+    FILE* fp = fopen(path, "wb");
+    RandomGenerator* rg = random_generator_init();
+    if (fp == NULL || rg == NULL) {
+        if (fp != NULL) {
+            fclose(fp);
+        }
+        random_generator_free(rg);
+        return -1;
+    }
+    random_generator_seed(rg, PERF_SEED + 1u);
+
+    for (int i = 0; i < PERF_LIST_LINES; i++) {
+        int roll = (int)random_bounded(rg, 100);
+        int rank = 0;
+        while (roll >= weights[rank]) {
+            roll -= weights[rank];
+            rank++;
+        }
+        fprintf(fp, "【%s】测试菜品%u\n", ranks[rank], random_bounded(rg, PERF_LIST_NAMES));
+    }
+
+    random_generator_free(rg);
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+static int test_load() {
+    if (write_list(LIST_FILE) != 0) {
+        return -1;
+    }
+
+    Throughput throughput = {0.0, 0.0};
+    for (int run = 0; run < PERF_REPEATS; run++) {
+        long long start_ns = trace_now();
+        GachaList* list = read_gachalist(LIST_FILE);
+        long long elapsed_ns = trace_now() - start_ns;
+        if (list == NULL || list->size != PERF_LIST_LINES) {
+            free_gachalist(list);
+            return -1;
+        }
+        free_gachalist(list);
+        record_run(&throughput, PERF_LIST_LINES, elapsed_ns);
+    }
+
+    find_metric("load_speed")->value = throughput.relative;
+    printf("gachalist 加载（%d 行）：%.0f 行/秒\n", PERF_LIST_LINES, throughput.absolute);
+    return 0;
+}
+
+// ---------- 批量抽卡 ----------
+
+static int test_draws() {
+    GachaState* state = gacha_init(LIST_FILE, PERF_DRAWS);
+    uint32_t* indices = (uint32_t*)malloc((size_t)PERF_DRAWS * sizeof(uint32_t));
+    if (state == NULL || indices == NULL) {
+        gacha_free(state);
+        free(indices);
+        return -1;
+    }
+
+    Throughput throughput = {0.0, 0.0};
+    for (int run = 0; run < PERF_REPEATS; run++) {
+        state->balance = PERF_DRAWS;
+        random_generator_seed(state->rng, PERF_SEED + 2u + (unsigned int)run);
+        long long start_ns = trace_now();
+        int drawn = gacha_draw_batch(state, PERF_DRAWS, indices);
+        long long elapsed_ns = trace_now() - start_ns;
+        if (drawn != PERF_DRAWS) {
+            throughput.relative = 0.0;
+            break;
+        }
+        record_run(&throughput, drawn, elapsed_ns);
+    }
+
+    gacha_free(state);
+    free(indices);
+    find_metric("draw_speed")->value = throughput.relative;
+    printf("批量抽卡（%d 次，%d 行 gachalist）：%.0f 次/秒\n", PERF_DRAWS, PERF_LIST_LINES, throughput.absolute);
+    return throughput.relative > 0.0 ? 0 : -1;
+}
+
+// 进程内存峰值（常驻集，含映射的文件页）
+static double peak_rss() {
+#ifdef _WIN32
+    return -1.0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1.0;
+    }
+    #ifdef __APPLE__
+    return (double)usage.ru_maxrss;
+    #else
+    return (double)usage.ru_maxrss * 1024.0;
+    #endif
+#endif
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "用法：perf_check <基线文件>\n");
+        return 1;
+    }
+    const char* baseline_path = argv[1];
+
+    double threshold = read_baseline(baseline_path);
+    int have_baseline = threshold >= 0.0;
+    if (!have_baseline) {
+        threshold = PERF_THRESHOLD;
+    }
+    const char* env = getenv("GACHA_PERF_THRESHOLD");
+    if (env != NULL && atof(env) > 0.0) {
+        threshold = atof(env);
+    }
+    env = getenv("GACHA_PERF_UPDATE");
+    int update = env != NULL && strcmp(env, "1") == 0;
+    env = getenv("GACHA_PERF_THROUGHPUT");
+    int check_throughput = env == NULL || strcmp(env, "0") != 0;
+
+    // 1. 运行各负载（每个负载单独一个分配统计阶段）
+    calibration_init();
+    int failed = 0;
+    alloc_set_phase(ALLOC_PHASE_CHAOS);
+    if (test_chaos() != 0) {
+        fprintf(stderr, "错误: chaos 匹配流负载失败\n");
+        failed = 1;
+    }
+    alloc_set_phase(ALLOC_PHASE_LIST);
+    if (!failed && test_load() != 0) {
+        fprintf(stderr, "错误: gachalist 加载负载失败\n");
+        failed = 1;
+    }
+    alloc_set_phase(ALLOC_PHASE_DRAW);
+    if (!failed && test_draws() != 0) {
+        fprintf(stderr, "错误: 批量抽卡负载失败\n");
+        failed = 1;
+    }
+    alloc_set_phase(ALLOC_PHASE_OTHER);
+    remove(LIST_FILE);
+    if (failed) {
+        return 1;
+    }
+
+    find_metric("chaos_peak_heap_bytes")->value = phase_peak(ALLOC_PHASE_CHAOS);
+    find_metric("index_build_peak_heap_bytes")->value = phase_peak(ALLOC_PHASE_INDEX);
+    find_metric("load_peak_heap_bytes")->value = phase_peak(ALLOC_PHASE_LIST);
+    find_metric("draw_peak_heap_bytes")->value = phase_peak(ALLOC_PHASE_DRAW);
+    find_metric("peak_rss_bytes")->value = peak_rss();
+
+    // 2. 重写基线
+    if (update) {
+        if (write_baseline(baseline_path, threshold) != 0) {
+            fprintf(stderr, "错误: 无法写入基线文件 %s\n", baseline_path);
+            return 1;
+        }
+        printf("\n已更新基线 %s\n", baseline_path);
+        return 0;
+    }
+
+    // 3. 与基线比较
+    printf("\n与基线比较（阈值 %.0f%%）：\n", threshold * 100.0);
+    int regressions = 0;
+    for (int i = 0; i < METRIC_COUNT; i++) {
+        const PerfMetric* metric = &metrics[i];
+        if (metric->value < 0.0 || metric->baseline <= 0.0) {
+            printf("  %-32s 跳过（%s）\n", metric->name,
+                   metric->value < 0.0 ? (metric->needs_tracking ? "需以 GACHA_TRACK_ALLOC 构建" : "本平台不支持")
+                                       : "基线中没有");
+            continue;
+        }
+        const char* skipped = NULL;
+        if (metric->release_only && PERF_RELEASE_ONLY_SKIPPED) {
+            skipped = "非 Release 或 sanitizer 构建";
+        } else if (metric->kind == METRIC_THROUGHPUT && !check_throughput) {
+            skipped = "GACHA_PERF_THROUGHPUT=0";
+        }
+        if (skipped != NULL) {
+            printf("  %-32s %14.*f  基线 %14.*f  %6.1f%%  不比较（%s）\n",
+                   metric->name, metric->decimals, metric->value, metric->decimals, metric->baseline,
+                   metric->value / metric->baseline * 100.0, skipped);
+            continue;
+        }
+
+        double ratio = metric->value / metric->baseline;
+        int regressed = metric->kind == METRIC_THROUGHPUT ? ratio < 1.0 - threshold
+                                                          : ratio > 1.0 + threshold;
+        printf("  %-32s %14.*f  基线 %14.*f  %6.1f%%  %s\n", metric->name, metric->decimals, metric->value,
+               metric->decimals, metric->baseline, ratio * 100.0, regressed ? "回归" : "通过");
+        regressions += regressed;
+    }
+
+    if (!have_baseline) {
+        printf("\n基线文件 %s 不存在（设置 GACHA_PERF_UPDATE=1 生成）\n", baseline_path);
+    }
+    printf("\n%s（%d 项回归）\n", regressions == 0 ? "全部通过" : "存在回归", regressions);
+    return regressions == 0 ? 0 : 1;
+}
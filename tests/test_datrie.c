@@ -0,0 +1,229 @@
+// 双数组 Trie 索引测试
+//   构建大字典的 Trie 并保存为索引文件，再按来源标识与内容指纹重新映射，
+//   在固定种子的字母流上与逐位置暴力查找的参考实现比较各单词的匹配次数（由 CTest 运行）
+
+#include "matcher.h"
+#include "random.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 默认配置
+#define DATRIE_TEST_SEED 20240601u      // 字典与字母流的种子
+#define DATRIE_TEST_WORDS 16000         // 随机单词数（总长超过 DFA 上限，走 Trie）
+#define DATRIE_TEST_MAX_LENGTH 8        // 随机单词的最大长度
+#define DATRIE_TEST_WINDOW 6            // 匹配窗口（更长的单词不会匹配）
+#define DATRIE_TEST_LETTERS 400000      // 字母流长度
+#define DATRIE_TEST_SOURCE 0x5eedull    // 测试用来源标识
+#define DATRIE_TEST_LETTERS_SET "aehrsu"
+#define INDEX_FILE "test_datrie_dictionary.dat"
+
+// 相互重叠、互为后缀或重复的单词（排在随机单词之前，序号更小）
+static const char* overlap_words[] = {
+    "hers", "she", "he", "his", "ushers", "s", "sh", "hersh", "rs", "he", "aaa", "aa", "a",
+    "sass", "ass", "usa", "eeeeeeeeee",
+};
+#define OVERLAP_WORDS ((int)(sizeof(overlap_words) / sizeof(overlap_words[0])))
+
+static int failures = 0;
+
+// ---------- 参考实现 ----------
+
+// 参考实现：按内容排序的去重单词，同一内容保留序号最小者
+static const DictWord* sort_words = NULL;
+
+static int compare_text(const char* text, int length, const DictWord* w) {
+    int common = length < w->length ? length : w->length;
+    int cmp = memcmp(text, w->text, (size_t)common);
+    return cmp != 0 ? cmp : length - w->length;
+}
+
+static int compare_words(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    int cmp = compare_text(sort_words[x].text, sort_words[x].length, &sort_words[y]);
+    return cmp != 0 ? cmp : x - y;
+}
+
+// 查找内容为 text[0, length) 的单词，返回最小序号（不存在返回 -1）
+static int find_word(const DictWord* words, const int* sorted, int count, const char* text, int length) {
+    int lo = 0;
+    int hi = count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (compare_text(text, length, &words[sorted[mid]]) > 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < count && compare_text(text, length, &words[sorted[lo]]) == 0 ? sorted[lo] : -1;
+}
+
+// 逐位置检查上次匹配之后、以当前字母结尾的每个后缀，取字典序号最小的单词（匹配不重叠）
+static void reference_counts(const DictWord* words, int count, const char* stream, int length,
+                             long long* counts) {
+    int* sorted = (int*)malloc((size_t)count * sizeof(int));
+    if (sorted == NULL) {
+        failures++;
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        sorted[i] = i;
+    }
+    sort_words = words;
+    qsort(sorted, (size_t)count, sizeof(int), compare_words);
+    sort_words = NULL;
+
+    int start = 0;
+    for (int i = 0; i < length; i++) {
+        int best = -1;
+        for (int k = 1; k <= DATRIE_TEST_WINDOW && k <= i + 1 - start; k++) {
+            int word = find_word(words, sorted, count, stream + i + 1 - k, k);
+            if (word >= 0 && (best < 0 || word < best)) {
+                best = word;
+            }
+        }
+        if (best >= 0) {
+            counts[best]++;
+            start = i + 1;
+        }
+    }
+    free(sorted);
+}
+
+// ---------- 匹配器 ----------
+
+// 用匹配器处理字母流，统计各单词的匹配次数
+static void matcher_counts(MatcherState* ms, const char* stream, int length, long long* counts) {
+    for (int i = 0; i < length; i++) {
+        int word = matcher_process_letter(ms, stream[i]);
+        if (word >= 0) {
+            counts[word]++;
+        }
+    }
+}
+
+// 初始化匹配器并与参考计数比较；expect_mapped 为 1 时要求索引来自文件，为 0 时要求重新构建
+static void check_matcher(const char* name, const DictWord* words, int count, uint64_t source,
+                          int expect_mapped, const char* stream, const long long* expected) {
+    MatcherState* ms = matcher_init(words, count, DATRIE_TEST_WINDOW, 0, INDEX_FILE, source);
+    if (ms == NULL || ms->trie == NULL) {
+        printf("  %-32s 失败（未使用 Trie）\n", name);
+        failures++;
+        matcher_free(ms);
+        return;
+    }
+
+    int ok = 1;
+#ifndef _WIN32
+    // Windows 下索引文件读入内存，无法区分映射与重建
+    int mapped = ms->trie->mapped != NULL;
+    if (mapped != expect_mapped) {
+        printf("  %-32s 失败（期望%s，实际%s）\n", name, expect_mapped ? "映射索引" : "重建",
+               mapped ? "映射索引" : "重建");
+        ok = 0;
+    }
+#else
+    (void)expect_mapped;
+#endif
+
+    long long* counts = (long long*)calloc((size_t)count, sizeof(long long));
+    if (counts == NULL) {
+        failures++;
+        matcher_free(ms);
+        return;
+    }
+    matcher_counts(ms, stream, DATRIE_TEST_LETTERS, counts);
+
+    long long total = 0;
+    int mismatches = 0;
+    for (int i = 0; i < count; i++) {
+        total += counts[i];
+        if (counts[i] != expected[i]) {
+            if (mismatches < 5) {
+                printf("    单词 %d \"%.*s\"：%lld 次，参考 %lld 次\n", i, words[i].length, words[i].text,
+                       counts[i], expected[i]);
+            }
+            mismatches++;
+        }
+    }
+    if (mismatches > 0) {
+        ok = 0;
+    }
+    printf("  %-32s %lld 次匹配，%d 个单词不一致  %s\n", name, total, mismatches, ok ? "通过" : "失败");
+    if (!ok) {
+        failures++;
+    }
+
+    free(counts);
+    matcher_free(ms);
+}
+
+// ---------- 测试 ----------
+
+int main() {
+    RandomGenerator* rg = random_generator_init();
+    int count = OVERLAP_WORDS + DATRIE_TEST_WORDS;
+    DictWord* words = (DictWord*)malloc((size_t)count * sizeof(DictWord));
+    char* text = (char*)malloc((size_t)DATRIE_TEST_WORDS * DATRIE_TEST_MAX_LENGTH);
+    char* stream = (char*)malloc(DATRIE_TEST_LETTERS);
+    long long* expected = (long long*)calloc((size_t)count, sizeof(long long));
+    if (rg == NULL || words == NULL || text == NULL || stream == NULL || expected == NULL) {
+        fprintf(stderr, "错误: 内存不足\n");
+        return 1;
+    }
+    random_generator_seed(rg, DATRIE_TEST_SEED);
+
+    // 1. 字典：重叠单词在前，随机单词在后（小字母表，大量公共前缀与后缀）
+    int letter_count = (int)strlen(DATRIE_TEST_LETTERS_SET);
+    for (int i = 0; i < OVERLAP_WORDS; i++) {
+        words[i].text = overlap_words[i];
+        words[i].length = (int)strlen(overlap_words[i]);
+    }
+    for (int i = 0; i < DATRIE_TEST_WORDS; i++) {
+        char* word = text + (size_t)i * DATRIE_TEST_MAX_LENGTH;
+        int length = 2 + (int)random_bounded(rg, DATRIE_TEST_MAX_LENGTH - 1);
+        for (int k = 0; k < length; k++) {
+            word[k] = DATRIE_TEST_LETTERS_SET[random_bounded(rg, (uint32_t)letter_count)];
+        }
+        words[OVERLAP_WORDS + i].text = word;
+        words[OVERLAP_WORDS + i].length = length;
+    }
+
+    // 2. 字母流（含字典中没有的字母，检验回到根的转移）
+    for (int i = 0; i < DATRIE_TEST_LETTERS; i++) {
+        if (random_bounded(rg, 16) == 0) {
+            stream[i] = 'z';
+        } else {
+            stream[i] = DATRIE_TEST_LETTERS_SET[random_bounded(rg, (uint32_t)letter_count)];
+        }
+    }
+    reference_counts(words, count, stream, DATRIE_TEST_LETTERS, expected);
+
+    printf("双数组 Trie 测试：种子 %u，%d 个单词，%d 个字母\n\n", DATRIE_TEST_SEED, count, DATRIE_TEST_LETTERS);
+
+    // 3. 构建并保存，按来源标识映射，来源变化但内容相同时按指纹映射
+    remove(INDEX_FILE);
+    check_matcher("构建并保存", words, count, DATRIE_TEST_SOURCE, 0, stream, expected);
+    check_matcher("按来源标识映射", words, count, DATRIE_TEST_SOURCE, 1, stream, expected);
+    check_matcher("来源变化、按内容指纹映射", words, count, DATRIE_TEST_SOURCE + 1, 1, stream, expected);
+    check_matcher("未知来源、按内容指纹映射", words, count, 0, 1, stream, expected);
+
+    // 4. 内容变化（来源标识也变化）时必须重建
+    words[OVERLAP_WORDS].length = 1;
+    memset(expected, 0, (size_t)count * sizeof(long long));
+    reference_counts(words, count, stream, DATRIE_TEST_LETTERS, expected);
+    check_matcher("内容变化、重建", words, count, DATRIE_TEST_SOURCE + 2, 0, stream, expected);
+    check_matcher("重建后按来源标识映射", words, count, DATRIE_TEST_SOURCE + 2, 1, stream, expected);
+
+    remove(INDEX_FILE);
+    free(expected);
+    free(stream);
+    free(text);
+    free(words);
+    random_generator_free(rg);
+
+    printf("\n%s（%d 项失败）\n", failures == 0 ? "全部通过" : "存在失败", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,811 @@
+// 随机数与抽卡公平性测试
+//   对字母生成、批量/单次/不重复抽卡与原始 32 位输出做卡方、KS 与序列相关检验，
+//   任一统计量超出容差时返回非零（由 CTest 运行）
+
+#include "random.h"
+#include "gacha.h"
+#include "list.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+// 默认配置
+#define FAIRNESS_SAMPLES 100000000LL    // 每项检验的样本数（环境变量 GACHA_FAIRNESS_SAMPLES 可覆盖）
+#define FAIRNESS_SEED 20240601u         // 基础种子（环境变量 GACHA_FAIRNESS_SEED 可覆盖）
+#define FAIRNESS_MAX_THREADS 8
+#define FAIRNESS_Z_LIMIT 5.0            // 卡方（正态近似）与相关系数的 z 值容差
+#define FAIRNESS_KS_LIMIT 2.5           // KS 统计量 D * sqrt(n) 的容差
+#define FAIRNESS_BLOCK 65536            // 批量生成块大小
+#define KS_BINS 65536                   // 原始输出 KS 检验的分箱数（取高 16 位）
+#define SINGLE_DRAW_SAMPLES 1000000     // 单次抽卡接口的样本数
+#define UNIQUE_TRIALS 200000            // 不重复抽取的轮数
+#define UNIQUE_DRAWS 10                 // 每轮不重复抽取的条目数
+#define LIST_FILE "test_fairness_gachalist.txt"
+
+static long long sample_count = FAIRNESS_SAMPLES;
+static unsigned int base_seed = FAIRNESS_SEED;
+static int failures = 0;
+
+// ---------- 统计工具 ----------
+
+// 卡方统计量的 Wilson-Hilferty 正态近似 z 值
+static double chi2_z(double chi2, int df) {
+    double k = (double)df;
+    double v = 2.0 / (9.0 * k);
+    return (cbrt(chi2 / k) - (1.0 - v)) / sqrt(v);
+}
+
+// 等概率卡方统计量
+static double chi2_uniform(const long long* counts, int bins, long long total) {
+    double expected = (double)total / bins;
+    double chi2 = 0.0;
+    for (int i = 0; i < bins; i++) {
+        double d = (double)counts[i] - expected;
+        chi2 += d * d / expected;
+    }
+    return chi2;
+}
+
+// 滞后 1 相关系数的 z 值（sqrt(n) * r）
+static double serial_z(double sum, double sum_sq, double sum_lag, long long n) {
+    double mean = sum / (double)n;
+    double var = sum_sq / (double)n - mean * mean;
+    if (var <= 0.0) {
+        return 0.0;
+    }
+    double r = (sum_lag / (double)(n - 1) - mean * mean) / var;
+    return r * sqrt((double)n);
+}
+
+// 记录检验结果
+static void report(const char* name, const char* statistic, double value, double limit) {
+    int ok = fabs(value) <= limit;
+    printf("  %-28s %-10s = %9.4f  (容差 %.1f)  %s\n", name, statistic, value, limit,
+           ok ? "通过" : "失败");
+    if (!ok) {
+        failures++;
+    }
+}
+
+// ---------- 多线程累加 ----------
+
+typedef void (*WorkerFunc)(void* task);
+
+typedef struct {
+    WorkerFunc func;
+    void* task;
+} WorkerStart;
+
+#ifdef _WIN32
+static DWORD WINAPI worker_main(LPVOID arg) {
+    WorkerStart* start = (WorkerStart*)arg;
+    start->func(start->task);
+    return 0;
+}
+#else
+static void* worker_main(void* arg) {
+    WorkerStart* start = (WorkerStart*)arg;
+    start->func(start->task);
+    return NULL;
+}
+#endif
+
+static int cpu_count() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int n = (int)info.dwNumberOfProcessors;
+#else
+    int n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (n < 1) {
+        n = 1;
+    }
+    return n < FAIRNESS_MAX_THREADS ? n : FAIRNESS_MAX_THREADS;
+}
+
+// 每个线程处理一个任务（tasks 为 count 个大小为 task_size 的任务）
+static void run_parallel(WorkerFunc func, void* tasks, size_t task_size, int count) {
+    WorkerStart starts[FAIRNESS_MAX_THREADS];
+#ifdef _WIN32
+    HANDLE threads[FAIRNESS_MAX_THREADS];
+#else
+    pthread_t threads[FAIRNESS_MAX_THREADS];
+#endif
+    int started[FAIRNESS_MAX_THREADS];
+
+    for (int t = 0; t < count; t++) {
+        starts[t].func = func;
+        starts[t].task = (char*)tasks + (size_t)t * task_size;
+#ifdef _WIN32
+        threads[t] = CreateThread(NULL, 0, worker_main, &starts[t], 0, NULL);
+        started[t] = threads[t] != NULL;
+#else
+        started[t] = pthread_create(&threads[t], NULL, worker_main, &starts[t]) == 0;
+#endif
+        // 创建线程失败时在当前线程执行
+        if (!started[t]) {
+            func(starts[t].task);
+        }
+    }
+
+    for (int t = 0; t < count; t++) {
+        if (started[t]) {
+#ifdef _WIN32
+            WaitForSingleObject(threads[t], INFINITE);
+            CloseHandle(threads[t]);
+#else
+            pthread_join(threads[t], NULL);
+#endif
+        }
+    }
+}
+
+// 第 t 个线程的样本数
+static long long share(long long total, int threads, int t) {
+    return total / threads + (t < total % threads ? 1 : 0);
+}
+
+// ---------- 字母生成 ----------
+
+typedef struct {
+    unsigned int seed;
+    long long samples;
+    long long counts[CHARSET_SIZE];
+    long long pairs[CHARSET_SIZE * CHARSET_SIZE];
+    double sum, sum_sq, sum_lag;
+} LetterTask;
+
+static void letter_worker(void* arg) {
+    LetterTask* task = (LetterTask*)arg;
+    RandomGenerator* rg = random_generator_init();
+    if (rg == NULL) {
+        return;
+    }
+    random_generator_seed(rg, task->seed);
+
+    // 字母到序号的映射
+    int index_of[256];
+    for (int c = 0; c < 256; c++) {
+        index_of[c] = -1;
+    }
+    for (int i = 0; i < CHARSET_SIZE; i++) {
+        index_of[(unsigned char)CHARSET[i]] = i;
+    }
+
+    long long sum = 0, sum_sq = 0, sum_lag = 0;
+    int prev = index_of[(unsigned char)generate_random_letter(rg)];
+    task->counts[prev]++;
+    sum += prev;
+    sum_sq += (long long)prev * prev;
+
+    for (long long n = 1; n < task->samples; n++) {
+        int x = index_of[(unsigned char)generate_random_letter(rg)];
+        if (x < 0) {
+            // 字符集之外的字母：记入一个不可能满足的计数使检验失败
+            task->counts[0] += task->samples;
+            break;
+        }
+        task->counts[x]++;
+        task->pairs[prev * CHARSET_SIZE + x]++;
+        sum += x;
+        sum_sq += (long long)x * x;
+        sum_lag += (long long)prev * x;
+        prev = x;
+    }
+
+    task->sum = (double)sum;
+    task->sum_sq = (double)sum_sq;
+    task->sum_lag = (double)sum_lag;
+    random_generator_free(rg);
+}
+
+static void test_letters(int threads) {
+    LetterTask* tasks = (LetterTask*)calloc((size_t)threads, sizeof(LetterTask));
+    if (tasks == NULL) {
+        failures++;
+        return;
+    }
+    for (int t = 0; t < threads; t++) {
+        tasks[t].seed = base_seed + 1000u + (unsigned int)t;
+        tasks[t].samples = share(sample_count, threads, t);
+    }
+    run_parallel(letter_worker, tasks, sizeof(LetterTask), threads);
+
+    long long counts[CHARSET_SIZE] = { 0 };
+    long long* pairs = (long long*)calloc(CHARSET_SIZE * CHARSET_SIZE, sizeof(long long));
+    long long pair_total = 0;
+    double sum = 0.0, sum_sq = 0.0, sum_lag = 0.0;
+    for (int t = 0; t < threads && pairs != NULL; t++) {
+        for (int i = 0; i < CHARSET_SIZE; i++) {
+            counts[i] += tasks[t].counts[i];
+        }
+        for (int i = 0; i < CHARSET_SIZE * CHARSET_SIZE; i++) {
+            pairs[i] += tasks[t].pairs[i];
+        }
+        pair_total += tasks[t].samples - 1;
+        sum += tasks[t].sum;
+        sum_sq += tasks[t].sum_sq;
+        sum_lag += tasks[t].sum_lag;
+    }
+    if (pairs == NULL) {
+        free(tasks);
+        failures++;
+        return;
+    }
+
+    printf("generate_random_letter（%lld 个样本）\n", sample_count);
+
+    double chi1 = chi2_uniform(counts, CHARSET_SIZE, sample_count);
+    report("字母频率卡方", "z", chi2_z(chi1, CHARSET_SIZE - 1), FAIRNESS_Z_LIMIT);
+
+    // Good 序列检验：重叠相邻对的卡方减去单字母卡方，自由度 k(k-1)
+    double chi2 = chi2_uniform(pairs, CHARSET_SIZE * CHARSET_SIZE, pair_total);
+    report("相邻字母对序列检验", "z", chi2_z(chi2 - chi1, CHARSET_SIZE * (CHARSET_SIZE - 1)),
+           FAIRNESS_Z_LIMIT);
+
+    // 各线程首个样本没有前驱，相关系数按全部样本近似
+    report("滞后 1 序列相关", "sqrt(n)r", serial_z(sum, sum_sq, sum_lag, sample_count - threads + 1),
+           FAIRNESS_Z_LIMIT);
+
+    free(pairs);
+    free(tasks);
+}
+
+// ---------- 批量抽卡 ----------
+
+typedef struct {
+    unsigned int seed;
+    long long samples;
+    long long* item_counts;             // 各条目抽中次数
+    long long rank_counts[RANK_COUNT];  // 直方图内核统计的等级次数
+    long long rank_recount[RANK_COUNT]; // 按序号重新统计的等级次数
+    double sum, sum_sq, sum_lag;
+    int ok;
+    int counters_ok;                    // 条目计数与按序号统计一致
+} DrawTask;
+
+static void draw_worker(void* arg) {
+    DrawTask* task = (DrawTask*)arg;
+    task->ok = 0;
+
+    GachaState* state = gacha_init(LIST_FILE, 0);
+    uint32_t* indices = (uint32_t*)malloc(FAIRNESS_BLOCK * sizeof(uint32_t));
+    if (state == NULL || indices == NULL) {
+        gacha_free(state);
+        free(indices);
+        return;
+    }
+    random_generator_seed(state->rng, task->seed);
+
+    long long prev = -1;
+    for (long long done = 0; done < task->samples; ) {
+        int block = task->samples - done < FAIRNESS_BLOCK ? (int)(task->samples - done) : FAIRNESS_BLOCK;
+
+        state->balance = block;
+        memset(state->rank_counts, 0, sizeof(state->rank_counts));
+        if (gacha_draw_batch(state, block, indices) != block) {
+            break;
+        }
+
+        for (int i = 0; i < block; i++) {
+            long long x = indices[i];
+            task->item_counts[x]++;
+            task->rank_recount[state->list->items[x].rank_index]++;
+            task->sum += (double)x;
+            task->sum_sq += (double)(x * x);
+            if (prev >= 0) {
+                task->sum_lag += (double)(prev * x);
+            }
+            prev = x;
+        }
+        for (int k = 0; k < RANK_COUNT; k++) {
+            task->rank_counts[k] += state->rank_counts[k];
+        }
+        done += block;
+        if (done == task->samples) {
+            task->ok = 1;
+        }
+    }
+
+    task->counters_ok = 1;
+    for (int i = 0; i < state->list->size; i++) {
+        if (gacha_item_count(state, i) != task->item_counts[i]) {
+            task->counters_ok = 0;
+        }
+    }
+
+    free(indices);
+    gacha_free(state);
+}
+
+static void test_draws(int threads, const GachaList* list) {
+    int size = list->size;
+    DrawTask* tasks = (DrawTask*)calloc((size_t)threads, sizeof(DrawTask));
+    if (tasks == NULL) {
+        failures++;
+        return;
+    }
+    int ok = 1;
+    for (int t = 0; t < threads; t++) {
+        tasks[t].seed = base_seed + 2000u + (unsigned int)t;
+        tasks[t].samples = share(sample_count, threads, t);
+        tasks[t].item_counts = (long long*)calloc((size_t)size, sizeof(long long));
+        ok = ok && tasks[t].item_counts != NULL;
+    }
+    if (ok) {
+        run_parallel(draw_worker, tasks, sizeof(DrawTask), threads);
+    }
+
+    long long* items = (long long*)calloc((size_t)size, sizeof(long long));
+    long long ranks[RANK_COUNT] = { 0 };
+    long long recount[RANK_COUNT] = { 0 };
+    double sum = 0.0, sum_sq = 0.0, sum_lag = 0.0;
+    int counters_ok = 1;
+    ok = ok && items != NULL;
+    for (int t = 0; ok && t < threads; t++) {
+        ok = tasks[t].ok;
+        counters_ok = counters_ok && tasks[t].counters_ok;
+        for (int i = 0; i < size; i++) {
+            items[i] += tasks[t].item_counts[i];
+        }
+        for (int k = 0; k < RANK_COUNT; k++) {
+            ranks[k] += tasks[t].rank_counts[k];
+            recount[k] += tasks[t].rank_recount[k];
+        }
+        sum += tasks[t].sum;
+        sum_sq += tasks[t].sum_sq;
+        sum_lag += tasks[t].sum_lag;
+    }
+
+    printf("gacha_draw_batch（%lld 次抽取，%d 个条目）\n", sample_count, size);
+    if (!ok) {
+        printf("  无法完成批量抽取  失败\n");
+        failures++;
+    } else {
+        double chi = chi2_uniform(items, size, sample_count);
+        report("条目频率卡方", "z", chi2_z(chi, size - 1), FAIRNESS_Z_LIMIT);
+
+        // 离散 KS：经验分布与均匀分布在每个条目处的最大偏差
+        double d = 0.0;
+        long long cumulative = 0;
+        for (int i = 0; i < size; i++) {
+            cumulative += items[i];
+            double diff = fabs((double)cumulative / (double)sample_count - (double)(i + 1) / size);
+            if (diff > d) {
+                d = diff;
+            }
+        }
+        report("条目分布 KS", "sqrt(n)D", d * sqrt((double)sample_count), FAIRNESS_KS_LIMIT);
+
+        report("滞后 1 序列相关", "sqrt(n)r", serial_z(sum, sum_sq, sum_lag, sample_count - threads + 1),
+               FAIRNESS_Z_LIMIT);
+
+        // 加权抽样：等级频率应与各等级条目占比一致
+        long long weights[RANK_COUNT] = { 0 };
+        for (int i = 0; i < size; i++) {
+            weights[list->items[i].rank_index]++;
+        }
+        double rank_chi = 0.0;
+        int rank_df = -1;
+        int histogram_ok = 1;
+        for (int k = 0; k < RANK_COUNT; k++) {
+            histogram_ok = histogram_ok && ranks[k] == recount[k];
+            if (weights[k] == 0) {
+                histogram_ok = histogram_ok && ranks[k] == 0;
+                continue;
+            }
+            double expected = (double)sample_count * (double)weights[k] / size;
+            double diff = (double)ranks[k] - expected;
+            rank_chi += diff * diff / expected;
+            rank_df++;
+        }
+        report("等级（加权）频率卡方", "z", rank_df > 0 ? chi2_z(rank_chi, rank_df) : 0.0,
+               FAIRNESS_Z_LIMIT);
+        printf("  %-28s %s\n", "SIMD 等级直方图与逐条统计", histogram_ok ? "一致  通过" : "不一致  失败");
+        if (!histogram_ok) {
+            failures++;
+        }
+        printf("  %-28s %s\n", "条目计数与逐条统计", counters_ok ? "一致  通过" : "不一致  失败");
+        if (!counters_ok) {
+            failures++;
+        }
+    }
+
+    for (int t = 0; t < threads; t++) {
+        free(tasks[t].item_counts);
+    }
+    free(items);
+    free(tasks);
+}
+
+// ---------- 单次抽卡 ----------
+
+static void test_single_draw() {
+    GachaState* state = gacha_init(LIST_FILE, SINGLE_DRAW_SAMPLES);
+    printf("gacha_draw（%d 次抽取）\n", SINGLE_DRAW_SAMPLES);
+    if (state == NULL) {
+        printf("  无法初始化  失败\n");
+        failures++;
+        return;
+    }
+    random_generator_seed(state->rng, base_seed + 3000u);
+
+    // 结果只带菜名：按字符串池 id 统计，重复菜名的期望次数与其条目数成正比
+    int names = string_pool_size(state->list->names);
+    long long* counts = (long long*)calloc((size_t)names, sizeof(long long));
+    long long* weights = (long long*)calloc((size_t)names, sizeof(long long));
+    if (counts == NULL || weights == NULL) {
+        printf("  内存不足  失败\n");
+        failures++;
+        free(counts);
+        free(weights);
+        gacha_free(state);
+        return;
+    }
+    for (int i = 0; i < state->list->size; i++) {
+        weights[state->list->items[i].name_id]++;
+    }
+
+    int draws = 0;
+    for (int i = 0; i < SINGLE_DRAW_SAMPLES; i++) {
+        GachaResult result = gacha_draw(state);
+        if (result.name == NULL) {
+            break;
+        }
+        int id = string_pool_find(state->list->names, result.name, (int)strlen(result.name));
+        if (id < 0) {
+            break;
+        }
+        counts[id]++;
+        draws++;
+    }
+
+    if (draws != SINGLE_DRAW_SAMPLES) {
+        printf("  抽取结果异常  失败\n");
+        failures++;
+    } else {
+        double chi = 0.0;
+        int bins = 0;
+        for (int id = 0; id < names; id++) {
+            if (weights[id] == 0) {
+                continue;
+            }
+            double expected = (double)draws * (double)weights[id] / state->list->size;
+            double diff = (double)counts[id] - expected;
+            chi += diff * diff / expected;
+            bins++;
+        }
+        report("菜名频率卡方", "z", chi2_z(chi, bins - 1), FAIRNESS_Z_LIMIT);
+    }
+
+    free(counts);
+    free(weights);
+    gacha_free(state);
+}
+
+// ---------- 不重复抽取 ----------
+
+static void test_unique_draw() {
+    GachaState* state = gacha_init(LIST_FILE, UNIQUE_TRIALS * UNIQUE_DRAWS);
+    printf("gacha_draw_unique（%d 轮，每轮 %d 个）\n", UNIQUE_TRIALS, UNIQUE_DRAWS);
+    if (state == NULL) {
+        printf("  无法初始化  失败\n");
+        failures++;
+        return;
+    }
+    random_generator_seed(state->rng, base_seed + 5000u);
+
+    int n = state->list->size;
+    long long* included = (long long*)calloc((size_t)n, sizeof(long long));
+    long long* first = (long long*)calloc((size_t)n, sizeof(long long));
+    int* last_trial = (int*)malloc((size_t)n * sizeof(int));
+    if (included == NULL || first == NULL || last_trial == NULL) {
+        printf("  内存不足  失败\n");
+        failures++;
+        free(included);
+        free(first);
+        free(last_trial);
+        gacha_free(state);
+        return;
+    }
+    for (int i = 0; i < n; i++) {
+        last_trial[i] = -1;
+    }
+
+    // 每轮内不得重复；整体上每个条目被抽中的轮数、以及排在第一位的次数都应等概率
+    long long ranks[5] = { 0 };
+    int duplicates = 0;
+    int short_draws = 0;
+    uint32_t indices[UNIQUE_DRAWS];
+    for (int trial = 0; trial < UNIQUE_TRIALS; trial++) {
+        if (gacha_draw_unique(state, UNIQUE_DRAWS, indices) != UNIQUE_DRAWS) {
+            short_draws++;
+            continue;
+        }
+        for (int k = 0; k < UNIQUE_DRAWS; k++) {
+            if (last_trial[indices[k]] == trial) {
+                duplicates++;
+            }
+            last_trial[indices[k]] = trial;
+            included[indices[k]]++;
+            ranks[state->list->items[indices[k]].rank_index]++;
+        }
+        first[indices[0]]++;
+    }
+
+    int rank_mismatch = 0;
+    for (int r = 0; r < 5; r++) {
+        if (ranks[r] != state->rank_counts[r]) {
+            rank_mismatch = 1;
+        }
+    }
+
+    // 余额恰好用完，全部抽完后再抽返回 0；整个列表可以一次抽完
+    int exhausted = gacha_draw_unique(state, 1, indices) == 0 && state->balance == 0;
+    state->balance = n + 1;
+    uint32_t* all = (uint32_t*)malloc((size_t)n * sizeof(uint32_t));
+    int capped = all != NULL && gacha_draw_unique(state, n + 1, all) == n && state->balance == 1;
+    free(all);
+
+    if (short_draws > 0 || duplicates > 0 || !exhausted || !capped || rank_mismatch) {
+        printf("  抽取结果异常（不足 %d 轮，重复 %d 次，余额%s，条目数上限%s，等级计数%s）  失败\n",
+               short_draws, duplicates, exhausted ? "正常" : "异常", capped ? "正常" : "异常",
+               rank_mismatch ? "异常" : "正常");
+        failures++;
+    } else {
+        report("条目入选频率卡方", "z",
+               chi2_z(chi2_uniform(included, n, (long long)UNIQUE_TRIALS * UNIQUE_DRAWS), n - 1),
+               FAIRNESS_Z_LIMIT);
+        report("首位条目卡方", "z", chi2_z(chi2_uniform(first, n, UNIQUE_TRIALS), n - 1),
+               FAIRNESS_Z_LIMIT);
+    }
+
+    free(included);
+    free(first);
+    free(last_trial);
+    gacha_free(state);
+}
+
+// ---------- 原始 32 位输出 ----------
+
+typedef struct {
+    unsigned int seed;
+    int mode;
+    long long samples;
+    long long* bins;
+} RawTask;
+
+static void raw_worker(void* arg) {
+    RawTask* task = (RawTask*)arg;
+    RandomGenerator* rg = random_generator_init();
+    if (rg == NULL) {
+        return;
+    }
+    random_generator_seed(rg, task->seed);
+    if ((task->mode == RANDOM_MODE_SECURE && random_generator_secure(rg) != 0) ||
+        (task->mode == RANDOM_MODE_COUNTER && random_generator_counter(rg, task->seed) != 0)) {
+        random_generator_free(rg);
+        return;
+    }
+
+    for (long long n = 0; n < task->samples; n++) {
+        task->bins[random_next(rg) >> 16]++;
+    }
+    random_generator_free(rg);
+}
+
+// 各模式的名称后缀
+static const char* mode_suffix(int mode) {
+    return mode == RANDOM_MODE_SECURE ? " 安全模式" : (mode == RANDOM_MODE_COUNTER ? " 计数模式" : "");
+}
+
+static void test_raw(int threads, int mode) {
+    RawTask* tasks = (RawTask*)calloc((size_t)threads, sizeof(RawTask));
+    long long* bins = (long long*)calloc(KS_BINS, sizeof(long long));
+    int ok = tasks != NULL && bins != NULL;
+    for (int t = 0; ok && t < threads; t++) {
+        tasks[t].seed = base_seed + 4000u + (unsigned int)t;
+        tasks[t].mode = mode;
+        tasks[t].samples = share(sample_count, threads, t);
+        tasks[t].bins = (long long*)calloc(KS_BINS, sizeof(long long));
+        ok = tasks[t].bins != NULL;
+    }
+
+    printf("random_next%s（%lld 个样本，高 16 位分箱）\n", mode_suffix(mode), sample_count);
+    if (!ok) {
+        printf("  内存不足  失败\n");
+        failures++;
+    } else {
+        run_parallel(raw_worker, tasks, sizeof(RawTask), threads);
+        for (int t = 0; t < threads; t++) {
+            for (int i = 0; i < KS_BINS; i++) {
+                bins[i] += tasks[t].bins[i];
+            }
+        }
+
+        long long total = 0;
+        for (int i = 0; i < KS_BINS; i++) {
+            total += bins[i];
+        }
+        if (total != sample_count) {
+            printf("  无法初始化随机生成器  失败\n");
+            failures++;
+            total = 0;
+        }
+
+        // 均匀分布 KS：在各分箱边界处比较经验分布
+        double d = 0.0;
+        long long cumulative = 0;
+        for (int i = 0; i < KS_BINS; i++) {
+            cumulative += bins[i];
+            double diff = fabs((double)cumulative / (double)sample_count - (double)(i + 1) / KS_BINS);
+            if (diff > d) {
+                d = diff;
+            }
+        }
+        if (total == sample_count) {
+            report("均匀分布 KS", "sqrt(n)D", d * sqrt((double)sample_count), FAIRNESS_KS_LIMIT);
+            report("高 16 位分箱卡方", "z", chi2_z(chi2_uniform(bins, KS_BINS, sample_count), KS_BINS - 1),
+                   FAIRNESS_Z_LIMIT);
+        }
+    }
+
+    for (int t = 0; tasks != NULL && t < threads; t++) {
+        free(tasks[t].bins);
+    }
+    free(tasks);
+    free(bins);
+}
+
+// ---------- 安全模式 / 计数模式有界随机数 ----------
+
+// 上界取 3 * 2^30：乘法映射有 25% 的拒绝率，可检验拒绝重抽是否无偏
+static void test_bounded(int mode) {
+    const uint32_t bound = 3u << 30;
+    const int bins_count = (int)(bound >> 24);
+    long long samples = sample_count / 10;
+    long long* bins = (long long*)calloc((size_t)bins_count, sizeof(long long));
+    uint32_t* block = (uint32_t*)malloc(FAIRNESS_BLOCK * sizeof(uint32_t));
+    RandomGenerator* rg = random_generator_init();
+
+    printf("random_fill_bounded%s（%lld 个样本，上界 3·2^30，%d 个等宽分箱）\n",
+           mode_suffix(mode), samples, bins_count);
+    int ready = rg != NULL && (mode == RANDOM_MODE_SECURE ? random_generator_secure(rg)
+                                                          : random_generator_counter(rg, base_seed + 6000u)) == 0;
+    if (bins == NULL || block == NULL || !ready) {
+        printf("  无法初始化随机生成器  失败\n");
+        failures++;
+    } else {
+        int in_range = 1;
+        for (long long done = 0; done < samples; done += FAIRNESS_BLOCK) {
+            size_t n = samples - done < FAIRNESS_BLOCK ? (size_t)(samples - done) : FAIRNESS_BLOCK;
+            random_fill_bounded(rg, bound, block, n);
+            for (size_t i = 0; i < n; i++) {
+                if (block[i] < bound) {
+                    bins[block[i] >> 24]++;
+                } else {
+                    in_range = 0;
+                }
+            }
+        }
+        report("结果都在上界内", "ok", in_range ? 0.0 : 1.0, 0.5);
+        report("等宽分箱卡方", "z", chi2_z(chi2_uniform(bins, bins_count, samples), bins_count - 1),
+               FAIRNESS_Z_LIMIT);
+    }
+
+    random_generator_free(rg);
+    free(block);
+    free(bins);
+}
+
+// ---------- 计数模式可复现性 ----------
+
+// 序号 i 的结果只取决于 (种子, i)：任意起点的 random_fill_bounded_at 与逐个 random_bounded 相同，
+//   批量抽取在不同线程数下逐位相同
+static void test_counter_parallel() {
+    const uint32_t bound = 3u << 30;
+    const int draws = GACHA_PARALLEL_MIN * 4 + 3;
+    uint32_t* expected = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)draws);
+    uint32_t* actual = (uint32_t*)malloc(sizeof(uint32_t) * (size_t)draws);
+    RandomGenerator* rg = random_generator_init();
+
+    printf("计数模式可复现性（%d 次批量抽取，线程数 1 ~ %d）\n", draws, FAIRNESS_MAX_THREADS);
+    if (expected == NULL || actual == NULL || rg == NULL || random_generator_counter(rg, base_seed + 7000u) != 0) {
+        printf("  内存不足  失败\n");
+        failures++;
+        random_generator_free(rg);
+        free(expected);
+        free(actual);
+        return;
+    }
+
+    // 任意起点与长度的分段生成 == 逐个生成
+    for (int i = 0; i < 1000; i++) {
+        expected[i] = random_bounded(rg, bound);
+    }
+    int mismatches = 0;
+    for (int first = 0; first < 16; first++) {
+        random_fill_bounded_at(rg, (uint64_t)first, bound, actual, (size_t)(1000 - first));
+        for (int i = first; i < 1000; i++) {
+            mismatches += actual[i - first] != expected[i];
+        }
+    }
+    report("分段生成与逐个生成一致", "不同数", (double)mismatches, 0.5);
+
+    // 不同线程数的批量抽取逐位相同（基准为单线程）
+    mismatches = 0;
+    for (int threads = 1; threads <= FAIRNESS_MAX_THREADS; threads++) {
+        GachaState* state = gacha_init(LIST_FILE, draws);
+        if (state == NULL) {
+            mismatches++;
+            continue;
+        }
+        random_generator_counter(state->rng, base_seed + 8000u);
+        gacha_set_threads(state, threads);
+        int drawn = gacha_draw_batch(state, draws, threads == 1 ? expected : actual);
+        if (drawn != draws) {
+            mismatches++;
+        }
+        for (int i = 0; threads > 1 && i < drawn; i++) {
+            mismatches += actual[i] != expected[i];
+        }
+        gacha_free(state);
+    }
+    report("多线程批量抽取与单线程一致", "不同数", (double)mismatches, 0.5);
+
+    random_generator_free(rg);
+    free(expected);
+    free(actual);
+}
+
+int main() {
+    const char* env = getenv("GACHA_FAIRNESS_SAMPLES");
+    if (env != NULL && atoll(env) > 1000) {
+        sample_count = atoll(env);
+    }
+    env = getenv("GACHA_FAIRNESS_SEED");
+    if (env != NULL) {
+        base_seed = (unsigned int)strtoul(env, NULL, 10);
+    }
+
+    // 使用内置 600 道菜的 gachalist（各等级条目数不同，可检验加权抽样）
+    if (create_default_gachalist(LIST_FILE) != 0) {
+        fprintf(stderr, "错误: 无法创建测试 gachalist\n");
+        return 1;
+    }
+    GachaList* list = read_gachalist(LIST_FILE);
+    if (list == NULL || list->size == 0) {
+        fprintf(stderr, "错误: 无法读取测试 gachalist\n");
+        remove(LIST_FILE);
+        return 1;
+    }
+
+    int threads = cpu_count();
+    printf("公平性测试：种子 %u，%d 个线程\n\n", base_seed, threads);
+
+    test_letters(threads);
+    test_draws(threads, list);
+    test_single_draw();
+    test_unique_draw();
+    test_raw(threads, RANDOM_MODE_FAST);
+    test_raw(threads, RANDOM_MODE_SECURE);
+    test_raw(threads, RANDOM_MODE_COUNTER);
+    test_bounded(RANDOM_MODE_SECURE);
+    test_bounded(RANDOM_MODE_COUNTER);
+    test_counter_parallel();
+
+    free_gachalist(list);
+    remove(LIST_FILE);
+
+    printf("\n%s（%d 项失败）\n", failures == 0 ? "全部通过" : "存在失败", failures);
+    return failures == 0 ? 0 : 1;
+}